@@ -0,0 +1,668 @@
+#include <stdio.h>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <sstream>
+#include "PKShaderWriter.h"
+#include "PKMeshWriter.h"
+#include "PKFontWriter.h"
+#include "PKTextureWriter.h"
+#include "PKJobScheduler.h"
+#include "PKFileWatcher.h"
+#include "PKFileVersionUtilities.h"
+#include "PKCookCache.h"
+#include "PKLogUtilities.h"
+#include "PKProfiler.h"
+#include "PKAssetCooker.h"
+#include "PKCookCostModel.h"
+#include "PKWorkerProcess.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace PKAssets::Cooker
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct WorkerPool
+    {
+        std::vector<std::string> arguments;
+        std::vector<WorkerProcess*> idle;
+        std::mutex lock;
+        bool isEnabled = false;
+    };
+
+    static WorkerPool s_workers;
+
+    static double GetSecondsSince(const Clock::time_point& start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static double GetThreadCpuTime()
+    {
+#ifdef _WIN32
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+
+        if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+        {
+            return 0.0;
+        }
+
+        auto kernel = ((uint64_t)kernelTime.dwHighDateTime << 32ull) | kernelTime.dwLowDateTime;
+        auto user = ((uint64_t)userTime.dwHighDateTime << 32ull) | userTime.dwLowDateTime;
+        return (double)(kernel + user) * 1e-7;
+#else
+        timespec time{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+    }
+
+    static void WriteFileStatus(const int32_t status, const char* path, const size_t stemOffset)
+    {
+        switch (status)
+        {
+            case -1: LogUtilities::Printf("Failed to asset: %s \n", path + stemOffset); break;
+            case 1: LogUtilities::Printf("Asset was up to date: %s \n", path + stemOffset); break;
+        }
+    }
+
+    static PKAssetType GetSourceAssetType(const std::filesystem::path& extension, const char** outDstExtension)
+    {
+        if (extension.compare(Shader::PK_ASSET_SHADER_SRC_EXTENSION) == 0)
+        {
+            *outDstExtension = PK_ASSET_EXTENSION_SHADER;
+            return PKAssetType::Shader;
+        }
+
+        if (extension.compare(Mesh::PK_ASSET_MESH_SRC_EXTENSION) == 0)
+        {
+            *outDstExtension = PK_ASSET_EXTENSION_MESH;
+            return PKAssetType::Mesh;
+        }
+
+        if (extension.compare(Font::PK_ASSET_FONT_SRC_EXTENSION) == 0)
+        {
+            *outDstExtension = PK_ASSET_EXTENSION_FONT;
+            return PKAssetType::Font;
+        }
+
+        if (extension.compare(Texture::PK_ASSET_TEXTURE_SRC_EXTENSION) == 0)
+        {
+            *outDstExtension = PK_ASSET_EXTENSION_TEXTURE;
+            return PKAssetType::Texture;
+        }
+
+        *outDstExtension = nullptr;
+        return PKAssetType::Invalid;
+    }
+
+    bool CreateCookJob(const std::string& basedir, const std::filesystem::path& pathSrc, const std::string& dstdir, CookJob& outJob)
+    {
+        if (!pathSrc.has_extension())
+        {
+            return false;
+        }
+
+        const char* dstExtension = nullptr;
+        auto type = GetSourceAssetType(pathSrc.extension(), &dstExtension);
+
+        if (type == PKAssetType::Invalid)
+        {
+            return false;
+        }
+
+        auto relativePath = pathSrc.lexically_normal().lexically_relative(std::filesystem::path(basedir).lexically_normal());
+        auto dstpath = std::filesystem::path(dstdir + relativePath.string());
+
+        outJob = CookJob();
+        outJob.type = type;
+        outJob.pathSrc = pathSrc.string();
+        outJob.pathDst = dstpath.replace_extension(dstExtension).string();
+        outJob.pathStemOffset = dstdir.length();
+        return true;
+    }
+
+    void GatherCookJobs(const PKVersionUtilities::DirectorySnapshot& snapshot, const std::string& srcdir, const std::string& dstdir, std::vector<CookJob>& outJobs)
+    {
+        for (const auto& kv : snapshot.entries)
+        {
+            CookJob job;
+
+            if (CreateCookJob(srcdir, snapshot.root / kv.first, dstdir, job))
+            {
+                outJobs.push_back(job);
+            }
+        }
+
+        // Snapshot order is arbitrary. Keep cook order & logs deterministic.
+        std::sort(outJobs.begin(), outJobs.end(), [](const CookJob& a, const CookJob& b) { return a.pathSrc < b.pathSrc; });
+    }
+
+    int32_t ExecuteCookJob(CookJob& job)
+    {
+        auto start = Clock::now();
+        auto cpuStart = GetThreadCpuTime();
+        auto pathSrc = job.pathSrc.c_str();
+        auto pathDst = job.pathDst.c_str();
+        Profiler::BeginAsset(pathDst + job.pathStemOffset);
+
+        switch (job.type)
+        {
+            case PKAssetType::Shader: job.status = Shader::WriteShader(pathSrc, pathDst, job.pathStemOffset); break;
+            case PKAssetType::Mesh: job.status = Mesh::WriteMesh(pathSrc, pathDst, job.pathStemOffset); break;
+            case PKAssetType::Font: job.status = Font::WriteFont(pathSrc, pathDst, job.pathStemOffset); break;
+            case PKAssetType::Texture: job.status = Texture::WriteTexture(pathSrc, pathDst, job.pathStemOffset); break;
+            default: job.status = -1; break;
+        }
+
+        Profiler::EndAsset();
+        WriteFileStatus(job.status, pathDst, job.pathStemOffset);
+        job.duration = GetSecondsSince(start);
+        job.cpuTime = GetThreadCpuTime() - cpuStart;
+        return job.status;
+    }
+
+    void StartWorkerProcesses(const std::vector<std::string>& arguments, uint32_t count)
+    {
+        std::lock_guard<std::mutex> lock(s_workers.lock);
+        s_workers.arguments = arguments;
+        s_workers.isEnabled = true;
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            auto worker = StartWorkerProcess(arguments);
+
+            if (worker == nullptr)
+            {
+                printf("Failed to start worker process: %s \n", arguments.at(0).c_str());
+                break;
+            }
+
+            s_workers.idle.push_back(worker);
+        }
+    }
+
+    void StopWorkerProcesses()
+    {
+        std::lock_guard<std::mutex> lock(s_workers.lock);
+
+        for (auto worker : s_workers.idle)
+        {
+            StopWorkerProcess(worker);
+        }
+
+        s_workers.idle.clear();
+        s_workers.isEnabled = false;
+    }
+
+    int32_t ExecuteCookJobInWorker(CookJob& job)
+    {
+        auto start = Clock::now();
+        WorkerProcess* worker = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(s_workers.lock);
+
+            if (!s_workers.idle.empty())
+            {
+                worker = s_workers.idle.back();
+                s_workers.idle.pop_back();
+            }
+        }
+
+        if (worker == nullptr)
+        {
+            worker = StartWorkerProcess(s_workers.arguments);
+        }
+
+        if (worker == nullptr)
+        {
+            LogUtilities::Printf("Failed to start worker process: %s \n", s_workers.arguments.at(0).c_str());
+            job.status = -1;
+            WriteFileStatus(job.status, job.pathDst.c_str(), job.pathStemOffset);
+            job.duration = GetSecondsSince(start);
+            return job.status;
+        }
+
+        std::ostringstream request;
+        request << (uint32_t)job.type << '\t' << job.pathStemOffset << '\t' << (job.isStale ? 1u : 0u) << '\t' << job.pathSrc << '\t' << job.pathDst;
+        std::string response;
+        auto profileStart = Profiler::GetTime();
+
+        if (!WriteWorkerMessage(worker, request.str()) || !ReadWorkerMessage(worker, response))
+        {
+            // The output of a crashed worker is lost. Replace it so that the pool stays warm for the remaining jobs.
+            auto exitStatus = StopWorkerProcess(worker);
+            LogUtilities::Printf("Worker process exited (%s) while cooking: %s \n", exitStatus.c_str(), job.pathSrc.c_str());
+            job.status = -1;
+            WriteFileStatus(job.status, job.pathDst.c_str(), job.pathStemOffset);
+            job.duration = GetSecondsSince(start);
+
+            worker = StartWorkerProcess(s_workers.arguments);
+
+            if (worker != nullptr)
+            {
+                std::lock_guard<std::mutex> lock(s_workers.lock);
+                s_workers.idle.push_back(worker);
+            }
+
+            return job.status;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_workers.lock);
+            s_workers.idle.push_back(worker);
+        }
+
+        // Response: status, cpu time, input hash, include graph & profile event line counts, a line of cache lookups & entries
+        // followed by the include graph, the profile events & the job log.
+        std::istringstream stream(response);
+        std::string line;
+        auto isRecorded = 0u;
+        auto inputHash = 0ull;
+        auto lineCount = 0u;
+        auto eventCount = 0u;
+        auto entryCount = 0u;
+        CookCache::CacheCapture cacheCapture;
+        auto& cacheStatistics = cacheCapture.statistics;
+        job.status = -1;
+        stream >> job.status >> job.cpuTime >> isRecorded >> inputHash >> lineCount >> eventCount;
+        stream >> cacheStatistics.hitCount >> cacheStatistics.missCount >> cacheStatistics.storeCount >> cacheStatistics.restoredBytes >> cacheStatistics.restoreTime >> cacheStatistics.savedTime >> entryCount;
+
+        for (auto i = 0u; i < entryCount && stream; ++i)
+        {
+            std::pair<uint64_t, uint64_t> entry;
+            stream >> entry.first >> entry.second;
+            cacheCapture.entries.push_back(entry);
+        }
+
+        std::getline(stream, line);
+
+        std::map<std::string, std::vector<std::string>> includeGraph;
+
+        for (auto i = 0u; i < lineCount && std::getline(stream, line); ++i)
+        {
+            std::istringstream lineStream(line);
+            std::string path;
+            std::getline(lineStream, path, '\t');
+            auto& includes = includeGraph[path];
+
+            while (std::getline(lineStream, path, '\t'))
+            {
+                includes.push_back(path);
+            }
+        }
+
+        std::string events;
+
+        for (auto i = 0u; i < eventCount && std::getline(stream, line); ++i)
+        {
+            events += line + '\n';
+        }
+
+        CookCache::MergeCapture(cacheCapture);
+        Profiler::AddEvents(profileStart, events);
+
+        auto logOffset = stream.tellg();
+
+        if (logOffset >= 0 && (size_t)logOffset < response.size())
+        {
+            LogUtilities::Printf("%s", response.c_str() + (size_t)logOffset);
+        }
+
+        if (isRecorded != 0u)
+        {
+            PKVersionUtilities::RecordAsset(job.pathSrc, job.pathDst, includeGraph, inputHash);
+        }
+
+        job.duration = GetSecondsSince(start);
+        return job.status;
+    }
+
+    int RunCookWorker()
+    {
+        if (!OpenWorkerChannel())
+        {
+            return 1;
+        }
+
+        std::string request;
+
+        while (ReadChannelMessage(request))
+        {
+            std::istringstream requestStream(request);
+            std::string field;
+            CookJob job;
+            std::getline(requestStream, field, '\t');
+            job.type = (PKAssetType)strtoul(field.c_str(), nullptr, 10);
+            std::getline(requestStream, field, '\t');
+            job.pathStemOffset = (size_t)strtoull(field.c_str(), nullptr, 10);
+            std::getline(requestStream, field, '\t');
+            job.isStale = strtoul(field.c_str(), nullptr, 10) != 0u;
+            std::getline(requestStream, job.pathSrc, '\t');
+            std::getline(requestStream, job.pathDst, '\t');
+
+            // The main process may have observed changes since the previous job. Files are revalidated by their size & write time.
+            // The asset records of this process are not updated by other processes, so staleness is decided by the main process.
+            PKVersionUtilities::InvalidateAllFiles();
+
+            std::map<std::string, std::vector<std::string>> includeGraph;
+            uint64_t inputHash = 0ull;
+            CookCache::CacheCapture cacheCapture;
+            std::string events;
+            std::string log;
+            auto profileStart = Profiler::GetTime();
+            LogUtilities::BeginBuffer();
+            PKVersionUtilities::BeginRecordCapture(job.isStale);
+            CookCache::BeginCapture();
+            ExecuteCookJob(job);
+            CookCache::EndCapture(cacheCapture);
+            auto isRecorded = PKVersionUtilities::EndRecordCapture(includeGraph, &inputHash);
+            LogUtilities::EndBuffer(log);
+            Profiler::TakeEvents(profileStart, events);
+
+            const auto& cacheStatistics = cacheCapture.statistics;
+            std::ostringstream response;
+            response << job.status << ' ' << job.cpuTime << ' ' << (isRecorded ? 1u : 0u) << ' ' << inputHash << ' ' << includeGraph.size() << ' ' << std::count(events.begin(), events.end(), '\n') << '\n';
+            response << cacheStatistics.hitCount << ' ' << cacheStatistics.missCount << ' ' << cacheStatistics.storeCount << ' ' << cacheStatistics.restoredBytes << ' ' << cacheStatistics.restoreTime << ' ' << cacheStatistics.savedTime << ' ' << cacheCapture.entries.size();
+
+            for (const auto& entry : cacheCapture.entries)
+            {
+                response << ' ' << entry.first << ' ' << entry.second;
+            }
+
+            response << '\n';
+
+            for (const auto& kv : includeGraph)
+            {
+                response << kv.first;
+
+                for (const auto& include : kv.second)
+                {
+                    response << '\t' << include;
+                }
+
+                response << '\n';
+            }
+
+            response << events << log;
+
+            if (!WriteChannelMessage(response.str()))
+            {
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    CookStatistics ExecuteCookJobs(std::vector<CookJob>& jobs, JobScheduler* scheduler, uint64_t memoryBudget)
+    {
+        auto start = Clock::now();
+
+        CookStatistics statistics{};
+        statistics.threadCount = scheduler != nullptr ? scheduler->GetThreadCount() : 1u;
+
+        if (scheduler == nullptr)
+        {
+            for (auto& job : jobs)
+            {
+                ExecuteCookJob(job);
+                fflush(stdout);
+            }
+        }
+        else
+        {
+            // Up to date jobs are resolved up front so that only stale sources are scanned for cost estimates.
+            std::vector<uint8_t> isStale(jobs.size(), 0u);
+
+            for (auto i = 0ull; i < jobs.size(); ++i)
+            {
+                auto pJob = &jobs[i];
+                auto pIsStale = &isStale[i];
+                scheduler->Enqueue([pJob, pIsStale]()
+                {
+                    if (!PKVersionUtilities::IsAssetOutOfDate(pJob->pathSrc, pJob->pathDst))
+                    {
+                        pJob->status = 1;
+                        WriteFileStatus(pJob->status, pJob->pathDst.c_str(), pJob->pathStemOffset);
+                        return;
+                    }
+
+                    EstimateCookJob(*pJob);
+                    *pIsStale = 1u;
+                });
+            }
+
+            scheduler->Wait();
+
+            std::vector<CookJob*> pending;
+
+            for (auto i = 0ull; i < jobs.size(); ++i)
+            {
+                jobs[i].isStale = isStale[i] != 0u;
+
+                if (isStale[i])
+                {
+                    pending.push_back(&jobs[i]);
+                }
+            }
+
+            // Longest job first. Pending jobs are dispatched in order unless they dont fit into the remaining memory budget.
+            // A job is always admitted when nothing else is running so that jobs larger than the budget still run (alone).
+            std::sort(pending.begin(), pending.end(), [](const CookJob* a, const CookJob* b) { return a->estimatedCost > b->estimatedCost; });
+
+            std::mutex dispatchLock;
+            std::condition_variable dispatchSignal;
+            uint64_t memoryInUse = 0ull;
+            uint32_t runningCount = 0u;
+            auto isWorkerEnabled = false;
+
+            // Workers are started & stopped by the main thread. The flag is read once instead of from every job.
+            {
+                std::lock_guard<std::mutex> lock(s_workers.lock);
+                isWorkerEnabled = s_workers.isEnabled;
+            }
+
+            while (!pending.empty())
+            {
+                std::unique_lock<std::mutex> lock(dispatchLock);
+                auto next = pending.end();
+
+                dispatchSignal.wait(lock, [&]()
+                {
+                    if (runningCount >= statistics.threadCount)
+                    {
+                        return false;
+                    }
+
+                    next = std::find_if(pending.begin(), pending.end(), [&](const CookJob* job)
+                    {
+                        return runningCount == 0u || memoryBudget == 0ull || memoryInUse + job->estimatedMemory <= memoryBudget;
+                    });
+
+                    return next != pending.end();
+                });
+
+                auto pJob = *next;
+                pending.erase(next);
+                memoryInUse += pJob->estimatedMemory;
+                runningCount++;
+                statistics.estimatedCost += pJob->estimatedCost;
+                statistics.peakEstimatedMemory = std::max(statistics.peakEstimatedMemory, memoryInUse);
+                lock.unlock();
+
+                scheduler->Enqueue([pJob, isWorkerEnabled, &dispatchLock, &dispatchSignal, &memoryInUse, &runningCount]()
+                {
+                    LogUtilities::BeginBuffer();
+
+                    if (isWorkerEnabled)
+                    {
+                        ExecuteCookJobInWorker(*pJob);
+                    }
+                    else
+                    {
+                        ExecuteCookJob(*pJob);
+                    }
+
+                    LogUtilities::EndBuffer();
+
+                    {
+                        std::lock_guard<std::mutex> lock(dispatchLock);
+                        memoryInUse -= pJob->estimatedMemory;
+                        runningCount--;
+                    }
+
+                    dispatchSignal.notify_one();
+                });
+            }
+
+            scheduler->Wait();
+        }
+
+        for (const auto& job : jobs)
+        {
+            statistics.cookedCount += job.status == 0 ? 1u : 0u;
+            statistics.upToDateCount += job.status == 1 ? 1u : 0u;
+            statistics.failedCount += job.status < 0 ? 1u : 0u;
+            statistics.jobTime += job.duration;
+            statistics.cpuTime += job.cpuTime;
+        }
+
+        statistics.wallTime = GetSecondsSince(start);
+        return statistics;
+    }
+
+    void WriteCookStatistics(const CookStatistics& statistics)
+    {
+        auto parallelism = statistics.wallTime > 0.0 ? statistics.jobTime / statistics.wallTime : 1.0;
+        printf("Cooked: %u, Up to date: %u, Failed: %u \n", statistics.cookedCount, statistics.upToDateCount, statistics.failedCount);
+        printf("Threads: %u, Wall time: %4.2fs, Job time: %4.2fs, CPU time: %4.2fs, Parallelism: %4.2fx \n", statistics.threadCount, statistics.wallTime, statistics.jobTime, statistics.cpuTime, parallelism);
+
+        if (statistics.threadCount > 1u)
+        {
+            printf("Estimated job time: %4.2fs, Estimated peak memory: %4.2fMiB \n", statistics.estimatedCost, statistics.peakEstimatedMemory / (1024.0 * 1024.0));
+        }
+
+        fflush(stdout);
+    }
+
+    void WatchCookJobs(const std::string& srcdir, const std::string& dstdir, std::vector<CookJob>& jobs, JobScheduler* scheduler, uint64_t memoryBudget)
+    {
+        auto watcher = CreateFileWatcher(srcdir);
+
+        if (watcher == nullptr)
+        {
+            printf("Failed to watch source directory: %s \n", srcdir.c_str());
+            return;
+        }
+
+        printf("Watching for changes in: %s \n", srcdir.c_str());
+        fflush(stdout);
+
+        std::vector<std::string> changes;
+        std::vector<std::string> sources;
+        std::vector<CookJob> batch;
+        Clock::time_point changeTime;
+
+        while (WaitForChanges(watcher, PK_ASSET_WATCH_SETTLE_MILLISECONDS, changes, &changeTime))
+        {
+            auto isRescan = false;
+
+            for (const auto& change : changes)
+            {
+                std::error_code error;
+                isRescan |= std::filesystem::is_directory(change, error);
+
+                // A removed directory no longer exists. Check whether any job was below it instead.
+                if (!isRescan && !std::filesystem::exists(change, error))
+                {
+                    auto prefix = (std::filesystem::path(change).lexically_normal() / "").string();
+
+                    isRescan |= std::any_of(jobs.begin(), jobs.end(), [&prefix](const CookJob& job)
+                    {
+                        return std::filesystem::path(job.pathSrc).lexically_normal().string().compare(0u, prefix.size(), prefix) == 0;
+                    });
+                }
+            }
+
+            // Directory level changes or dropped events. Revalidate everything.
+            if (isRescan)
+            {
+                PKVersionUtilities::DirectorySnapshot snapshot;
+                PKVersionUtilities::CaptureSnapshot(srcdir, scheduler, {}, snapshot);
+                PKVersionUtilities::InvalidateAllFiles();
+                jobs.clear();
+                GatherCookJobs(snapshot, srcdir, dstdir, jobs);
+                batch = jobs;
+            }
+            else
+            {
+                PKVersionUtilities::InvalidateFiles(changes);
+                PKVersionUtilities::GetDependentSources(changes, sources);
+                sources.insert(sources.end(), changes.begin(), changes.end());
+
+                for (auto& source : sources)
+                {
+                    source = std::filesystem::path(source).lexically_normal().string();
+                }
+
+                std::sort(sources.begin(), sources.end());
+                sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+                for (const auto& source : sources)
+                {
+                    auto iter = std::find_if(jobs.begin(), jobs.end(), [&source](const CookJob& job)
+                    {
+                        return std::filesystem::path(job.pathSrc).lexically_normal().string() == source;
+                    });
+
+                    std::error_code error;
+                    auto exists = std::filesystem::exists(source, error);
+
+                    if (iter != jobs.end() && !exists)
+                    {
+                        jobs.erase(iter);
+                        continue;
+                    }
+
+                    CookJob job;
+
+                    if (iter == jobs.end() && exists && CreateCookJob(srcdir, source, dstdir, job))
+                    {
+                        iter = jobs.insert(jobs.end(), job);
+                    }
+
+                    if (iter != jobs.end())
+                    {
+                        batch.push_back(*iter);
+                    }
+                }
+            }
+
+            auto statistics = ExecuteCookJobs(batch, scheduler, memoryBudget);
+            CookCache::Trim();
+            PKVersionUtilities::SaveManifest();
+
+            printf("Changed files: %u, Cooked: %u, Up to date: %u, Failed: %u, Latency: %4.2fms \n",
+                (uint32_t)changes.size(),
+                statistics.cookedCount,
+                statistics.upToDateCount,
+                statistics.failedCount,
+                GetSecondsSince(changeTime) * 1000.0);
+
+            fflush(stdout);
+            changes.clear();
+            sources.clear();
+            batch.clear();
+        }
+
+        DestroyFileWatcher(watcher);
+    }
+}
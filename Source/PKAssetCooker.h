@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <PKAsset.h>
+#include "PKDirectorySnapshot.h"
+
+namespace PKAssets
+{
+    struct JobScheduler;
+}
+
+namespace PKAssets::Cooker
+{
+    constexpr static const uint32_t PK_ASSET_WATCH_SETTLE_MILLISECONDS = 20u;
+
+    struct CookJob
+    {
+        PKAssetType type = PKAssetType::Invalid;
+        std::string pathSrc;
+        std::string pathDst;
+        size_t pathStemOffset = 0ull;
+        int32_t status = 0;
+        double duration = 0.0;
+        double cpuTime = 0.0;
+        double estimatedCost = 0.0;
+        uint64_t estimatedMemory = 0ull;
+        bool isStale = false;
+    };
+
+    struct CookStatistics
+    {
+        uint32_t cookedCount = 0u;
+        uint32_t upToDateCount = 0u;
+        uint32_t failedCount = 0u;
+        uint32_t threadCount = 0u;
+        double wallTime = 0.0;
+        double jobTime = 0.0;
+        double cpuTime = 0.0;
+        double estimatedCost = 0.0;
+        uint64_t peakEstimatedMemory = 0ull;
+    };
+
+    bool CreateCookJob(const std::string& basedir, const std::filesystem::path& pathSrc, const std::string& dstdir, CookJob& outJob);
+    void GatherCookJobs(const PKVersionUtilities::DirectorySnapshot& snapshot, const std::string& srcdir, const std::string& dstdir, std::vector<CookJob>& outJobs);
+    int32_t ExecuteCookJob(CookJob& job);
+
+    // Cook jobs are executed in isolated worker processes while enabled. Arguments launch this executable in worker mode.
+    // Workers stay resident between jobs so that compilers & caches stay warm.
+    // A crashed worker only fails the asset it was cooking & is replaced by a new worker.
+    void StartWorkerProcesses(const std::vector<std::string>& arguments, uint32_t count);
+    void StopWorkerProcesses();
+    int32_t ExecuteCookJobInWorker(CookJob& job);
+
+    // Worker process entry. Executes jobs received from the main process until the channel is closed.
+    int RunCookWorker();
+
+    // Jobs are executed serially on the calling thread if no scheduler is given.
+    // Otherwise stale jobs are dispatched longest first with at most one job per thread in flight.
+    // Jobs are held back while their estimated memory would exceed the budget. Zero disables the budget.
+    CookStatistics ExecuteCookJobs(std::vector<CookJob>& jobs, JobScheduler* scheduler, uint64_t memoryBudget);
+    void WriteCookStatistics(const CookStatistics& statistics);
+
+    // Blocks & recooks assets affected by source directory changes.
+    // Compilers, include cache & the worker threads stay resident between changes.
+    void WatchCookJobs(const std::string& srcdir, const std::string& dstdir, std::vector<CookJob>& jobs, JobScheduler* scheduler, uint64_t memoryBudget);
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <filesystem>
 #include <queue>
 #include <map>
@@ -8,10 +9,117 @@
 #endif
 #include <PKAssetEncoding.h>
 #include "PKAssetWriter.h"
+#include "PKLogUtilities.h"
+#include "PKProfiler.h"
 
 namespace PKAssets
 {
-    constexpr static const float MIN_COMPRESSION_RATIO = 0.75f;
+    constexpr static const uint32_t ENCODE_STREAM_COUNT = 4u;
+    // Modeled single stream Huffman decode throughput per table lookup. Pair lookups resolve 1-2 symbols each.
+    constexpr static const double ENCODE_PAIR_LOOKUP_BYTES_PER_SECOND = 275e6;
+    constexpr static const size_t ENCODE_SAMPLE_MIN_SIZE = 16ull << 20ull;
+    constexpr static const size_t ENCODE_SAMPLE_BLOCK_COUNT = 16ull;
+
+    struct EncodeCandidate
+    {
+        uint32_t codec;
+        uint32_t flags;
+        bool isInPlace;
+        double encodeBytesPerSecond;
+        double decodeBytesPerSecond;
+    };
+
+    // Modeled single core throughput per encoding, ordered by encode cost.
+    // Estimates are used instead of measured timings so that cooked outputs stay reproducible.
+    static const EncodeCandidate s_encodeCandidates[] =
+    {
+        { PK_ASSET_ENCODE_CODEC_RANS, 0u, false, 150e6, 300e6 },
+        { PK_ASSET_ENCODE_CODEC_HUFFMAN, 0u, true, 100e6, 500e6 },
+        { PK_ASSET_ENCODE_CODEC_HUFFMAN, 0u, false, 100e6, 500e6 },
+        { PK_ASSET_ENCODE_CODEC_RANS, PK_ASSET_ENCODE_FLAG_MATCHES, false, 45e6, 350e6 },
+        { PK_ASSET_ENCODE_CODEC_HUFFMAN, PK_ASSET_ENCODE_FLAG_MATCHES, false, 40e6, 650e6 },
+    };
+
+    static uint32_t s_assetCodecs[(uint32_t)PKAssetType::Texture + 1u] = { PK_ASSET_CODEC_AUTO, PK_ASSET_CODEC_AUTO, PK_ASSET_CODEC_AUTO, PK_ASSET_CODEC_AUTO, PK_ASSET_CODEC_AUTO };
+    static double s_diskBandwidth = PK_ASSET_DEFAULT_DISK_BANDWIDTH;
+    static double s_encodeBudget = 0.0;
+    static double s_decodeSpeed = 1.0;
+    static uint32_t s_encodeThreadCount = 0u;
+
+    void SetAssetCodec(PKAssetType type, uint32_t codec)
+    {
+        s_assetCodecs[(uint32_t)type] = codec < PK_ASSET_ENCODE_CODEC_COUNT ? codec : PK_ASSET_CODEC_AUTO;
+    }
+
+    uint32_t GetAssetCodec(PKAssetType type)
+    {
+        return (uint32_t)type < sizeof(s_assetCodecs) / sizeof(s_assetCodecs[0]) ? s_assetCodecs[(uint32_t)type] : PK_ASSET_CODEC_AUTO;
+    }
+
+    void SetDiskBandwidth(double bytesPerSecond)
+    {
+        s_diskBandwidth = bytesPerSecond > 0.0 ? bytesPerSecond : PK_ASSET_DEFAULT_DISK_BANDWIDTH;
+    }
+
+    double GetDiskBandwidth()
+    {
+        return s_diskBandwidth;
+    }
+
+    void SetEncodeBudget(double seconds)
+    {
+        s_encodeBudget = seconds > 0.0 ? seconds : 0.0;
+    }
+
+    double GetEncodeBudget()
+    {
+        return s_encodeBudget;
+    }
+
+    void SetDecodeSpeed(double scale)
+    {
+        s_decodeSpeed = scale > 0.0 ? scale : 1.0;
+    }
+
+    double GetDecodeSpeed()
+    {
+        return s_decodeSpeed;
+    }
+
+    void SetEncodeThreadCount(uint32_t threadCount)
+    {
+        s_encodeThreadCount = threadCount;
+    }
+
+    uint32_t GetEncodeThreadCount()
+    {
+        return s_encodeThreadCount;
+    }
+
+    static double GetLoadCost(double fileSize, double decodeTime)
+    {
+        return fileSize / s_diskBandwidth + decodeTime;
+    }
+
+    static double GetDecodeTime(double size, double decodeBytesPerSecond)
+    {
+        return size / (decodeBytesPerSecond * s_decodeSpeed);
+    }
+
+    // Copies evenly spaced whole blocks of a payload. Huge payloads select their encoding from the sample.
+    static void SampleBuffer(const char* data, size_t size, std::vector<char>& outSample)
+    {
+        auto blockSize = 1ull << PK_ASSET_ENCODE_BLOCK_SHIFT;
+        auto blockCount = GetBlockCount(size, PK_ASSET_ENCODE_BLOCK_SHIFT);
+        outSample.clear();
+
+        for (auto i = 0ull; i < ENCODE_SAMPLE_BLOCK_COUNT; ++i)
+        {
+            auto offset = ((i * blockCount) / ENCODE_SAMPLE_BLOCK_COUNT) << PK_ASSET_ENCODE_BLOCK_SHIFT;
+            auto count = size - offset < blockSize ? size - offset : blockSize;
+            outSample.insert(outSample.end(), data + offset, data + offset + count);
+        }
+    }
 
     void WriteName(char* dst, const char* src)
     {
@@ -26,9 +134,114 @@ namespace PKAssets
         memset(dst + c, '\0', PK_ASSET_NAME_MAX_LENGTH - c);
     }
 
+    // Applies the tagged filters to a copy of the buffer. Regions that are out of bounds or overlap a previous region are skipped.
+    static uint32_t FilterBuffer(const PKAssetBuffer& buffer, std::vector<char>& outFiltered, PKAssetFilter* outFilters)
+    {
+        auto filterCount = 0u;
+        outFiltered.assign(buffer.begin(), buffer.end());
+
+        for (const auto& filter : buffer.filters)
+        {
+            auto isValid = filterCount < PK_ASSET_MAX_FILTERS && filter.size > 0u;
+            isValid &= filter.offset >= sizeof(PKAssetHeader) && (size_t)filter.offset + filter.size <= buffer.size();
+
+            for (auto i = 0u; i < filterCount && isValid; ++i)
+            {
+                isValid &= filter.offset >= outFilters[i].offset + outFilters[i].size || filter.offset + filter.size <= outFilters[i].offset;
+            }
+
+            if (isValid && EncodeFilter(reinterpret_cast<uint8_t*>(outFiltered.data()) + filter.offset, filter.size, filter.stride, filter.flags) == 0)
+            {
+                outFilters[filterCount++] = filter;
+            }
+        }
+
+        return filterCount;
+    }
+
+    // Covers the payload with the tagged sections & sections for the gaps between them. Overlapping or out of bounds sections disable sectioning.
+    static uint32_t BuildSections(const PKAssetBuffer& buffer, PKAssetSection* outSections)
+    {
+        auto tagged = buffer.sections;
+        auto offset = (uint64_t)sizeof(PKAssetHeader);
+        auto end = (uint64_t)buffer.size();
+        auto sectionCount = 0u;
+
+        std::sort(tagged.begin(), tagged.end(), [](const PKAssetSection& a, const PKAssetSection& b) { return a.offset < b.offset; });
+
+        for (const auto& section : tagged)
+        {
+            if (section.size == 0u)
+            {
+                continue;
+            }
+
+            if (section.offset < offset || section.offset + (uint64_t)section.size > end || sectionCount + 2u > PK_ASSET_MAX_SECTIONS)
+            {
+                return 0u;
+            }
+
+            if (section.offset > offset)
+            {
+                outSections[sectionCount].offset = (uint32_t)offset;
+                outSections[sectionCount++].size = (uint32_t)(section.offset - offset);
+            }
+
+            outSections[sectionCount++] = section;
+            offset = section.offset + (uint64_t)section.size;
+        }
+
+        if (sectionCount > 0u && offset < end)
+        {
+            outSections[sectionCount].offset = (uint32_t)offset;
+            outSections[sectionCount++].size = (uint32_t)(end - offset);
+        }
+
+        return sectionCount;
+    }
+
+    // Block encodes each section on its own. The encoded sections are concatenated in order.
+    static int EncodeSections(const char* data, PKAssetSection* sections, uint32_t sectionCount, uint32_t codec, uint32_t streamCount, uint32_t flags, uint8_t** outEncoded, size_t* outSize)
+    {
+        uint8_t* encoded = nullptr;
+        size_t encodedSize = 0ull;
+
+        for (auto i = 0u; i < sectionCount; ++i)
+        {
+            uint8_t* blocks = nullptr;
+            size_t blocksSize = 0ull;
+
+            if (EncodeBufferBlocks(data + sections[i].offset, sections[i].size, PK_ASSET_ENCODE_BLOCK_SHIFT, codec, streamCount, flags, s_encodeThreadCount, &blocks, &blocksSize) != 0)
+            {
+                free(encoded);
+                return -1;
+            }
+
+            auto grown = static_cast<uint8_t*>(realloc(encoded, encodedSize + blocksSize));
+
+            if (grown == nullptr)
+            {
+                free(blocks);
+                free(encoded);
+                return -1;
+            }
+
+            encoded = grown;
+            memcpy(encoded + encodedSize, blocks, blocksSize);
+            free(blocks);
+            sections[i].encodedOffset = (uint32_t)encodedSize;
+            sections[i].encodedSize = (uint32_t)blocksSize;
+            encodedSize += blocksSize;
+        }
+
+        *outEncoded = encoded;
+        *outSize = encodedSize;
+        return 0;
+    }
+
     int WriteAsset(const char* filepath, const size_t fileStemOffset, PKAssetBuffer& buffer, bool forceNoCompression)
     {
-        printf("Writing asset: %s ", filepath + fileStemOffset);
+        LogUtilities::Printf("Writing asset: %s ", filepath + fileStemOffset);
 
         FILE* file = nullptr;
 
@@ -43,7 +256,7 @@ namespace PKAssets
             }
             catch (std::exception& e)
             {
-                printf(" Failed: \n %s", e.what());
+                LogUtilities::Printf(" Failed: \n %s", e.what());
             }
         }
 
@@ -52,7 +265,7 @@ namespace PKAssets
 
         if (error != 0)
         {
-            printf(" Failed: \n Failed to open/create file! \n");
+            LogUtilities::Printf(" Failed: \n Failed to open/create file! \n");
             return -1;
         }
 #else
@@ -61,7 +274,7 @@ namespace PKAssets
 
         if (file == nullptr)
         {
-            printf(" Failed: \n Failed to open/create file! \n");
+            LogUtilities::Printf(" Failed: \n Failed to open/create file! \n");
             return -1;
         }
 
@@ -73,44 +286,211 @@ namespace PKAssets
         }
 
         buffer.header->decodePadding = 0u;
+        buffer.header->streamCount = 1u;
+        buffer.header->filterCount = 0u;
+        buffer.header->sectionCount = 0u;
         buffer.header->uncompressedSize = buffer.size();
 
         auto useCompression = !forceNoCompression;
         auto compressionRatio = 1.0;
+        auto encodeFlags = 0u;
+        auto filterCount = 0u;
+        auto codec = PK_ASSET_ENCODE_CODEC_HUFFMAN;
 
         if (useCompression)
         {
             auto* srcData = buffer.data() + sizeof(PKAssetHeader);
             auto srcSize = buffer.header->uncompressedSize - sizeof(PKAssetHeader);
-            
+
+            PKAssetBuffer compact;
+            compact.header[0] = buffer.header[0];
+            compact.header->isCompressed = true;
+
+            // Filtered regions are kept when they reduce the entropy coded size of the payload.
+            std::vector<char> filtered;
+            PKAssetFilter filters[PK_ASSET_MAX_FILTERS];
+            PKAssetSection sections[PK_ASSET_MAX_SECTIONS];
+            auto sectionCount = BuildSections(buffer, sections);
+            filterCount = sectionCount == 0u ? FilterBuffer(buffer, filtered, filters) : 0u;
+
+            if (filterCount > 0u)
+            {
+                PK_PROFILE_SCOPE("EncodeBuffer (Filter)");
+                PKEncodeTable plainTable{};
+                PKEncodeTable filteredTable{};
+                EncodeBuffer(srcData, srcSize, &plainTable, nullptr);
+                EncodeBuffer(filtered.data() + sizeof(PKAssetHeader), srcSize, &filteredTable, nullptr);
+
+                if (filteredTable.size < plainTable.size)
+                {
+                    srcData = filtered.data() + sizeof(PKAssetHeader);
+                    compact.header->filterCount = static_cast<uint8_t>(filterCount);
+                    compact.Write(filters, filterCount);
+                }
+                else
+                {
+                    filterCount = 0u;
+                }
+            }
+
+            // Encodings are selected by their modeled load cost. Encoded bytes read at the disk bandwidth plus the time to decode the payload.
+            // Large payloads are encoded in independent blocks so that they can be encoded & decoded in parallel and partially.
+            // Small payloads are encoded as one stream that can be decoded in place unless a block encoding is cheaper to load.
+            // Sections are always block encoded, the encoding is selected on the whole payload.
+            auto isBlocked = sectionCount > 0u || srcSize > (1ull << PK_ASSET_ENCODE_BLOCK_SHIFT);
+            auto isSampled = srcSize > ENCODE_SAMPLE_MIN_SIZE;
+            std::vector<char> sample;
+
+            if (isSampled)
+            {
+                SampleBuffer(srcData, srcSize, sample);
+            }
+
+            auto* evalData = isSampled ? sample.data() : srcData;
+            auto evalSize = isSampled ? sample.size() : srcSize;
+            auto codecOption = GetAssetCodec(buffer.header->type);
+            auto rawCost = GetLoadCost((double)buffer.size(), 0.0);
+            auto selectedCost = rawCost;
+            auto encodeTime = 0.0;
+            auto pairRatio = 0.0;
+            auto selectedStreamCount = ENCODE_STREAM_COUNT;
+            auto selectedDecodeRate = 0.0;
+            const EncodeCandidate* selected = nullptr;
+            uint8_t* blocks = nullptr;
+            size_t encodedSize = 0ull;
             PKEncodeTable table{};
-            EncodeBuffer(srcData, srcSize, &table, nullptr);
 
-            compressionRatio = (double)(table.size + sizeof(PKAssetHeader)) / (double)buffer.size();
-            useCompression &= compressionRatio <= MIN_COMPRESSION_RATIO;
+            for (const auto& candidate : s_encodeCandidates)
+            {
+                // Huffman blocks without matches only differ from the in place stream when there is more than one block.
+                auto isApplicable = codecOption == PK_ASSET_CODEC_AUTO || codecOption == candidate.codec;
+                isApplicable &= candidate.isInPlace ? !isBlocked : isBlocked || candidate.codec != PK_ASSET_ENCODE_CODEC_HUFFMAN || candidate.flags != 0u;
 
-            if (useCompression)
+                // The budget limits the modeled encode time per asset. The cheapest applicable encoding is always evaluated.
+                auto candidateTime = evalSize / candidate.encodeBytesPerSecond;
+                isApplicable &= s_encodeBudget <= 0.0 || encodeTime <= 0.0 || encodeTime + candidateTime <= s_encodeBudget;
+
+                if (!isApplicable)
+                {
+                    continue;
+                }
+
+                encodeTime += candidateTime;
+                uint8_t* candidateBlocks = nullptr;
+                size_t candidateSize = 0ull;
+                PKEncodeTable candidateTable{};
+                auto streamCount = ENCODE_STREAM_COUNT;
+                auto decodeRate = candidate.decodeBytesPerSecond;
+
+                // Single stream Huffman payloads decode up to two symbols per lookup. They are used when that is modeled faster than interleaved streams.
+                // Blocks always exceed the pair table threshold. Token streams of the match stage are not modeled.
+                if (candidate.codec == PK_ASSET_ENCODE_CODEC_HUFFMAN && candidate.flags == 0u && (isBlocked || srcSize >= PK_ASSET_DECODE_PAIR_MIN_SIZE))
+                {
+                    if (pairRatio <= 0.0)
+                    {
+                        PKEncodeTable pairTable{};
+                        EncodeBuffer(evalData, evalSize, &pairTable, nullptr);
+                        pairRatio = GetDecodePairRatio(&pairTable, evalData, evalSize);
+                    }
+
+                    streamCount = ENCODE_PAIR_LOOKUP_BYTES_PER_SECOND * pairRatio > decodeRate ? 1u : streamCount;
+                    decodeRate = streamCount == 1u ? ENCODE_PAIR_LOOKUP_BYTES_PER_SECOND * pairRatio : decodeRate;
+                }
+
+                if (candidate.isInPlace)
+                {
+                    PK_PROFILE_SCOPE("EncodeBuffer (Measure)");
+                    EncodeBuffer(evalData, evalSize, &candidateTable, nullptr, streamCount);
+                    candidateSize = candidateTable.size;
+                }
+                else
+                {
+                    PK_PROFILE_SCOPE("EncodeBufferBlocks");
+
+                    if (EncodeBufferBlocks(evalData, evalSize, PK_ASSET_ENCODE_BLOCK_SHIFT, candidate.codec, streamCount, candidate.flags, s_encodeThreadCount, &candidateBlocks, &candidateSize) != 0)
+                    {
+                        continue;
+                    }
+                }
+
+                auto fileSize = compact.size() + sectionCount * sizeof(PKAssetSection) + (double)candidateSize * srcSize / evalSize;
+                auto cost = GetLoadCost(fileSize, GetDecodeTime(srcSize, decodeRate));
+
+                if (cost < selectedCost)
+                {
+                    free(blocks);
+                    blocks = candidateBlocks;
+                    encodedSize = candidateSize;
+                    table = candidateTable;
+                    selected = &candidate;
+                    selectedCost = cost;
+                    selectedStreamCount = streamCount;
+                    selectedDecodeRate = decodeRate;
+                }
+                else
+                {
+                    free(candidateBlocks);
+                }
+            }
+
+            // Sampled & sectioned payloads are only encoded as a whole with the selected encoding. It is discarded if it turns out to be more expensive than raw.
+            if ((isSampled || sectionCount > 0u) && selected != nullptr)
+            {
+                PK_PROFILE_SCOPE("EncodeBufferBlocks");
+                free(blocks);
+                blocks = nullptr;
+                auto result = sectionCount > 0u ? 
+                    EncodeSections(buffer.data(), sections, sectionCount, selected->codec, selectedStreamCount, selected->flags, &blocks, &encodedSize) :
+                    EncodeBufferBlocks(srcData, srcSize, PK_ASSET_ENCODE_BLOCK_SHIFT, selected->codec, selectedStreamCount, selected->flags, s_encodeThreadCount, &blocks, &encodedSize);
+                auto fileSize = compact.size() + sectionCount * sizeof(PKAssetSection) + encodedSize;
+                selected = result == 0 && GetLoadCost((double)fileSize, GetDecodeTime(srcSize, selectedDecodeRate)) < rawCost ? selected : nullptr;
+            }
+
+            useCompression = selected != nullptr;
+            compressionRatio = (double)(encodedSize + compact.size() + sectionCount * sizeof(PKAssetSection)) / (double)buffer.size();
+
+            if (useCompression && !selected->isInPlace)
             {
-                PKAssetBuffer compact;
-                compact.header[0] = buffer.header[0];
-                compact.header->isCompressed = true;
+                compact.header->streamCount = static_cast<uint8_t>(selectedStreamCount);
+                compact.header->blockShift = static_cast<uint8_t>(PK_ASSET_ENCODE_BLOCK_SHIFT);
+                compact.header->encodeFlags = static_cast<uint8_t>(selected->flags);
+                compact.header->codec = static_cast<uint8_t>(selected->codec);
+                compact.header->sectionCount = static_cast<uint8_t>(sectionCount);
+                compact.Write(sections, sectionCount);
+                encodeFlags = selected->flags;
+                codec = selected->codec;
+                compact.Write(blocks, encodedSize);
+            }
+            else if (useCompression)
+            {
+                compact.header->streamCount = static_cast<uint8_t>(table.streamCount);
                 // In place encode padding aligned to 16 bytes. write to main header as well to avoid missmatch errors in encode/decode test.
                 compact.header->decodePadding = static_cast<uint16_t>((table.decodePadding + 15u) / 16u);
                 buffer.header->decodePadding = compact.header->decodePadding;
                 auto pData = compact.Allocate<uint8_t>(table.size);
+
+                PK_PROFILE_SCOPE("EncodeBuffer");
                 EncodeBuffer(srcData, srcSize, &table, pData.get());
+            }
+
+            free(blocks);
+
+            if (useCompression)
+            {
+                PK_PROFILE_SCOPE("WriteFile");
                 fwrite(compact.data(), sizeof(char), compact.size(), file);
             }
         }
         
         if (!useCompression)
         {
+            PK_PROFILE_SCOPE("WriteFile");
             fwrite(buffer.data(), sizeof(char), buffer.size(), file);
         }
 
         if (fclose(file) != 0)
         {
-            printf(" Failed: \n Failed to close file! \n");
+            LogUtilities::Printf(" Failed: \n Failed to close file! \n");
             return -1;
         }
 
@@ -120,13 +500,13 @@ namespace PKAssets
 
         auto charData = static_cast<char*>(asset.rawData);
 
-        printf("\n");
+        LogUtilities::Printf("\n");
 
         for (auto i = 0ull; i < buffer.size(); ++i)
         {
             if (charData[i] != buffer.data()[i])
             {
-                printf("Read Write missmatch '%ui' != '%ui' at '%lli'\n", (uint8_t)charData[i], (uint8_t)buffer.data()[i], i);
+                LogUtilities::Printf("Read Write missmatch '%ui' != '%ui' at '%lli'\n", (uint8_t)charData[i], (uint8_t)buffer.data()[i], i);
             }
         }
 
@@ -135,11 +515,15 @@ namespace PKAssets
 
         if (useCompression)
         {
-            printf(" Success: compression ratio %4.2f \n", (float)compressionRatio * 100.0f);
+            LogUtilities::Printf(" Success: compression ratio %4.2f%s%s%s \n", 
+                (float)compressionRatio * 100.0f,
+                codec == PK_ASSET_ENCODE_CODEC_RANS ? " (rans)" : "",
+                (encodeFlags & PK_ASSET_ENCODE_FLAG_MATCHES) != 0u ? " (matches)" : "",
+                filterCount > 0u ? " (filtered)" : "");
         }
         else
         {
-            printf(" Success \n");
+            LogUtilities::Printf(" Success \n");
         }
 
         return 0;
@@ -4,6 +4,9 @@
 
 namespace PKAssets
 {
+    constexpr static const uint32_t PK_ASSET_CODEC_AUTO = 0xFFu;
+    constexpr static const double PK_ASSET_DEFAULT_DISK_BANDWIDTH = 150e6;
+
     template<typename T>
     struct WritePtr
     {
@@ -69,9 +72,51 @@ namespace PKAssets
             return data() + size();
         }
 
+        // Tags a region of fixed stride elements for the byte plane filter. Applied by WriteAsset when it improves compression.
+        template<typename T>
+        void AddFilter(const WritePtr<T>& ptr, size_t size, uint32_t stride, uint32_t flags = 0u)
+        {
+            PKAssetFilter filter;
+            filter.offset = ptr.offset;
+            filter.size = (uint32_t)size;
+            filter.stride = (uint16_t)stride;
+            filter.flags = (uint16_t)flags;
+            filters.push_back(filter);
+        }
+
+        // Tags a region that is encoded independently of the rest of the payload, so that it can be loaded on its own. Sectioned assets are not filtered.
+        template<typename T>
+        void AddSection(const WritePtr<T>& ptr, size_t size)
+        {
+            PKAssetSection section;
+            section.offset = ptr.offset;
+            section.size = (uint32_t)size;
+            sections.push_back(section);
+        }
+
         WritePtr<PKAssetHeader> header;
+        std::vector<PKAssetFilter> filters;
+        std::vector<PKAssetSection> sections;
     };
 
+    // Entropy coder used for compressed assets of a type. PK_ASSET_CODEC_AUTO selects the encoding with the lowest modeled load cost.
+    void SetAssetCodec(PKAssetType type, uint32_t codec);
+    uint32_t GetAssetCodec(PKAssetType type);
+
+    // Load cost model used to select encodings. Disk bandwidth in bytes per second.
+    // The encode budget limits the modeled encode time per asset in seconds. Zero disables the budget.
+    // Decode speed scales the modeled decode throughput of every codec for the target hardware. One uses the built in estimates.
+    void SetDiskBandwidth(double bytesPerSecond);
+    double GetDiskBandwidth();
+    void SetEncodeBudget(double seconds);
+    double GetEncodeBudget();
+    void SetDecodeSpeed(double scale);
+    double GetDecodeSpeed();
+
+    // Threads used to encode the blocks of one asset. Zero uses all hardware threads. Cooks running jobs in parallel use one.
+    void SetEncodeThreadCount(uint32_t threadCount);
+    uint32_t GetEncodeThreadCount();
+
     void WriteName(char* dst, const char* src);
 
     int WriteAsset(const char* filepath, const size_t fileStemOffset, PKAssetBuffer& buffer, bool forceNoCompression);
@@ -0,0 +1,390 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <inttypes.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "PKFileVersionUtilities.h"
+#include "PKLogUtilities.h"
+#include "PKCookCache.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace PKAssets::CookCache
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct CacheEntryHeader
+    {
+        uint64_t magicNumber = PK_ASSET_CACHE_MAGIC_NUMBER;
+        uint64_t hash = 0ull;
+        uint64_t size = 0ull;
+        double cookTime = 0.0;
+    };
+
+    struct CacheEntry
+    {
+        uint64_t size = 0ull;
+        std::filesystem::file_time_type lastAccessTime;
+    };
+
+    struct Cache
+    {
+        std::filesystem::path directory;
+        uint64_t sizeLimit = 0ull;
+        uint64_t cookerHash = 0ull;
+        std::unordered_map<uint64_t, CacheEntry> entries;
+        CacheStatistics statistics;
+        CacheCapture capture;
+        std::mutex lock;
+        bool isOpen = false;
+        bool isCapturing = false;
+    };
+
+    static Cache s_cache;
+
+    static double GetSecondsSince(const Clock::time_point& start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static uint32_t GetProcessIdentifier()
+    {
+#ifdef _WIN32
+        return (uint32_t)_getpid();
+#else
+        return (uint32_t)getpid();
+#endif
+    }
+
+    // Entries are sharded by their first hash byte to keep directory sizes reasonable.
+    static std::filesystem::path GetEntryPath(uint64_t hash)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%02x", (uint32_t)(hash >> 56ull));
+        auto path = s_cache.directory / name;
+        snprintf(name, sizeof(name), "%016" PRIx64 "%s", hash, PK_ASSET_CACHE_EXTENSION);
+        return path / name;
+    }
+
+    static bool ReadWholeFile(const std::filesystem::path& path, std::vector<char>& outData)
+    {
+        auto file = fopen(path.string().c_str(), "rb");
+
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        fseek(file, 0, SEEK_END);
+        auto size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        outData.resize(size > 0 ? (size_t)size : 0ull);
+        auto isRead = size >= 0 && fread(outData.data(), sizeof(char), outData.size(), file) == outData.size();
+        fclose(file);
+        return isRead;
+    }
+
+    void Open(const std::filesystem::path& directory, uint64_t sizeLimit, uint64_t cookerHash)
+    {
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+        std::error_code error;
+
+        s_cache.directory = directory.lexically_normal();
+        s_cache.sizeLimit = sizeLimit;
+        s_cache.cookerHash = cookerHash;
+        s_cache.entries.clear();
+        s_cache.statistics = CacheStatistics();
+        s_cache.isOpen = std::filesystem::create_directories(s_cache.directory, error) || std::filesystem::is_directory(s_cache.directory, error);
+
+        if (!s_cache.isOpen)
+        {
+            printf("Failed to open cook cache: %s \n", s_cache.directory.string().c_str());
+            return;
+        }
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(s_cache.directory, error))
+        {
+            if (!entry.is_regular_file(error) || entry.path().extension().compare(PK_ASSET_CACHE_EXTENSION) != 0)
+            {
+                continue;
+            }
+
+            auto hash = strtoull(entry.path().stem().string().c_str(), nullptr, 16);
+            auto& cacheEntry = s_cache.entries[hash];
+            cacheEntry.size = (uint64_t)entry.file_size(error);
+            cacheEntry.lastAccessTime = entry.last_write_time(error);
+            s_cache.statistics.totalBytes += cacheEntry.size;
+        }
+    }
+
+    bool IsOpen()
+    {
+        return s_cache.isOpen;
+    }
+
+    CacheKey GetKey(const char* pathSrc, const char* pathDst, const void* preprocessedData, size_t preprocessedSize)
+    {
+        CacheKey key;
+
+        if (!s_cache.isOpen)
+        {
+            return key;
+        }
+
+        uint64_t sourceHash = 0ull;
+        uint64_t metaHash = 0ull;
+
+        if (preprocessedData != nullptr)
+        {
+            sourceHash = PKVersionUtilities::HashBuffer(preprocessedData, preprocessedSize);
+        }
+        else if (!PKVersionUtilities::GetFileHash(pathSrc, &sourceHash))
+        {
+            return key;
+        }
+
+        // Missing .pkmeta keys as zero.
+        PKVersionUtilities::GetFileHash(std::string(pathSrc) + PKVersionUtilities::PK_ASSET_META_EXTENSION, &metaHash);
+
+        auto name = std::filesystem::path(pathDst).filename().string();
+        key.hash = PKVersionUtilities::HashBuffer(name.data(), name.size(), s_cache.cookerHash);
+        key.hash = PKVersionUtilities::HashBuffer(&metaHash, sizeof(uint64_t), key.hash);
+        key.hash = PKVersionUtilities::HashBuffer(&sourceHash, sizeof(uint64_t), key.hash);
+        key.startTime = Clock::now();
+        key.isValid = true;
+        return key;
+    }
+
+    bool Restore(const CacheKey& key, const char* pathDst, const size_t pathStemOffset)
+    {
+        if (!s_cache.isOpen || !key.isValid)
+        {
+            return false;
+        }
+
+        auto start = Clock::now();
+        auto entryPath = GetEntryPath(key.hash);
+        std::vector<char> data;
+        CacheEntryHeader header;
+
+        // Entries might have been added by other cooker instances sharing the directory. Always probe the file.
+        auto isValid = ReadWholeFile(entryPath, data) && data.size() >= sizeof(CacheEntryHeader);
+
+        if (isValid)
+        {
+            memcpy(&header, data.data(), sizeof(CacheEntryHeader));
+            isValid = header.magicNumber == PK_ASSET_CACHE_MAGIC_NUMBER && header.hash == key.hash && header.size == data.size() - sizeof(CacheEntryHeader);
+        }
+
+        if (isValid)
+        {
+            std::error_code error;
+            std::filesystem::create_directories(std::filesystem::path(pathDst).parent_path(), error);
+            auto file = fopen(pathDst, "wb");
+            isValid = file != nullptr && fwrite(data.data() + sizeof(CacheEntryHeader), sizeof(char), header.size, file) == header.size;
+            isValid &= file != nullptr && fclose(file) == 0;
+        }
+
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+
+        if (!isValid)
+        {
+            s_cache.statistics.missCount++;
+            s_cache.capture.statistics.missCount += s_cache.isCapturing ? 1u : 0u;
+            return false;
+        }
+
+        std::error_code error;
+        auto accessTime = std::filesystem::file_time_type::clock::now();
+        std::filesystem::last_write_time(entryPath, accessTime, error);
+
+        auto& entry = s_cache.entries[key.hash];
+        s_cache.statistics.totalBytes += data.size() - entry.size;
+        entry.size = data.size();
+        entry.lastAccessTime = accessTime;
+
+        s_cache.statistics.hitCount++;
+        s_cache.statistics.restoredBytes += header.size;
+        s_cache.statistics.restoreTime += GetSecondsSince(start);
+        s_cache.statistics.savedTime += header.cookTime;
+
+        if (s_cache.isCapturing)
+        {
+            s_cache.capture.statistics.hitCount++;
+            s_cache.capture.statistics.restoredBytes += header.size;
+            s_cache.capture.statistics.restoreTime += GetSecondsSince(start);
+            s_cache.capture.statistics.savedTime += header.cookTime;
+            s_cache.capture.entries.emplace_back(key.hash, entry.size);
+        }
+
+        LogUtilities::Printf("Restored from cache: %s \n", pathDst + pathStemOffset);
+        return true;
+    }
+
+    void Store(const CacheKey& key, const char* pathDst)
+    {
+        if (!s_cache.isOpen || !key.isValid)
+        {
+            return;
+        }
+
+        std::vector<char> data;
+
+        if (!ReadWholeFile(pathDst, data))
+        {
+            return;
+        }
+
+        CacheEntryHeader header;
+        header.hash = key.hash;
+        header.size = data.size();
+        header.cookTime = GetSecondsSince(key.startTime);
+
+        // Written to a temporary file unique to the process & thread first so that concurrent cookers never observe partial entries.
+        std::error_code error;
+        auto entryPath = GetEntryPath(key.hash);
+        auto tempPath = entryPath;
+        tempPath += "." + std::to_string(GetProcessIdentifier()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+        std::filesystem::create_directories(entryPath.parent_path(), error);
+
+        auto file = fopen(tempPath.string().c_str(), "wb");
+
+        if (file == nullptr)
+        {
+            return;
+        }
+
+        auto isWritten = fwrite(&header, sizeof(CacheEntryHeader), 1u, file) == 1u;
+        isWritten &= fwrite(data.data(), sizeof(char), data.size(), file) == data.size();
+        isWritten &= fclose(file) == 0;
+
+        std::filesystem::rename(tempPath, entryPath, error);
+
+        if (!isWritten || error)
+        {
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+        auto& entry = s_cache.entries[key.hash];
+        s_cache.statistics.totalBytes -= entry.size;
+        entry.size = sizeof(CacheEntryHeader) + data.size();
+        entry.lastAccessTime = std::filesystem::file_time_type::clock::now();
+        s_cache.statistics.totalBytes += entry.size;
+        s_cache.statistics.storeCount++;
+
+        if (s_cache.isCapturing)
+        {
+            s_cache.capture.statistics.storeCount++;
+            s_cache.capture.entries.emplace_back(key.hash, entry.size);
+        }
+    }
+
+    void Trim()
+    {
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+
+        if (!s_cache.isOpen || s_cache.statistics.totalBytes <= s_cache.sizeLimit)
+        {
+            return;
+        }
+
+        std::vector<std::pair<std::filesystem::file_time_type, uint64_t>> order;
+        order.reserve(s_cache.entries.size());
+
+        for (const auto& kv : s_cache.entries)
+        {
+            order.emplace_back(kv.second.lastAccessTime, kv.first);
+        }
+
+        std::sort(order.begin(), order.end());
+
+        for (auto i = 0ull; i < order.size() && s_cache.statistics.totalBytes > s_cache.sizeLimit; ++i)
+        {
+            std::error_code error;
+            std::filesystem::remove(GetEntryPath(order[i].second), error);
+            s_cache.statistics.totalBytes -= s_cache.entries.at(order[i].second).size;
+            s_cache.statistics.evictCount++;
+            s_cache.entries.erase(order[i].second);
+        }
+    }
+
+    CacheStatistics GetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+        return s_cache.statistics;
+    }
+
+    void BeginCapture()
+    {
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+        s_cache.capture = CacheCapture();
+        s_cache.isCapturing = true;
+    }
+
+    void EndCapture(CacheCapture& outCapture)
+    {
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+        outCapture = std::move(s_cache.capture);
+        s_cache.capture = CacheCapture();
+        s_cache.isCapturing = false;
+    }
+
+    // Entries written by other processes are tracked like local ones so that Trim accounts for their size.
+    void MergeCapture(const CacheCapture& capture)
+    {
+        std::lock_guard<std::mutex> lock(s_cache.lock);
+
+        if (!s_cache.isOpen)
+        {
+            return;
+        }
+
+        auto accessTime = std::filesystem::file_time_type::clock::now();
+
+        for (const auto& kv : capture.entries)
+        {
+            auto& entry = s_cache.entries[kv.first];
+            s_cache.statistics.totalBytes -= entry.size;
+            entry.size = kv.second;
+            entry.lastAccessTime = accessTime;
+            s_cache.statistics.totalBytes += entry.size;
+        }
+
+        s_cache.statistics.hitCount += capture.statistics.hitCount;
+        s_cache.statistics.missCount += capture.statistics.missCount;
+        s_cache.statistics.storeCount += capture.statistics.storeCount;
+        s_cache.statistics.restoredBytes += capture.statistics.restoredBytes;
+        s_cache.statistics.restoreTime += capture.statistics.restoreTime;
+        s_cache.statistics.savedTime += capture.statistics.savedTime;
+    }
+
+    void WriteStatistics()
+    {
+        if (!s_cache.isOpen)
+        {
+            return;
+        }
+
+        auto statistics = GetStatistics();
+        auto lookupCount = statistics.hitCount + statistics.missCount;
+        auto hitRate = lookupCount > 0u ? 100.0 * statistics.hitCount / lookupCount : 0.0;
+        printf("Cache hits: %u, Misses: %u, Hit rate: %4.1f%%, Stored: %u, Evicted: %u \n", statistics.hitCount, statistics.missCount, hitRate, statistics.storeCount, statistics.evictCount);
+        printf("Cache restored: %4.2fMiB in %4.2fs, Time saved: %4.2fs, Size: %4.2f/%4.2fMiB \n",
+            statistics.restoredBytes / (1024.0 * 1024.0),
+            statistics.restoreTime,
+            statistics.savedTime - statistics.restoreTime,
+            statistics.totalBytes / (1024.0 * 1024.0),
+            s_cache.sizeLimit / (1024.0 * 1024.0));
+        fflush(stdout);
+    }
+}
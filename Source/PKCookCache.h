@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+namespace PKAssets::CookCache
+{
+    constexpr static const char* PK_ASSET_CACHE_EXTENSION = ".pkcache";
+    constexpr static const uint64_t PK_ASSET_CACHE_MAGIC_NUMBER = 0x48434143304B50ull; // PK0CACH
+    constexpr static const uint64_t PK_ASSET_CACHE_DEFAULT_SIZE = 4096ull << 20ull;
+
+    struct CacheKey
+    {
+        uint64_t hash = 0ull;
+        std::chrono::steady_clock::time_point startTime;
+        bool isValid = false;
+    };
+
+    struct CacheStatistics
+    {
+        uint32_t hitCount = 0u;
+        uint32_t missCount = 0u;
+        uint32_t storeCount = 0u;
+        uint32_t evictCount = 0u;
+        uint64_t restoredBytes = 0ull;
+        uint64_t totalBytes = 0ull;
+        double restoreTime = 0.0;
+        double savedTime = 0.0;
+    };
+
+    // Lookups & entries written while a capture is active. Worker processes return them to the main process, which owns the statistics & trimming.
+    struct CacheCapture
+    {
+        CacheStatistics statistics;
+        std::vector<std::pair<uint64_t, uint64_t>> entries;
+    };
+
+    // Content addressable cache of cooked outputs. Can be shared between checkouts & branches.
+    // Entries are keyed by the cooker version, output name, .pkmeta options & input contents.
+    // Shaders key their preprocessed source, other assets key the raw source file.
+    // Least recently used entries are evicted once the size limit is exceeded at the end of a cook.
+    void Open(const std::filesystem::path& directory, uint64_t sizeLimit, uint64_t cookerHash);
+    bool IsOpen();
+    CacheKey GetKey(const char* pathSrc, const char* pathDst, const void* preprocessedData = nullptr, size_t preprocessedSize = 0ull);
+    bool Restore(const CacheKey& key, const char* pathDst, const size_t pathStemOffset);
+    void Store(const CacheKey& key, const char* pathDst);
+    void Trim();
+    CacheStatistics GetStatistics();
+    void BeginCapture();
+    void EndCapture(CacheCapture& outCapture);
+    void MergeCapture(const CacheCapture& capture);
+    void WriteStatistics();
+}
@@ -0,0 +1,160 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <vector>
+#include "PKStringUtilities.h"
+#include "PKCookCostModel.h"
+
+namespace PKAssets::Cooker
+{
+    constexpr static const size_t COST_SCAN_CHUNK_SIZE = 1ull << 20ull;
+    constexpr static const double COST_SHADER_BASE = 0.02;
+    constexpr static const double COST_SHADER_PER_COMPILE = 0.02;
+    constexpr static const double COST_MESH_BASE = 0.01;
+    constexpr static const double COST_MESH_PER_FACE = 2e-6;
+    constexpr static const double COST_FONT_BASE = 0.5;
+    constexpr static const double COST_PER_SOURCE_BYTE = 2e-9;
+    constexpr static const uint64_t MEMORY_SHADER_BASE = 32ull << 20ull;
+    constexpr static const uint64_t MEMORY_SHADER_PER_COMPILE = 256ull << 10ull;
+    constexpr static const uint64_t MEMORY_MESH_BASE = 16ull << 20ull;
+    constexpr static const uint64_t MEMORY_MESH_PER_VERTEX = 128ull;
+    constexpr static const uint64_t MEMORY_MESH_PER_FACE = 192ull;
+    constexpr static const uint64_t MEMORY_FONT_BASE = 64ull << 20ull;
+
+    static uint64_t GetSourceSize(const std::string& path)
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        return error ? 0ull : (uint64_t)size;
+    }
+
+    // Counts lines starting with "v " & "f " without parsing them.
+    static void ScanObjCounts(const std::string& path, uint64_t* outVertexCount, uint64_t* outFaceCount)
+    {
+        *outVertexCount = 0ull;
+        *outFaceCount = 0ull;
+
+        auto file = fopen(path.c_str(), "rb");
+
+        if (file == nullptr)
+        {
+            return;
+        }
+
+        std::vector<char> buffer(COST_SCAN_CHUNK_SIZE + 1ull);
+        auto carryCount = 0ull;
+        auto isMidLine = false;
+
+        while (true)
+        {
+            auto readCount = fread(buffer.data() + carryCount, sizeof(char), COST_SCAN_CHUNK_SIZE, file);
+
+            if (readCount == 0ull)
+            {
+                break;
+            }
+
+            auto head = buffer.data();
+            auto end = buffer.data() + carryCount + readCount;
+            carryCount = 0ull;
+
+            while (head < end)
+            {
+                if (isMidLine)
+                {
+                    auto eol = reinterpret_cast<char*>(memchr(head, '\n', end - head));
+                    isMidLine = eol == nullptr;
+                    head = isMidLine ? end : eol + 1;
+                    continue;
+                }
+
+                // Line prefix continues in the next chunk.
+                if (end - head < 2)
+                {
+                    buffer[0] = *head;
+                    carryCount = 1ull;
+                    break;
+                }
+
+                if (head[1] == ' ' || head[1] == '\t')
+                {
+                    *outVertexCount += head[0] == 'v' ? 1ull : 0ull;
+                    *outFaceCount += head[0] == 'f' ? 1ull : 0ull;
+                }
+
+                isMidLine = true;
+            }
+        }
+
+        fclose(file);
+    }
+
+    static void ScanShaderCounts(const std::string& path, uint64_t* outVariantCount, uint64_t* outProgramCount)
+    {
+        *outVariantCount = 1ull;
+        *outProgramCount = 0ull;
+
+        std::ifstream file(path, std::ios::in);
+        std::string lineBuffer;
+        auto multiCompileLength = strlen(PK_SHADER_ATTRIB_MULTI_COMPILE);
+        auto programLength = strlen(PK_SHADER_ATTRIB_PROGRAM);
+
+        while (std::getline(file, lineBuffer))
+        {
+            auto line = StringUtilities::Trim(lineBuffer);
+
+            if (line.compare(0u, multiCompileLength, PK_SHADER_ATTRIB_MULTI_COMPILE) == 0)
+            {
+                auto keywords = StringUtilities::Split(line.substr(multiCompileLength), " ");
+                *outVariantCount *= keywords.empty() ? 1ull : keywords.size();
+            }
+            else if (line.compare(0u, programLength, PK_SHADER_ATTRIB_PROGRAM) == 0)
+            {
+                (*outProgramCount)++;
+            }
+        }
+
+        *outProgramCount = *outProgramCount > 0ull ? *outProgramCount : 1ull;
+    }
+
+    void EstimateCookJob(CookJob& job)
+    {
+        auto sourceSize = GetSourceSize(job.pathSrc);
+
+        switch (job.type)
+        {
+            case PKAssetType::Shader:
+            {
+                uint64_t variantCount, programCount;
+                ScanShaderCounts(job.pathSrc, &variantCount, &programCount);
+                // Every variant & stage is compiled twice (debug & release).
+                auto compileCount = variantCount * programCount * 2ull;
+                job.estimatedCost = COST_SHADER_BASE + compileCount * COST_SHADER_PER_COMPILE;
+                job.estimatedMemory = MEMORY_SHADER_BASE + compileCount * MEMORY_SHADER_PER_COMPILE;
+            }
+            break;
+
+            case PKAssetType::Mesh:
+            {
+                uint64_t vertexCount, faceCount;
+                ScanObjCounts(job.pathSrc, &vertexCount, &faceCount);
+                job.estimatedCost = COST_MESH_BASE + faceCount * COST_MESH_PER_FACE;
+                job.estimatedMemory = MEMORY_MESH_BASE + sourceSize + vertexCount * MEMORY_MESH_PER_VERTEX + faceCount * MEMORY_MESH_PER_FACE;
+            }
+            break;
+
+            case PKAssetType::Font:
+                job.estimatedCost = COST_FONT_BASE;
+                job.estimatedMemory = MEMORY_FONT_BASE + sourceSize;
+                break;
+
+            default:
+                job.estimatedCost = 0.0;
+                job.estimatedMemory = sourceSize * 2ull;
+                break;
+        }
+
+        job.estimatedCost += sourceSize * COST_PER_SOURCE_BYTE;
+    }
+}
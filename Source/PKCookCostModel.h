@@ -0,0 +1,10 @@
+#pragma once
+#include "PKAssetCooker.h"
+
+namespace PKAssets::Cooker
+{
+    // Heuristic estimates of cook time (seconds) & peak memory (bytes) based on a quick scan of the source.
+    // Shaders: variant count x entry point count from pk_multi_compile & pk_program directives.
+    // Meshes: vertex & face counts from the .obj data. Fonts & textures: source size.
+    void EstimateCookJob(CookJob& job);
+}
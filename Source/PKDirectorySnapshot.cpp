@@ -0,0 +1,225 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <mutex>
+#include <fstream>
+#include <algorithm>
+#include "PKJobScheduler.h"
+#include "PKDirectorySnapshot.h"
+
+namespace PKVersionUtilities
+{
+    constexpr static const char* SNAPSHOT_HEADER = "pksnapshot 1";
+
+    struct SnapshotContext
+    {
+        const std::filesystem::path* root;
+        const std::vector<std::string>* excludedNames;
+        PKAssets::JobScheduler* scheduler;
+        DirectorySnapshot* snapshot;
+        std::mutex lock;
+    };
+
+    static std::string GetSnapshotKey(const std::filesystem::path& path, const std::filesystem::path& root)
+    {
+        return std::filesystem::path(path).lexically_normal().lexically_relative(root).generic_string();
+    }
+
+    static void CaptureDirectory(SnapshotContext* context, const std::filesystem::path& directory)
+    {
+        std::vector<std::pair<std::string, SnapshotEntry>> entries;
+        std::error_code error;
+
+        // Directory entries cache the metadata returned by the directory enumeration where the platform provides it.
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        {
+            std::error_code entryError;
+
+            if (entry.is_directory(entryError))
+            {
+                if (context->scheduler != nullptr)
+                {
+                    auto path = entry.path();
+                    context->scheduler->Enqueue([context, path]() { CaptureDirectory(context, path); });
+                }
+                else
+                {
+                    CaptureDirectory(context, entry.path());
+                }
+
+                continue;
+            }
+
+            auto name = entry.path().filename().string();
+            auto excludedNames = context->excludedNames;
+
+            if (std::find(excludedNames->begin(), excludedNames->end(), name) != excludedNames->end())
+            {
+                continue;
+            }
+
+            SnapshotEntry snapshotEntry;
+            snapshotEntry.size = (uint64_t)entry.file_size(entryError);
+            snapshotEntry.writeTime = (int64_t)entry.last_write_time(entryError).time_since_epoch().count();
+
+            if (!entryError)
+            {
+                entries.emplace_back(GetSnapshotKey(entry.path(), *context->root), snapshotEntry);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(context->lock);
+
+        for (auto& kv : entries)
+        {
+            context->snapshot->entries[std::move(kv.first)] = kv.second;
+        }
+    }
+
+    void CaptureSnapshot(const std::filesystem::path& root, PKAssets::JobScheduler* scheduler, const std::vector<std::string>& excludedNames, DirectorySnapshot& outSnapshot)
+    {
+        outSnapshot.root = root.lexically_normal();
+        outSnapshot.entries.clear();
+
+        SnapshotContext context;
+        context.root = &outSnapshot.root;
+        context.excludedNames = &excludedNames;
+        context.scheduler = scheduler;
+        context.snapshot = &outSnapshot;
+
+        std::error_code error;
+
+        if (!std::filesystem::is_directory(outSnapshot.root, error))
+        {
+            return;
+        }
+
+        CaptureDirectory(&context, outSnapshot.root);
+
+        if (scheduler != nullptr)
+        {
+            scheduler->Wait();
+        }
+    }
+
+    const SnapshotEntry* FindSnapshotEntry(const DirectorySnapshot& snapshot, const std::filesystem::path& path)
+    {
+        auto iter = snapshot.entries.find(GetSnapshotKey(path, snapshot.root));
+        return iter != snapshot.entries.end() ? &iter->second : nullptr;
+    }
+
+    void UpdateSnapshotEntry(DirectorySnapshot& snapshot, const std::filesystem::path& path)
+    {
+        std::error_code error;
+        auto key = GetSnapshotKey(path, snapshot.root);
+        auto size = std::filesystem::file_size(path, error);
+        auto writeTime = error ? std::filesystem::file_time_type() : std::filesystem::last_write_time(path, error);
+
+        if (error)
+        {
+            snapshot.entries.erase(key);
+            return;
+        }
+
+        auto& entry = snapshot.entries[key];
+        entry.size = (uint64_t)size;
+        entry.writeTime = (int64_t)writeTime.time_since_epoch().count();
+    }
+
+    void DiffSnapshots(const DirectorySnapshot& previous, const DirectorySnapshot& current, SnapshotDiff& outDiff)
+    {
+        for (const auto& kv : current.entries)
+        {
+            auto iter = previous.entries.find(kv.first);
+
+            if (iter == previous.entries.end())
+            {
+                outDiff.added.push_back(kv.first);
+            }
+            else if (iter->second.size != kv.second.size || iter->second.writeTime != kv.second.writeTime)
+            {
+                outDiff.modified.push_back(kv.first);
+            }
+        }
+
+        for (const auto& kv : previous.entries)
+        {
+            if (current.entries.count(kv.first) == 0ull)
+            {
+                outDiff.removed.push_back(kv.first);
+            }
+        }
+    }
+
+    bool LoadSnapshots(const std::filesystem::path& path, uint64_t* outCookerHash, bool* outIsClean, DirectorySnapshot& outSource, DirectorySnapshot& outDestination)
+    {
+        outSource.entries.clear();
+        outDestination.entries.clear();
+
+        std::ifstream file(path, std::ios::in);
+        std::string lineBuffer;
+
+        if (!file || !std::getline(file, lineBuffer) || lineBuffer != SNAPSHOT_HEADER)
+        {
+            return false;
+        }
+
+        unsigned long long cookerHash = 0ull;
+        int isClean = 0;
+
+        if (!std::getline(file, lineBuffer) || sscanf(lineBuffer.c_str(), "run %llx %i", &cookerHash, &isClean) != 2)
+        {
+            return false;
+        }
+
+        *outCookerHash = cookerHash;
+        *outIsClean = isClean != 0;
+
+        // Format: <s|d> <size> <write time>\t<relative path>
+        while (std::getline(file, lineBuffer))
+        {
+            auto tab = lineBuffer.find('\t');
+            char tree = 0;
+            unsigned long long size = 0ull;
+            long long writeTime = 0ll;
+
+            if (tab == std::string::npos || sscanf(lineBuffer.c_str(), "%c %llu %lld", &tree, &size, &writeTime) != 3)
+            {
+                continue;
+            }
+
+            auto& snapshot = tree == 's' ? outSource : outDestination;
+            auto& entry = snapshot.entries[lineBuffer.substr(tab + 1u)];
+            entry.size = size;
+            entry.writeTime = writeTime;
+        }
+
+        return true;
+    }
+
+    bool SaveSnapshots(const std::filesystem::path& path, uint64_t cookerHash, bool isClean, const DirectorySnapshot& source, const DirectorySnapshot& destination)
+    {
+        auto file = fopen(path.string().c_str(), "w");
+
+        if (file == nullptr)
+        {
+            printf("Failed to write directory snapshot: %s \n", path.string().c_str());
+            return false;
+        }
+
+        fprintf(file, "%s\n", SNAPSHOT_HEADER);
+        fprintf(file, "run %llx %i\n", (unsigned long long)cookerHash, isClean ? 1 : 0);
+
+        for (const auto& kv : source.entries)
+        {
+            fprintf(file, "s %llu %lld\t%s\n", (unsigned long long)kv.second.size, (long long)kv.second.writeTime, kv.first.c_str());
+        }
+
+        for (const auto& kv : destination.entries)
+        {
+            fprintf(file, "d %llu %lld\t%s\n", (unsigned long long)kv.second.size, (long long)kv.second.writeTime, kv.first.c_str());
+        }
+
+        fclose(file);
+        return true;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+namespace PKAssets
+{
+    struct JobScheduler;
+}
+
+namespace PKVersionUtilities
+{
+    constexpr static const char* PK_ASSET_SNAPSHOT_FILENAME = ".pksnapshot";
+
+    struct SnapshotEntry
+    {
+        uint64_t size = 0ull;
+        int64_t writeTime = 0ll;
+    };
+
+    // File metadata of a directory tree captured in a single pass.
+    // Keys are generic paths relative to the root. Directories are not recorded.
+    struct DirectorySnapshot
+    {
+        std::filesystem::path root;
+        std::unordered_map<std::string, SnapshotEntry> entries;
+    };
+
+    struct SnapshotDiff
+    {
+        std::vector<std::string> added;
+        std::vector<std::string> removed;
+        std::vector<std::string> modified;
+
+        inline bool IsEmpty() const { return added.empty() && removed.empty() && modified.empty(); }
+    };
+
+    // Subdirectories are walked in parallel when a scheduler is given.
+    // Files whose name matches any of the excluded names are skipped.
+    void CaptureSnapshot(const std::filesystem::path& root, PKAssets::JobScheduler* scheduler, const std::vector<std::string>& excludedNames, DirectorySnapshot& outSnapshot);
+    const SnapshotEntry* FindSnapshotEntry(const DirectorySnapshot& snapshot, const std::filesystem::path& path);
+    void UpdateSnapshotEntry(DirectorySnapshot& snapshot, const std::filesystem::path& path);
+    void DiffSnapshots(const DirectorySnapshot& previous, const DirectorySnapshot& current, SnapshotDiff& outDiff);
+
+    // Source & destination snapshots of the previous run are persisted together with the cooker hash.
+    // A run is clean if none of its assets failed to cook.
+    bool LoadSnapshots(const std::filesystem::path& path, uint64_t* outCookerHash, bool* outIsClean, DirectorySnapshot& outSource, DirectorySnapshot& outDestination);
+    bool SaveSnapshots(const std::filesystem::path& path, uint64_t cookerHash, bool isClean, const DirectorySnapshot& source, const DirectorySnapshot& destination);
+}
@@ -0,0 +1,327 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <filesystem>
+#include <PKAssetLoader.h>
+#include <PKAssetEncoding.h>
+#include "PKEncodingBenchmark.h"
+
+namespace PKAssets::Benchmark
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct BenchmarkInput
+    {
+        std::string name;
+        std::vector<uint8_t> data;
+    };
+
+    struct BenchmarkCodec
+    {
+        const char* name;
+        uint32_t codec;
+        uint32_t streamCount;
+        uint32_t flags;
+        bool isBlocked;
+        bool isSingleTable;
+    };
+
+    struct BenchmarkResult
+    {
+        uint64_t inputBytes = 0ull;
+        uint64_t encodedBytes = 0ull;
+        uint64_t decodedBytes = 0ull;
+        double encodeTime = 0.0;
+        double decodeTime = 0.0;
+    };
+
+    static const BenchmarkCodec s_codecs[] =
+    {
+        { "Huffman x1 single", PK_ASSET_ENCODE_CODEC_HUFFMAN, 1u, 0u, false, true },
+        { "Huffman x1", PK_ASSET_ENCODE_CODEC_HUFFMAN, 1u, 0u, false, false },
+        { "Huffman x4", PK_ASSET_ENCODE_CODEC_HUFFMAN, 4u, 0u, false, false },
+        { "Huffman x8", PK_ASSET_ENCODE_CODEC_HUFFMAN, 8u, 0u, false, false },
+        { "Blocks x4", PK_ASSET_ENCODE_CODEC_HUFFMAN, 4u, 0u, true, false },
+        { "Matches x4", PK_ASSET_ENCODE_CODEC_HUFFMAN, 4u, PK_ASSET_ENCODE_FLAG_MATCHES, true, false },
+        { "rANS x4", PK_ASSET_ENCODE_CODEC_RANS, 4u, 0u, true, false },
+        { "rANS x8", PK_ASSET_ENCODE_CODEC_RANS, 8u, 0u, true, false },
+        { "rANS matches x4", PK_ASSET_ENCODE_CODEC_RANS, 4u, PK_ASSET_ENCODE_FLAG_MATCHES, true, false },
+    };
+
+    // Odd sizes around the decoder unroll, pair table & block boundaries.
+    static const size_t s_checkSizes[] = { 1ull, 2ull, 3ull, 5ull, 7ull, 9ull, 13ull, 31ull, 33ull, 255ull, 1021ull, 4097ull, 16383ull, 16385ull, 65537ull, (1ull << PK_ASSET_ENCODE_BLOCK_SHIFT) + 3ull, (3ull << PK_ASSET_ENCODE_BLOCK_SHIFT) - 1ull };
+    static const uint32_t s_checkAlphabetSizes[] = { 1u, 2u, 17u, 256u };
+
+    static double GetSecondsSince(const Clock::time_point& start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static bool LoadInput(const std::filesystem::path& path, BenchmarkInput& outInput)
+    {
+        outInput.name = path.string();
+        outInput.data.clear();
+
+        PKAsset asset{};
+
+        if (OpenAsset(outInput.name.c_str(), &asset) == 0)
+        {
+            auto payload = static_cast<const uint8_t*>(asset.rawData) + sizeof(PKAssetHeader);
+            outInput.data.assign(payload, payload + (asset.header->uncompressedSize - sizeof(PKAssetHeader)));
+            CloseAsset(&asset);
+            return !outInput.data.empty();
+        }
+
+        auto file = fopen(outInput.name.c_str(), "rb");
+
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        fseek(file, 0, SEEK_END);
+        auto size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        outInput.data.resize(size > 0 ? (size_t)size : 0ull);
+        auto isRead = fread(outInput.data.data(), sizeof(uint8_t), outInput.data.size(), file) == outInput.data.size();
+        fclose(file);
+        return isRead && !outInput.data.empty();
+    }
+
+    static bool RunCodec(const BenchmarkCodec& codec, const BenchmarkInput& input, BenchmarkResult& result)
+    {
+        // Block codecs are measured on a single thread so that results compare per core throughput.
+        auto start = Clock::now();
+        std::vector<uint8_t> encoded;
+        PKEncodeTable table{};
+
+        if (codec.isBlocked)
+        {
+            uint8_t* blocks = nullptr;
+            size_t blocksSize = 0ull;
+
+            if (EncodeBufferBlocks(input.data.data(), input.data.size(), PK_ASSET_ENCODE_BLOCK_SHIFT, codec.codec, codec.streamCount, codec.flags, 1u, &blocks, &blocksSize) != 0)
+            {
+                printf("Failed to encode: %s, %s \n", codec.name, input.name.c_str());
+                return false;
+            }
+
+            // Decoders read up to 8 bytes past the current position.
+            encoded.resize(blocksSize + 8ull);
+            memcpy(encoded.data(), blocks, blocksSize);
+            free(blocks);
+            table.size = blocksSize;
+        }
+        else
+        {
+            EncodeBuffer(input.data.data(), input.data.size(), &table, nullptr, codec.streamCount);
+            encoded.resize(table.size + 8ull);
+            EncodeBuffer(input.data.data(), input.data.size(), &table, encoded.data());
+        }
+
+        result.encodeTime += GetSecondsSince(start);
+
+        std::vector<uint8_t> decoded(input.data.size() + 8ull);
+        auto repeatCount = PK_BENCHMARK_MIN_DECODE_BYTES / input.data.size() + 1ull;
+        start = Clock::now();
+
+        for (auto i = 0ull; i < repeatCount; ++i)
+        {
+            if (codec.isSingleTable)
+            {
+                DecodeBufferSingleTable(encoded.data(), decoded.data(), input.data.size());
+            }
+            else if (codec.isBlocked)
+            {
+                DecodeBufferBlocks(encoded.data(), decoded.data(), input.data.size(), PK_ASSET_ENCODE_BLOCK_SHIFT, codec.codec, codec.streamCount, codec.flags, 1u);
+            }
+            else
+            {
+                DecodeBuffer(encoded.data(), decoded.data(), input.data.size(), table.streamCount);
+            }
+        }
+
+        result.decodeTime += GetSecondsSince(start);
+        result.inputBytes += input.data.size();
+        result.encodedBytes += table.size;
+        result.decodedBytes += input.data.size() * repeatCount;
+
+        if (memcmp(decoded.data(), input.data.data(), input.data.size()) != 0)
+        {
+            printf("Round trip mismatch: %s, %s \n", codec.name, input.name.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    int RunEncodingBenchmark(const std::string& path)
+    {
+        std::vector<BenchmarkInput> inputs;
+        std::vector<std::filesystem::path> paths;
+
+        if (std::filesystem::is_directory(path))
+        {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file())
+                {
+                    paths.push_back(entry.path());
+                }
+            }
+        }
+        else
+        {
+            paths.push_back(path);
+        }
+
+        for (const auto& inputPath : paths)
+        {
+            BenchmarkInput input;
+
+            if (LoadInput(inputPath, input))
+            {
+                inputs.push_back(std::move(input));
+            }
+        }
+
+        if (inputs.empty())
+        {
+            printf("No benchmark inputs found: %s \n", path.c_str());
+            return -1;
+        }
+
+        auto totalSize = 0ull;
+
+        for (const auto& input : inputs)
+        {
+            totalSize += input.data.size();
+        }
+
+        printf("Encoding benchmark: %u files, %4.2fMiB \n", (uint32_t)inputs.size(), totalSize / (1024.0 * 1024.0));
+        auto status = 0;
+
+        for (const auto& codec : s_codecs)
+        {
+            BenchmarkResult result;
+
+            for (const auto& input : inputs)
+            {
+                status = RunCodec(codec, input, result) ? status : -1;
+            }
+
+            printf("%-16s Ratio: %6.2f%%, Encode: %8.1fMB/s, Decode: %8.1fMB/s \n",
+                codec.name,
+                100.0 * result.encodedBytes / result.inputBytes,
+                result.inputBytes / (result.encodeTime * 1e6),
+                result.decodedBytes / (result.decodeTime * 1e6));
+        }
+
+        fflush(stdout);
+        return status;
+    }
+
+    // Skewed towards zero so that code lengths differ. Alphabets of one symbol produce runs.
+    static void GenerateCheckInput(size_t size, uint32_t alphabetSize, std::vector<uint8_t>& outData)
+    {
+        auto state = (uint32_t)size * 2654435761u + alphabetSize;
+        outData.resize(size);
+
+        for (auto& value : outData)
+        {
+            state = state * 1664525u + 1013904223u;
+            value = (uint8_t)(((state >> 16u) % alphabetSize) * ((state >> 13u) & 1u));
+        }
+    }
+
+    static bool CheckCodec(const BenchmarkCodec& codec, const std::vector<uint8_t>& data)
+    {
+        // Decoders read & write up to 8 bytes past the end of their buffers.
+        std::vector<uint8_t> decoded(data.size() + 8ull);
+
+        if (codec.isBlocked)
+        {
+            uint8_t* blocks = nullptr;
+            size_t blocksSize = 0ull;
+
+            if (EncodeBufferBlocks(data.data(), data.size(), PK_ASSET_ENCODE_BLOCK_SHIFT, codec.codec, codec.streamCount, codec.flags, 1u, &blocks, &blocksSize) != 0)
+            {
+                return false;
+            }
+
+            std::vector<uint8_t> encoded(blocks, blocks + blocksSize);
+            encoded.resize(blocksSize + 8ull);
+            free(blocks);
+
+            // Ranges start & end inside blocks so that partially decoded blocks are covered.
+            auto rangeOffset = data.size() / 3ull;
+            auto rangeSize = data.size() - rangeOffset - data.size() / 5ull;
+            std::vector<uint8_t> range(rangeSize + 8ull);
+
+            auto isValid = ValidateBufferBlocks(encoded.data(), blocksSize, data.size(), PK_ASSET_ENCODE_BLOCK_SHIFT) == 0;
+            isValid = isValid && DecodeBufferBlocks(encoded.data(), decoded.data(), data.size(), PK_ASSET_ENCODE_BLOCK_SHIFT, codec.codec, codec.streamCount, codec.flags, 1u) == 0;
+            isValid = isValid && memcmp(decoded.data(), data.data(), data.size()) == 0;
+            isValid = isValid && DecodeBufferRange(encoded.data(), data.size(), PK_ASSET_ENCODE_BLOCK_SHIFT, codec.codec, codec.streamCount, codec.flags, rangeOffset, rangeSize, range.data()) == 0;
+            return isValid && memcmp(range.data(), data.data() + rangeOffset, rangeSize) == 0;
+        }
+
+        PKEncodeTable table{};
+        EncodeBuffer(data.data(), data.size(), &table, nullptr, codec.streamCount);
+        std::vector<uint8_t> encoded(table.size + 8ull);
+        EncodeBuffer(data.data(), data.size(), &table, encoded.data());
+
+        auto result = codec.isSingleTable ? DecodeBufferSingleTable(encoded.data(), decoded.data(), data.size()) : DecodeBuffer(encoded.data(), decoded.data(), data.size(), table.streamCount);
+
+        if (result != 0 || memcmp(decoded.data(), data.data(), data.size()) != 0)
+        {
+            return false;
+        }
+
+        // In place decoding places the encoded data at the end of the decode buffer, the same as the loader does.
+        auto padding = (table.decodePadding + 15ull) / 16ull * 16ull;
+
+        if (codec.isSingleTable || table.size > data.size() + padding)
+        {
+            return true;
+        }
+
+        std::vector<uint8_t> buffer(data.size() + padding + 8ull);
+        auto inPlace = buffer.data() + buffer.size() - 8ull - table.size;
+        memcpy(inPlace, encoded.data(), table.size);
+        result = DecodeBuffer(inPlace, buffer.data(), data.size(), table.streamCount);
+        return result == 0 && memcmp(buffer.data(), data.data(), data.size()) == 0;
+    }
+
+    int RunEncodingCheck()
+    {
+        std::vector<uint8_t> data;
+        auto caseCount = 0u;
+        auto failCount = 0u;
+
+        for (auto alphabetSize : s_checkAlphabetSizes)
+        {
+            for (auto size : s_checkSizes)
+            {
+                GenerateCheckInput(size, alphabetSize, data);
+
+                for (const auto& codec : s_codecs)
+                {
+                    caseCount++;
+
+                    if (!CheckCodec(codec, data))
+                    {
+                        printf("Round trip mismatch: %s, %u symbols, %u bytes \n", codec.name, alphabetSize, (uint32_t)size);
+                        failCount++;
+                    }
+                }
+            }
+        }
+
+        printf("Encoding check: %u cases, %u failed \n", caseCount, failCount);
+        fflush(stdout);
+        return failCount == 0u ? 0 : -1;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+namespace PKAssets::Benchmark
+{
+    // Minimum number of bytes decoded per input & codec. Small inputs are decoded repeatedly for stable timings.
+    constexpr static const uint64_t PK_BENCHMARK_MIN_DECODE_BYTES = 64ull << 20ull;
+
+    // Round trips every file under the given path through each encoding variant & reports ratio and throughput.
+    // Cooked assets are benchmarked on their decoded payload.
+    int RunEncodingBenchmark(const std::string& path);
+
+    // Round trips synthetic payloads of odd sizes & small alphabets through each encoding variant, out of place & in place.
+    int RunEncodingCheck();
+}
@@ -1,40 +1,201 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <string.h>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
 #include "PKFileVersionUtilities.h"
 
 namespace PKVersionUtilities
 {
-    void GetLastWriteTimeRecursive(const std::filesystem::path& dir, std::filesystem::file_time_type& lastTime)
+    struct ManifestFile
     {
-        for (const auto& entry : std::filesystem::directory_iterator(dir))
+        uint64_t size = 0ull;
+        int64_t writeTime = 0ll;
+        uint64_t hash = 0ull;
+        bool exists = false;
+        bool isValidated = false;
+    };
+
+    struct ManifestAsset
+    {
+        uint64_t cookerHash = 0ull;
+        uint64_t inputHash = 0ull;
+        std::string source;
+    };
+
+    struct Manifest
+    {
+        std::filesystem::path srcdir;
+        std::filesystem::path dstdir;
+        uint64_t cookerHash = 0ull;
+        std::unordered_map<std::string, ManifestFile> files;
+        std::unordered_map<std::string, std::vector<std::string>> includes;
+        std::unordered_map<std::string, ManifestAsset> assets;
+        const DirectorySnapshot* sourceSnapshot = nullptr;
+        const DirectorySnapshot* destinationSnapshot = nullptr;
+        std::mutex lock;
+        bool isLoaded = false;
+        bool isDirty = false;
+    };
+
+    struct RecordCapture
+    {
+        std::map<std::string, std::vector<std::string>> includeGraph;
+        uint64_t inputHash = 0ull;
+        bool isActive = false;
+        bool isRecorded = false;
+        bool isStale = false;
+    };
+
+    static Manifest s_manifest;
+    static thread_local RecordCapture s_recordCapture;
+
+    constexpr static const uint64_t XXH_PRIME64_1 = 11400714785074694791ull;
+    constexpr static const uint64_t XXH_PRIME64_2 = 14029467366897019727ull;
+    constexpr static const uint64_t XXH_PRIME64_3 = 1609587929392839161ull;
+    constexpr static const uint64_t XXH_PRIME64_4 = 9650029242287828579ull;
+    constexpr static const uint64_t XXH_PRIME64_5 = 2870177450012600261ull;
+    constexpr static const size_t HASH_FILE_CHUNK_SIZE = 1ull << 20ull;
+    constexpr static const uint64_t HASH_MISSING_FILE = 0x9E3779B97F4A7C15ull;
+    constexpr static const char* MANIFEST_HEADER = "pkmanifest 2";
+
+    static inline uint64_t RotateLeft(uint64_t value, uint32_t count) { return (value << count) | (value >> (64u - count)); }
+    static inline uint64_t Read64(const uint8_t* ptr) { uint64_t value; memcpy(&value, ptr, sizeof(uint64_t)); return value; }
+    static inline uint32_t Read32(const uint8_t* ptr) { uint32_t value; memcpy(&value, ptr, sizeof(uint32_t)); return value; }
+
+    static inline uint64_t HashRound(uint64_t accumulator, uint64_t input)
+    {
+        accumulator += input * XXH_PRIME64_2;
+        accumulator = RotateLeft(accumulator, 31u);
+        return accumulator * XXH_PRIME64_1;
+    }
+
+    static inline uint64_t HashMergeRound(uint64_t accumulator, uint64_t value)
+    {
+        accumulator ^= HashRound(0ull, value);
+        return accumulator * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+
+    static std::string GetManifestKey(const std::filesystem::path& path, const std::filesystem::path& root)
+    {
+        return std::filesystem::path(path).lexically_normal().lexically_relative(root).generic_string();
+    }
+
+    static ManifestFile GetManifestFileStat(const std::string& key, const std::filesystem::path& path)
+    {
+        ManifestFile file;
+
+        // Files outside of the source directory are not part of the snapshot.
+        if (s_manifest.sourceSnapshot != nullptr && !key.empty() && key.compare(0u, 3u, "../") != 0)
         {
-            auto& entryPath = entry.path();
+            auto iter = s_manifest.sourceSnapshot->entries.find(key);
 
-            if (!entryPath.has_extension())
+            if (iter != s_manifest.sourceSnapshot->entries.end())
             {
-                GetLastWriteTimeRecursive(entryPath, lastTime);
-                continue;
+                file.size = iter->second.size;
+                file.writeTime = iter->second.writeTime;
+                file.exists = true;
             }
 
-            auto time = std::filesystem::last_write_time(entryPath);
+            return file;
+        }
+
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+
+        if (error)
+        {
+            return file;
+        }
+
+        auto writeTime = std::filesystem::last_write_time(path, error);
+
+        if (error)
+        {
+            return file;
+        }
+
+        file.size = (uint64_t)size;
+        file.writeTime = (int64_t)writeTime.time_since_epoch().count();
+        file.exists = true;
+        return file;
+    }
+
+    // Each file is validated at most once per manifest pass.
+    // Files whose size & write time match the record are trusted, others are rehashed.
+    static uint64_t GetManifestFileHash(const std::string& key)
+    {
+        ManifestFile recorded;
+        auto isRecorded = false;
 
-            if (time > lastTime)
+        {
+            std::lock_guard<std::mutex> lock(s_manifest.lock);
+            auto iter = s_manifest.files.find(key);
+
+            if (iter != s_manifest.files.end())
             {
-                lastTime = time;
+                if (iter->second.isValidated)
+                {
+                    return iter->second.exists ? iter->second.hash : HASH_MISSING_FILE;
+                }
+
+                recorded = iter->second;
+                isRecorded = true;
             }
         }
+
+        auto path = s_manifest.srcdir / key;
+        auto current = GetManifestFileStat(key, path);
+        current.hash = recorded.hash;
+        current.isValidated = true;
+
+        auto isStatChanged = !isRecorded || current.exists != recorded.exists || current.size != recorded.size || current.writeTime != recorded.writeTime;
+
+        if (current.exists && isStatChanged && !HashFile(path, &current.hash))
+        {
+            current = ManifestFile();
+            current.isValidated = true;
+        }
+
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+        s_manifest.files[key] = current;
+        s_manifest.isDirty |= isStatChanged;
+        return current.exists ? current.hash : HASH_MISSING_FILE;
     }
 
-    bool IsDirectoryOutOfDate(const std::filesystem::path& src, const::std::filesystem::path& dst)
+    // Combined hash of the source, its .pkmeta sidecar & all transitively included files.
+    static uint64_t GetManifestInputHash(const std::string& sourceKey)
     {
-        if (!std::filesystem::exists(dst))
+        std::vector<std::string> stack = { sourceKey };
+        std::unordered_map<std::string, bool> visited;
+        auto metaKey = sourceKey + PK_ASSET_META_EXTENSION;
+        auto metaHash = GetManifestFileHash(metaKey);
+        auto hash = HashBuffer(metaKey.data(), metaKey.size(), metaHash);
+
+        while (!stack.empty())
         {
-            return true;
+            auto key = std::move(stack.back());
+            stack.pop_back();
+
+            if (!visited.emplace(key, true).second)
+            {
+                continue;
+            }
+
+            auto fileHash = GetManifestFileHash(key);
+            hash = HashBuffer(key.data(), key.size(), hash);
+            hash = HashBuffer(&fileHash, sizeof(uint64_t), hash);
+
+            std::lock_guard<std::mutex> lock(s_manifest.lock);
+            auto iter = s_manifest.includes.find(key);
+
+            if (iter != s_manifest.includes.end())
+            {
+                stack.insert(stack.end(), iter->second.rbegin(), iter->second.rend());
+            }
         }
 
-        auto srctime = std::filesystem::file_time_type::min();
-        auto dsttime = std::filesystem::file_time_type::min();
-        GetLastWriteTimeRecursive(src, srctime);
-        GetLastWriteTimeRecursive(dst, dsttime);
-        return srctime > dsttime;
+        return hash;
     }
 
     bool IsFileOutOfDate(const std::filesystem::path& src, const::std::filesystem::path& dst)
@@ -49,29 +210,450 @@ namespace PKVersionUtilities
         return srctime > dsttime;
     }
 
-    bool IsFileAnyOutOfDate(const std::vector<std::string>& paths, const std::filesystem::file_time_type& lastTime)
+    uint64_t HashBuffer(const void* data, size_t size, uint64_t seed)
     {
+        auto bytes = static_cast<const uint8_t*>(data);
+        auto end = bytes + size;
+        uint64_t hash;
+
+        if (size >= 32ull)
+        {
+            uint64_t v[4] = { seed + XXH_PRIME64_1 + XXH_PRIME64_2, seed + XXH_PRIME64_2, seed, seed - XXH_PRIME64_1 };
+
+            for (; bytes + 32ull <= end; bytes += 32ull)
+            {
+                v[0] = HashRound(v[0], Read64(bytes + 0ull));
+                v[1] = HashRound(v[1], Read64(bytes + 8ull));
+                v[2] = HashRound(v[2], Read64(bytes + 16ull));
+                v[3] = HashRound(v[3], Read64(bytes + 24ull));
+            }
+
+            hash = RotateLeft(v[0], 1u) + RotateLeft(v[1], 7u) + RotateLeft(v[2], 12u) + RotateLeft(v[3], 18u);
+            hash = HashMergeRound(hash, v[0]);
+            hash = HashMergeRound(hash, v[1]);
+            hash = HashMergeRound(hash, v[2]);
+            hash = HashMergeRound(hash, v[3]);
+        }
+        else
+        {
+            hash = seed + XXH_PRIME64_5;
+        }
+
+        hash += (uint64_t)size;
+
+        for (; bytes + 8ull <= end; bytes += 8ull)
+        {
+            hash ^= HashRound(0ull, Read64(bytes));
+            hash = RotateLeft(hash, 27u) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        }
+
+        if (bytes + 4ull <= end)
+        {
+            hash ^= (uint64_t)Read32(bytes) * XXH_PRIME64_1;
+            hash = RotateLeft(hash, 23u) * XXH_PRIME64_2 + XXH_PRIME64_3;
+            bytes += 4ull;
+        }
+
+        for (; bytes < end; ++bytes)
+        {
+            hash ^= (uint64_t)(*bytes) * XXH_PRIME64_5;
+            hash = RotateLeft(hash, 11u) * XXH_PRIME64_1;
+        }
+
+        hash ^= hash >> 33u;
+        hash *= XXH_PRIME64_2;
+        hash ^= hash >> 29u;
+        hash *= XXH_PRIME64_3;
+        hash ^= hash >> 32u;
+        return hash;
+    }
+
+    bool HashFile(const std::filesystem::path& path, uint64_t* outHash)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+
+        if (!file)
+        {
+            return false;
+        }
+
+        // Chunks are chained through the seed to avoid loading large source files in their entirety.
+        std::vector<char> chunk(HASH_FILE_CHUNK_SIZE);
+        auto hash = 0ull;
+
+        while (file)
+        {
+            file.read(chunk.data(), chunk.size());
+            auto count = (size_t)file.gcount();
+
+            if (count > 0ull)
+            {
+                hash = HashBuffer(chunk.data(), count, hash);
+            }
+        }
+
+        *outHash = hash;
+        return true;
+    }
+
+    void LoadManifest(const std::filesystem::path& srcdir, const std::filesystem::path& dstdir, uint64_t cookerHash)
+    {
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+        s_manifest.srcdir = srcdir.lexically_normal();
+        s_manifest.dstdir = dstdir.lexically_normal();
+        s_manifest.cookerHash = cookerHash;
+        s_manifest.files.clear();
+        s_manifest.includes.clear();
+        s_manifest.assets.clear();
+        s_manifest.isLoaded = true;
+        s_manifest.isDirty = false;
+
+        std::ifstream file(s_manifest.dstdir / PK_ASSET_MANIFEST_FILENAME, std::ios::in);
+        std::string lineBuffer;
+
+        if (!file || !std::getline(file, lineBuffer) || lineBuffer != MANIFEST_HEADER)
+        {
+            return;
+        }
+
+        // Format (paths are tab separated & relative to the source or destination directory):
+        // file <exists> <size> <write time> <hash>\t<source path>
+        // include <source path>\t<included path>
+        // asset <cooker hash> <input hash>\t<source path>\t<destination path>
+        while (std::getline(file, lineBuffer))
+        {
+            auto tab0 = lineBuffer.find('\t');
+            auto tab1 = tab0 != std::string::npos ? lineBuffer.find('\t', tab0 + 1u) : std::string::npos;
+
+            if (tab0 == std::string::npos)
+            {
+                continue;
+            }
+
+            int exists = 0;
+            unsigned long long size = 0ull;
+            long long writeTime = 0ll;
+            unsigned long long hash = 0ull;
+            unsigned long long hash1 = 0ull;
+
+            if (sscanf(lineBuffer.c_str(), "file %i %llu %lld %llx", &exists, &size, &writeTime, &hash) == 4)
+            {
+                auto& entry = s_manifest.files[lineBuffer.substr(tab0 + 1u)];
+                entry.exists = exists != 0;
+                entry.size = size;
+                entry.writeTime = writeTime;
+                entry.hash = hash;
+                continue;
+            }
+
+            if (lineBuffer.compare(0u, 8u, "include ") == 0)
+            {
+                s_manifest.includes[lineBuffer.substr(8u, tab0 - 8u)].push_back(lineBuffer.substr(tab0 + 1u));
+                continue;
+            }
+
+            if (tab1 != std::string::npos && sscanf(lineBuffer.c_str(), "asset %llx %llx", &hash, &hash1) == 2)
+            {
+                auto& asset = s_manifest.assets[lineBuffer.substr(tab1 + 1u)];
+                asset.cookerHash = hash;
+                asset.inputHash = hash1;
+                asset.source = lineBuffer.substr(tab0 + 1u, tab1 - tab0 - 1u);
+            }
+        }
+    }
+
+    void SaveManifest()
+    {
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+
+        if (!s_manifest.isLoaded || !s_manifest.isDirty)
+        {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(s_manifest.dstdir, error);
+
+        auto path = (s_manifest.dstdir / PK_ASSET_MANIFEST_FILENAME).string();
+        auto file = fopen(path.c_str(), "w");
+
+        if (file == nullptr)
+        {
+            printf("Failed to write build manifest: %s \n", path.c_str());
+            return;
+        }
+
+        fprintf(file, "%s\n", MANIFEST_HEADER);
+
+        for (const auto& kv : s_manifest.files)
+        {
+            fprintf(file, "file %i %llu %lld %llx\t%s\n", kv.second.exists ? 1 : 0, (unsigned long long)kv.second.size, (long long)kv.second.writeTime, (unsigned long long)kv.second.hash, kv.first.c_str());
+        }
+
+        for (const auto& kv : s_manifest.includes)
+        {
+            for (const auto& include : kv.second)
+            {
+                fprintf(file, "include %s\t%s\n", kv.first.c_str(), include.c_str());
+            }
+        }
+
+        for (const auto& kv : s_manifest.assets)
+        {
+            fprintf(file, "asset %llx %llx\t%s\t%s\n", (unsigned long long)kv.second.cookerHash, (unsigned long long)kv.second.inputHash, kv.second.source.c_str(), kv.first.c_str());
+        }
+
+        fclose(file);
+        s_manifest.isDirty = false;
+    }
+
+    bool IsAssetOutOfDate(const std::string& pathSrc, const std::string& pathDst)
+    {
+        if (!s_manifest.isLoaded)
+        {
+            return IsFileOutOfDate(pathSrc, pathDst);
+        }
+
+        // Inputs are validated before the output is checked so that stale assets are cooked from the hashed contents.
+        auto sourceKey = GetManifestKey(pathSrc, s_manifest.srcdir);
+        auto inputHash = GetManifestInputHash(sourceKey);
+
+        auto isOutputMissing = s_manifest.destinationSnapshot != nullptr ?
+            FindSnapshotEntry(*s_manifest.destinationSnapshot, pathDst) == nullptr :
+            !std::filesystem::exists(pathDst);
+
+        // Worker manifests are not updated with the records of other processes. The caller has already validated the asset.
+        if (isOutputMissing || (s_recordCapture.isActive && s_recordCapture.isStale))
+        {
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+        auto iter = s_manifest.assets.find(GetManifestKey(pathDst, s_manifest.dstdir));
+        return iter == s_manifest.assets.end() || iter->second.cookerHash != s_manifest.cookerHash || iter->second.source != sourceKey || iter->second.inputHash != inputHash;
+    }
+
+    void ValidateIncludeGraph(const std::map<std::string, std::vector<std::string>>& includeGraph)
+    {
+        if (!s_manifest.isLoaded)
+        {
+            return;
+        }
+
+        for (const auto& kv : includeGraph)
+        {
+            GetManifestFileHash(GetManifestKey(kv.first, s_manifest.srcdir));
+        }
+    }
+
+    static void RecordIncludeGraph(const std::map<std::string, std::vector<std::string>>& includeGraph)
+    {
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+
+        for (const auto& kv : includeGraph)
+        {
+            auto& includes = s_manifest.includes[GetManifestKey(kv.first, s_manifest.srcdir)];
+            includes.clear();
+
+            for (const auto& include : kv.second)
+            {
+                includes.push_back(GetManifestKey(include, s_manifest.srcdir));
+            }
+        }
+    }
+
+    static void RecordAssetInputHash(const std::string& sourceKey, const std::string& pathDst, uint64_t inputHash)
+    {
+        ManifestAsset asset;
+        asset.cookerHash = s_manifest.cookerHash;
+        asset.inputHash = inputHash;
+        asset.source = sourceKey;
+
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+        s_manifest.assets[GetManifestKey(pathDst, s_manifest.dstdir)] = std::move(asset);
+        s_manifest.isDirty = true;
+    }
+
+    // File hashes are not revalidated after the cook. Inputs that change while an asset is cooked are detected by the next run.
+    void RecordAsset(const std::string& pathSrc, const std::string& pathDst, const std::map<std::string, std::vector<std::string>>& includeGraph)
+    {
+        auto inputHash = 0ull;
+
+        if (s_manifest.isLoaded)
+        {
+            auto sourceKey = GetManifestKey(pathSrc, s_manifest.srcdir);
+            RecordIncludeGraph(includeGraph);
+            inputHash = GetManifestInputHash(sourceKey);
+            RecordAssetInputHash(sourceKey, pathDst, inputHash);
+        }
+
+        if (s_recordCapture.isActive)
+        {
+            s_recordCapture.includeGraph = includeGraph;
+            s_recordCapture.inputHash = inputHash;
+            s_recordCapture.isRecorded = true;
+        }
+    }
+
+    void RecordAsset(const std::string& pathSrc, const std::string& pathDst, const std::map<std::string, std::vector<std::string>>& includeGraph, uint64_t inputHash)
+    {
+        if (s_manifest.isLoaded)
+        {
+            RecordIncludeGraph(includeGraph);
+            RecordAssetInputHash(GetManifestKey(pathSrc, s_manifest.srcdir), pathDst, inputHash);
+        }
+    }
+
+    void BeginRecordCapture(bool isStale)
+    {
+        s_recordCapture.includeGraph.clear();
+        s_recordCapture.inputHash = 0ull;
+        s_recordCapture.isActive = true;
+        s_recordCapture.isRecorded = false;
+        s_recordCapture.isStale = isStale;
+    }
+
+    bool EndRecordCapture(std::map<std::string, std::vector<std::string>>& outIncludeGraph, uint64_t* outInputHash)
+    {
+        s_recordCapture.isActive = false;
+        outIncludeGraph = std::move(s_recordCapture.includeGraph);
+        s_recordCapture.includeGraph.clear();
+        *outInputHash = s_recordCapture.inputHash;
+        return s_recordCapture.isRecorded;
+    }
+
+    void InvalidateFiles(const std::vector<std::string>& paths)
+    {
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+
         for (const auto& path : paths)
         {
-            if (std::filesystem::exists(path))
+            auto iter = s_manifest.files.find(GetManifestKey(path, s_manifest.srcdir));
+
+            if (iter != s_manifest.files.end())
             {
-                if (std::filesystem::last_write_time(path) > lastTime)
+                iter->second.isValidated = false;
+            }
+        }
+    }
+
+    void GetDependentSources(const std::vector<std::string>& paths, std::vector<std::string>& outSources)
+    {
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+        std::unordered_map<std::string, std::vector<std::string>> includers;
+        std::unordered_map<std::string, bool> sources;
+        std::unordered_map<std::string, bool> visited;
+        std::vector<std::string> stack;
+
+        for (const auto& kv : s_manifest.includes)
+        {
+            for (const auto& include : kv.second)
+            {
+                includers[include].push_back(kv.first);
+            }
+        }
+
+        for (const auto& kv : s_manifest.assets)
+        {
+            sources[kv.second.source] = true;
+        }
+
+        for (const auto& path : paths)
+        {
+            auto key = GetManifestKey(path, s_manifest.srcdir);
+            auto metaExtensionLength = strlen(PK_ASSET_META_EXTENSION);
+
+            if (key.size() > metaExtensionLength && key.compare(key.size() - metaExtensionLength, metaExtensionLength, PK_ASSET_META_EXTENSION) == 0)
+            {
+                key.resize(key.size() - metaExtensionLength);
+            }
+
+            stack.push_back(key);
+        }
+
+        while (!stack.empty())
+        {
+            auto key = std::move(stack.back());
+            stack.pop_back();
+
+            if (!visited.emplace(key, true).second)
+            {
+                continue;
+            }
+
+            if (sources.count(key) > 0)
+            {
+                outSources.push_back((s_manifest.srcdir / key).lexically_normal().string());
+            }
+
+            auto iter = includers.find(key);
+
+            if (iter != includers.end())
+            {
+                stack.insert(stack.end(), iter->second.begin(), iter->second.end());
+            }
+        }
+    }
+
+    bool IsExternalFileChanged()
+    {
+        std::vector<std::pair<std::string, uint64_t>> externals;
+
+        {
+            std::lock_guard<std::mutex> lock(s_manifest.lock);
+
+            for (const auto& kv : s_manifest.files)
+            {
+                if (kv.first.compare(0u, 3u, "../") == 0)
                 {
-                    return true;
+                    externals.emplace_back(kv.first, kv.second.exists ? kv.second.hash : HASH_MISSING_FILE);
                 }
             }
         }
 
+        for (const auto& external : externals)
+        {
+            if (GetManifestFileHash(external.first) != external.second)
+            {
+                return true;
+            }
+        }
+
         return false;
     }
 
-    std::filesystem::file_time_type GetLastWriteTime(const std::filesystem::path& path)
+    void InvalidateAllFiles()
+    {
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+
+        for (auto& kv : s_manifest.files)
+        {
+            kv.second.isValidated = false;
+        }
+    }
+
+    bool GetFileHash(const std::string& path, uint64_t* outHash)
     {
-        if (!std::filesystem::exists(path))
+        if (!s_manifest.isLoaded)
+        {
+            return HashFile(path, outHash);
+        }
+
+        auto hash = GetManifestFileHash(GetManifestKey(path, s_manifest.srcdir));
+
+        if (hash == HASH_MISSING_FILE)
         {
-            return std::filesystem::file_time_type();
+            return false;
         }
 
-        return std::filesystem::last_write_time(path);
+        *outHash = hash;
+        return true;
+    }
+
+    void SetSnapshots(const DirectorySnapshot* source, const DirectorySnapshot* destination)
+    {
+        std::lock_guard<std::mutex> lock(s_manifest.lock);
+        s_manifest.sourceSnapshot = source;
+        s_manifest.destinationSnapshot = destination;
     }
 }
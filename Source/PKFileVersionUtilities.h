@@ -1,13 +1,54 @@
 #pragma once
 #include <stdio.h>
+#include <stdint.h>
 #include <filesystem>
 #include <vector>
+#include <map>
+#include "PKDirectorySnapshot.h"
 
 namespace PKVersionUtilities
 {
-    void GetLastWriteTimeRecursive(const std::filesystem::path& dir, std::filesystem::file_time_type& lastTime);
-    bool IsDirectoryOutOfDate(const std::filesystem::path& src, const std::filesystem::path& dst);
+    // Bump when cooked output changes without a change in the source assets.
+    constexpr static const uint64_t PK_ASSET_TOOLS_VERSION = 6ull;
+    constexpr static const char* PK_ASSET_MANIFEST_FILENAME = ".pkmanifest";
+    constexpr static const char* PK_ASSET_META_EXTENSION = ".pkmeta";
+
     bool IsFileOutOfDate(const std::filesystem::path& src, const std::filesystem::path& dst);
-    bool IsFileAnyOutOfDate(const std::vector<std::string>& paths, const std::filesystem::file_time_type& lastTime);
-    std::filesystem::file_time_type GetLastWriteTime(const std::filesystem::path& path);
-}
\ No newline at end of file
+
+    uint64_t HashBuffer(const void* data, size_t size, uint64_t seed = 0ull);
+    bool HashFile(const std::filesystem::path& path, uint64_t* outHash);
+
+    // Content hash based build manifest. Persisted in the destination directory.
+    // Each output records a combined hash of its source, .pkmeta sidecar, transitive includes & the cooker version.
+    // Shader include edges are persisted so that up to date shaders can be validated without reading their sources.
+    // File size & write time are recorded alongside the hashes so that unchanged files dont need to be rehashed.
+    void LoadManifest(const std::filesystem::path& srcdir, const std::filesystem::path& dstdir, uint64_t cookerHash);
+    void SaveManifest();
+    bool IsAssetOutOfDate(const std::string& pathSrc, const std::string& pathDst);
+
+    // Files outside of the source directory are not part of its snapshot. Validates the recorded ones by their size & write time or contents.
+    bool IsExternalFileChanged();
+
+    // File metadata queries are served from the snapshots while set. Snapshots must not change while set.
+    void SetSnapshots(const DirectorySnapshot* source, const DirectorySnapshot* destination);
+
+    // Content hash of a source file. Reuses the hashes validated by the manifest during this run.
+    bool GetFileHash(const std::string& path, uint64_t* outHash);
+
+    // Assets record the input hashes validated before their cook. IsAssetOutOfDate validates the source, .pkmeta & previously recorded includes.
+    // Files discovered while cooking must be validated as they are read, before the output is produced.
+    void ValidateIncludeGraph(const std::map<std::string, std::vector<std::string>>& includeGraph);
+    void RecordAsset(const std::string& pathSrc, const std::string& pathDst, const std::map<std::string, std::vector<std::string>>& includeGraph);
+    void RecordAsset(const std::string& pathSrc, const std::string& pathDst, const std::map<std::string, std::vector<std::string>>& includeGraph, uint64_t inputHash);
+
+    // Worker processes forward the include graph & input hash of assets recorded on the calling thread to the main process which owns the manifest.
+    // Assets captured as stale are reported out of date by IsAssetOutOfDate. Their inputs are still hashed.
+    void BeginRecordCapture(bool isStale);
+    bool EndRecordCapture(std::map<std::string, std::vector<std::string>>& outIncludeGraph, uint64_t* outInputHash);
+
+    // Used by watch mode. Invalidated files are revalidated on their next query.
+    // Dependent sources are the recorded asset sources that directly or transitively include any of the given files.
+    void InvalidateFiles(const std::vector<std::string>& paths);
+    void InvalidateAllFiles();
+    void GetDependentSources(const std::vector<std::string>& paths, std::vector<std::string>& outSources);
+}
@@ -0,0 +1,310 @@
+#include <filesystem>
+#include <algorithm>
+#include <unordered_map>
+#include "PKFileWatcher.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace PKAssets
+{
+    constexpr static const size_t FILE_WATCHER_BUFFER_SIZE = 64ull * 1024ull;
+
+#ifdef _WIN32
+    struct FileWatcher
+    {
+        std::filesystem::path root;
+        HANDLE directory = INVALID_HANDLE_VALUE;
+        HANDLE event = nullptr;
+        OVERLAPPED overlapped{};
+        bool isPending = false;
+        alignas(DWORD) uint8_t buffer[FILE_WATCHER_BUFFER_SIZE];
+    };
+
+    FileWatcher* CreateFileWatcher(const std::string& directory)
+    {
+        auto watcher = new FileWatcher();
+        watcher->root = std::filesystem::path(directory).lexically_normal();
+        watcher->directory = CreateFileW(watcher->root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        watcher->event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+        if (watcher->directory == INVALID_HANDLE_VALUE || watcher->event == nullptr)
+        {
+            DestroyFileWatcher(watcher);
+            return nullptr;
+        }
+
+        watcher->overlapped.hEvent = watcher->event;
+        return watcher;
+    }
+
+    void DestroyFileWatcher(FileWatcher* watcher)
+    {
+        if (watcher == nullptr)
+        {
+            return;
+        }
+
+        if (watcher->directory != INVALID_HANDLE_VALUE)
+        {
+            CancelIo(watcher->directory);
+            CloseHandle(watcher->directory);
+        }
+
+        if (watcher->event != nullptr)
+        {
+            CloseHandle(watcher->event);
+        }
+
+        delete watcher;
+    }
+
+    // Negative timeout blocks indefinitely. Returns true on timeout.
+    static bool ReadChanges(FileWatcher* watcher, int32_t timeoutMilliseconds, std::vector<std::string>& outPaths)
+    {
+        if (!watcher->isPending)
+        {
+            const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+            ResetEvent(watcher->event);
+
+            if (!ReadDirectoryChangesW(watcher->directory, watcher->buffer, (DWORD)FILE_WATCHER_BUFFER_SIZE, TRUE, filter, nullptr, &watcher->overlapped, nullptr))
+            {
+                return false;
+            }
+
+            watcher->isPending = true;
+        }
+
+        auto waitResult = WaitForSingleObject(watcher->event, timeoutMilliseconds < 0 ? INFINITE : (DWORD)timeoutMilliseconds);
+
+        if (waitResult == WAIT_TIMEOUT)
+        {
+            return true;
+        }
+
+        DWORD byteCount = 0u;
+        watcher->isPending = false;
+
+        if (waitResult != WAIT_OBJECT_0 || !GetOverlappedResult(watcher->directory, &watcher->overlapped, &byteCount, FALSE))
+        {
+            return false;
+        }
+
+        // Zero bytes means that the buffer overflowed. Report the root so that the caller rescans everything.
+        if (byteCount == 0u)
+        {
+            outPaths.push_back(watcher->root.string());
+            return true;
+        }
+
+        auto head = watcher->buffer;
+
+        while (true)
+        {
+            auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(head);
+            auto name = std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            outPaths.push_back((watcher->root / name).lexically_normal().string());
+
+            if (info->NextEntryOffset == 0u)
+            {
+                break;
+            }
+
+            head += info->NextEntryOffset;
+        }
+
+        return true;
+    }
+#else
+    struct FileWatcher
+    {
+        std::filesystem::path root;
+        int descriptor = -1;
+        std::unordered_map<int, std::filesystem::path> directories;
+        alignas(inotify_event) uint8_t buffer[FILE_WATCHER_BUFFER_SIZE];
+    };
+
+    // inotify is not recursive. Each directory needs its own watch.
+    static void AddWatchRecursive(FileWatcher* watcher, const std::filesystem::path& directory, std::vector<std::string>* outPaths)
+    {
+        const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+        auto descriptor = inotify_add_watch(watcher->descriptor, directory.c_str(), mask);
+
+        if (descriptor >= 0)
+        {
+            watcher->directories[descriptor] = directory;
+        }
+
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.is_directory(error))
+            {
+                AddWatchRecursive(watcher, entry.path(), outPaths);
+            }
+            else if (outPaths != nullptr)
+            {
+                // Files created before the watch was added would otherwise be missed.
+                outPaths->push_back(entry.path().string());
+            }
+        }
+    }
+
+    FileWatcher* CreateFileWatcher(const std::string& directory)
+    {
+        auto watcher = new FileWatcher();
+        watcher->descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (watcher->descriptor < 0)
+        {
+            DestroyFileWatcher(watcher);
+            return nullptr;
+        }
+
+        watcher->root = std::filesystem::path(directory).lexically_normal();
+        AddWatchRecursive(watcher, watcher->root, nullptr);
+        return watcher;
+    }
+
+    void DestroyFileWatcher(FileWatcher* watcher)
+    {
+        if (watcher == nullptr)
+        {
+            return;
+        }
+
+        if (watcher->descriptor >= 0)
+        {
+            close(watcher->descriptor);
+        }
+
+        delete watcher;
+    }
+
+    // Negative timeout blocks indefinitely. Returns true on timeout.
+    static bool ReadChanges(FileWatcher* watcher, int32_t timeoutMilliseconds, std::vector<std::string>& outPaths)
+    {
+        pollfd descriptor{};
+        descriptor.fd = watcher->descriptor;
+        descriptor.events = POLLIN;
+
+        auto pollResult = poll(&descriptor, 1, timeoutMilliseconds);
+
+        if (pollResult == 0)
+        {
+            return true;
+        }
+
+        if (pollResult < 0)
+        {
+            return errno == EINTR;
+        }
+
+        while (true)
+        {
+            auto byteCount = read(watcher->descriptor, watcher->buffer, FILE_WATCHER_BUFFER_SIZE);
+
+            if (byteCount <= 0)
+            {
+                return byteCount == 0 || errno == EAGAIN || errno == EINTR;
+            }
+
+            for (auto head = watcher->buffer; head < watcher->buffer + byteCount;)
+            {
+                auto event = reinterpret_cast<const inotify_event*>(head);
+                head += sizeof(inotify_event) + event->len;
+
+                // Events were dropped. Report the root so that the caller rescans everything.
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    outPaths.push_back(watcher->root.string());
+                    continue;
+                }
+
+                if (event->mask & IN_IGNORED)
+                {
+                    watcher->directories.erase(event->wd);
+                    continue;
+                }
+
+                auto iter = watcher->directories.find(event->wd);
+
+                if (iter == watcher->directories.end() || event->len == 0u)
+                {
+                    continue;
+                }
+
+                auto path = iter->second / event->name;
+
+                if (event->mask & IN_ISDIR)
+                {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        AddWatchRecursive(watcher, path, &outPaths);
+                    }
+
+                    // Removed directories are reported so that the caller revalidates everything below them.
+                    if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                    {
+                        outPaths.push_back(path.string());
+                    }
+
+                    continue;
+                }
+
+                // Created files are reported once closed after writing.
+                if (event->mask & IN_CREATE)
+                {
+                    continue;
+                }
+
+                outPaths.push_back(path.string());
+            }
+        }
+    }
+#endif
+
+    bool WaitForChanges(FileWatcher* watcher, uint32_t settleMilliseconds, std::vector<std::string>& outPaths, std::chrono::steady_clock::time_point* outFirstChangeTime)
+    {
+        auto firstIndex = outPaths.size();
+
+        while (outPaths.size() == firstIndex)
+        {
+            if (!ReadChanges(watcher, -1, outPaths))
+            {
+                return false;
+            }
+        }
+
+        if (outFirstChangeTime != nullptr)
+        {
+            *outFirstChangeTime = std::chrono::steady_clock::now();
+        }
+
+        while (true)
+        {
+            auto count = outPaths.size();
+
+            if (!ReadChanges(watcher, (int32_t)settleMilliseconds, outPaths))
+            {
+                return false;
+            }
+
+            if (outPaths.size() == count)
+            {
+                break;
+            }
+        }
+
+        std::sort(outPaths.begin() + firstIndex, outPaths.end());
+        outPaths.erase(std::unique(outPaths.begin() + firstIndex, outPaths.end()), outPaths.end());
+        return true;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace PKAssets
+{
+    // Recursive directory change notifications.
+    // Uses inotify on linux & ReadDirectoryChangesW on windows.
+    struct FileWatcher;
+
+    FileWatcher* CreateFileWatcher(const std::string& directory);
+    void DestroyFileWatcher(FileWatcher* watcher);
+
+    // Blocks until a change is observed & then keeps collecting changes until none arrive within the settle time.
+    // Editors usually emit several events per save. Returns false if the watcher is no longer usable.
+    bool WaitForChanges(FileWatcher* watcher, uint32_t settleMilliseconds, std::vector<std::string>& outPaths, std::chrono::steady_clock::time_point* outFirstChangeTime = nullptr);
+}
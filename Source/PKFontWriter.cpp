@@ -1,23 +1,50 @@
 #include <msdf-atlas-gen/msdf-atlas-gen.h>
+#include <PKAssetEncoding.h>
 #include "PKStringUtilities.h"
 #include "PKAssetWriter.h"
 #include "PKFileVersionUtilities.h"
+#include "PKCookCache.h"
+#include "PKLogUtilities.h"
+#include "PKProfiler.h"
 
 namespace PKAssets::Font
 {
     using namespace msdf_atlas;
 
+    // FreeType initialization is kept resident per cook thread.
+    struct FreetypeContext
+    {
+        msdfgen::FreetypeHandle* handle = msdfgen::initializeFreetype();
+
+        ~FreetypeContext()
+        {
+            if (handle != nullptr)
+            {
+                msdfgen::deinitializeFreetype(handle);
+            }
+        }
+    };
+
     int WriteFont(const char* pathSrc, const char* pathDst, const size_t pathStemOffset)
     {
-        if (!PKVersionUtilities::IsFileOutOfDate(pathSrc, pathDst))
+        if (!PKVersionUtilities::IsAssetOutOfDate(pathSrc, pathDst))
         {
             return 1;
         }
 
+        auto cacheKey = CookCache::GetKey(pathSrc, pathDst);
+
+        if (CookCache::Restore(cacheKey, pathDst, pathStemOffset))
+        {
+            PKVersionUtilities::RecordAsset(pathSrc, pathDst, {});
+            return 0;
+        }
+
         auto filename = StringUtilities::ReadFileName(pathSrc);
-        printf("Preprocessing font: %s \n", filename.c_str());
+        LogUtilities::Printf("Preprocessing font: %s \n", filename.c_str());
 
-        msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
+        static thread_local FreetypeContext context;
+        msdfgen::FreetypeHandle* ft = context.handle;
 
         if (ft == nullptr)
         {
@@ -28,7 +55,6 @@ namespace PKAssets::Font
 
         if (font == nullptr)
         {
-            msdfgen::deinitializeFreetype(ft);
             return -1;
         }
 
@@ -61,7 +87,11 @@ namespace PKAssets::Font
         ImmediateAtlasGenerator<float, 4, &mtsdfGenerator, BitmapAtlasStorage<byte, 4>> generator(width, height);
         generator.setAttributes(attributes);
         generator.setThreadCount(4);
-        generator.generate(glyphs.data(), glyphs.size());
+
+        {
+            PK_PROFILE_SCOPE("msdf generate");
+            generator.generate(glyphs.data(), glyphs.size());
+        }
 
         characters.reserve(glyphs.size());
 
@@ -85,15 +115,15 @@ namespace PKAssets::Font
         }
 
         const auto metrics = fontGeometry.getMetrics();
-        printf("    Characters: %s\n", charactersString.c_str());
-        printf("    Ascender: %4.2f\n", (float)metrics.ascenderY * invScale);
-        printf("    Descender: %4.2f\n", (float)metrics.descenderY * invScale);
-        printf("    Line height: %4.2f\n", (float)metrics.lineHeight * invScale);
-        printf("    Underline: %4.2f\n", (float)metrics.underlineY * invScale);
-        printf("    Underline thickness: %4.2f\n", (float)metrics.underlineThickness * invScale);
-        printf("    Width: %i\n", width);
-        printf("    Height: %i\n", height);
-        printf("    Glyph Count: %i\n", (int)glyphs.size());
+        LogUtilities::Printf("    Characters: %s\n", charactersString.c_str());
+        LogUtilities::Printf("    Ascender: %4.2f\n", (float)metrics.ascenderY * invScale);
+        LogUtilities::Printf("    Descender: %4.2f\n", (float)metrics.descenderY * invScale);
+        LogUtilities::Printf("    Line height: %4.2f\n", (float)metrics.lineHeight * invScale);
+        LogUtilities::Printf("    Underline: %4.2f\n", (float)metrics.underlineY * invScale);
+        LogUtilities::Printf("    Underline thickness: %4.2f\n", (float)metrics.underlineThickness * invScale);
+        LogUtilities::Printf("    Width: %i\n", width);
+        LogUtilities::Printf("    Height: %i\n", height);
+        LogUtilities::Printf("    Glyph Count: %i\n", (int)glyphs.size());
 
         auto buffer = PKAssetBuffer();
         buffer.header->type = PKAssetType::Font;
@@ -112,13 +142,20 @@ namespace PKAssets::Font
         msdfgen::BitmapConstRef<byte, 4> bitmap = generator.atlasStorage();
         auto pAtlasData = buffer.Write(bitmap.pixels, bitmap.width * bitmap.height * 4);
         pkFont->atlasData.Set(buffer.data(), pAtlasData.get());
+        buffer.AddFilter(pAtlasData, bitmap.width * bitmap.height * 4, 4u, PK_ASSET_ENCODE_FILTER_DELTA);
         pkFont->atlasResolution[0] = bitmap.width;
         pkFont->atlasResolution[1] = bitmap.height;
         pkFont->atlasDataSize = bitmap.width* bitmap.height * 4;
 
         msdfgen::destroyFont(font);
-        msdfgen::deinitializeFreetype(ft);
 
-        return WriteAsset(pathDst, pathStemOffset, buffer, false);
+        if (WriteAsset(pathDst, pathStemOffset, buffer, false) != 0)
+        {
+            return -1;
+        }
+
+        CookCache::Store(cacheKey, pathDst);
+        PKVersionUtilities::RecordAsset(pathSrc, pathDst, {});
+        return 0;
     }
 }
\ No newline at end of file
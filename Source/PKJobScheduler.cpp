@@ -0,0 +1,127 @@
+#include "PKJobScheduler.h"
+
+namespace PKAssets
+{
+    JobScheduler::JobScheduler(uint32_t threadCount)
+    {
+        threadCount = threadCount > 0u ? threadCount : 1u;
+        workers.reserve(threadCount);
+
+        for (auto i = 0u; i < threadCount; ++i)
+        {
+            workers.emplace_back(std::make_unique<Worker>());
+        }
+
+        for (auto i = 0u; i < threadCount; ++i)
+        {
+            workers[i]->thread = std::thread(&JobScheduler::WorkerLoop, this, i);
+        }
+    }
+
+    JobScheduler::~JobScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(signalLock);
+            isStopping = true;
+        }
+
+        workSignal.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker->thread.join();
+        }
+    }
+
+    void JobScheduler::Enqueue(Job&& job)
+    {
+        auto& worker = *workers[nextWorker++ % workers.size()];
+
+        {
+            std::lock_guard<std::mutex> lock(worker.lock);
+            worker.queue.push_back(std::move(job));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(signalLock);
+            queuedCount++;
+            pendingCount++;
+        }
+
+        workSignal.notify_one();
+    }
+
+    void JobScheduler::Wait()
+    {
+        std::unique_lock<std::mutex> lock(signalLock);
+        idleSignal.wait(lock, [this]() { return pendingCount == 0ull; });
+    }
+
+    bool JobScheduler::TryPop(uint32_t index, Job& outJob)
+    {
+        auto& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.lock);
+
+        if (worker.queue.empty())
+        {
+            return false;
+        }
+
+        outJob = std::move(worker.queue.front());
+        worker.queue.pop_front();
+        queuedCount--;
+        return true;
+    }
+
+    bool JobScheduler::TrySteal(uint32_t index, Job& outJob)
+    {
+        for (auto i = 1u; i < workers.size(); ++i)
+        {
+            auto& victim = *workers[(index + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.lock);
+
+            if (victim.queue.empty())
+            {
+                continue;
+            }
+
+            outJob = std::move(victim.queue.back());
+            victim.queue.pop_back();
+            queuedCount--;
+            return true;
+        }
+
+        return false;
+    }
+
+    void JobScheduler::WorkerLoop(uint32_t index)
+    {
+        Job job;
+
+        while (true)
+        {
+            if (TryPop(index, job) || TrySteal(index, job))
+            {
+                job();
+                job = nullptr;
+
+                std::lock_guard<std::mutex> lock(signalLock);
+
+                if (--pendingCount == 0ull)
+                {
+                    idleSignal.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(signalLock);
+            workSignal.wait(lock, [this]() { return isStopping || queuedCount > 0ull; });
+
+            if (isStopping && queuedCount == 0ull)
+            {
+                return;
+            }
+        }
+    }
+}
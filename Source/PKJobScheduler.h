@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace PKAssets
+{
+    // Work stealing thread pool.
+    // Jobs are distributed round robin to per worker queues.
+    // Workers consume their own queue from the front & steal from the back of other queues when idle.
+    // Jobs may enqueue further jobs. Wait returns once all of them have completed.
+    struct JobScheduler
+    {
+        typedef std::function<void()> Job;
+
+        JobScheduler(uint32_t threadCount);
+        ~JobScheduler();
+
+        JobScheduler(const JobScheduler&) = delete;
+        JobScheduler& operator=(const JobScheduler&) = delete;
+
+        void Enqueue(Job&& job);
+        void Wait();
+
+        inline uint32_t GetThreadCount() const { return (uint32_t)workers.size(); }
+
+        private:
+            struct Worker
+            {
+                std::mutex lock;
+                std::deque<Job> queue;
+                std::thread thread;
+            };
+
+            bool TryPop(uint32_t index, Job& outJob);
+            bool TrySteal(uint32_t index, Job& outJob);
+            void WorkerLoop(uint32_t index);
+
+            std::vector<std::unique_ptr<Worker>> workers;
+            std::mutex signalLock;
+            std::condition_variable workSignal;
+            std::condition_variable idleSignal;
+            std::atomic<size_t> queuedCount = 0ull;
+            size_t pendingCount = 0ull;
+            std::atomic<uint32_t> nextWorker = 0u;
+            bool isStopping = false;
+    };
+}
@@ -0,0 +1,221 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <filesystem>
+#include <PKAssetLoader.h>
+#include <PKAssetBatchLoader.h>
+#include <PKAssetUring.h>
+#include "PKLoadingBenchmark.h"
+
+namespace PKAssets::Benchmark
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct LoadingCounters
+    {
+        std::atomic<uint32_t> failCount = 0u;
+    };
+
+    static void OnAssetLoaded(void* userData, uint32_t, const char*, PKAsset* asset, int result)
+    {
+        auto counters = static_cast<LoadingCounters*>(userData);
+
+        if (result != 0)
+        {
+            counters->failCount++;
+            return;
+        }
+
+        CloseAsset(asset);
+    }
+
+    // Returns the duration of the fastest pass & the number of failed loads in it.
+    static double RunSerialPasses(const std::vector<const char*>& filepaths, uint32_t* outFailCount)
+    {
+        auto bestTime = 0.0;
+
+        for (auto pass = 0u; pass < PK_BENCHMARK_LOAD_PASS_COUNT; ++pass)
+        {
+            auto failCount = 0u;
+            auto start = Clock::now();
+
+            for (auto filepath : filepaths)
+            {
+                PKAsset asset{};
+
+                if (OpenAsset(filepath, &asset) != 0)
+                {
+                    failCount++;
+                    continue;
+                }
+
+                CloseAsset(&asset);
+            }
+
+            auto time = std::chrono::duration<double>(Clock::now() - start).count();
+            bestTime = pass == 0u || time < bestTime ? time : bestTime;
+            *outFailCount = failCount;
+        }
+
+        return bestTime;
+    }
+
+    static double RunBatchPasses(const std::vector<const char*>& filepaths, uint32_t flags, uint32_t* outFailCount)
+    {
+        auto bestTime = 0.0;
+
+        for (auto pass = 0u; pass < PK_BENCHMARK_LOAD_PASS_COUNT; ++pass)
+        {
+            LoadingCounters counters;
+            auto start = Clock::now();
+            auto loader = CreateAssetBatchLoader(1u, 0u, 0ull, flags);
+            LoadAssetsAsync(loader, filepaths.data(), (uint32_t)filepaths.size(), OnAssetLoaded, &counters);
+            DestroyAssetBatchLoader(loader);
+
+            auto time = std::chrono::duration<double>(Clock::now() - start).count();
+            bestTime = pass == 0u || time < bestTime ? time : bestTime;
+            *outFailCount = counters.failCount;
+        }
+
+        return bestTime;
+    }
+
+    // File I/O only. Loads are begun & read through stdio or io_uring & cancelled instead of decoded.
+    static double RunReadPasses(const std::vector<const char*>& filepaths, PKAssetUring* ring, uint32_t* outFailCount)
+    {
+        auto bestTime = 0.0;
+        PKAssetLoad loads[PK_ASSET_URING_BATCH_SIZE];
+        PKAssetLoad* loadPointers[PK_ASSET_URING_BATCH_SIZE];
+        int results[PK_ASSET_URING_BATCH_SIZE];
+
+        for (auto i = 0u; i < PK_ASSET_URING_BATCH_SIZE; ++i)
+        {
+            loadPointers[i] = loads + i;
+        }
+
+        for (auto pass = 0u; pass < PK_BENCHMARK_LOAD_PASS_COUNT; ++pass)
+        {
+            auto failCount = 0u;
+            auto start = Clock::now();
+
+            for (size_t first = 0ull; first < filepaths.size(); first += PK_ASSET_URING_BATCH_SIZE)
+            {
+                auto count = (uint32_t)std::min(filepaths.size() - first, (size_t)PK_ASSET_URING_BATCH_SIZE);
+
+                if (ring != nullptr)
+                {
+                    BeginAssetLoadsUring(ring, filepaths.data() + first, loadPointers, results, count);
+                    ReadAssetLoadsUring(ring, loadPointers, results, 0u, count);
+                }
+                else
+                {
+                    for (auto i = 0u; i < count; ++i)
+                    {
+                        results[i] = BeginAssetLoad(filepaths[first + i], loads + i);
+                        results[i] = results[i] == 0 ? ReadAssetLoad(loads + i) : results[i];
+                    }
+                }
+
+                for (auto i = 0u; i < count; ++i)
+                {
+                    failCount += results[i] != 0 ? 1u : 0u;
+
+                    if (results[i] == 0)
+                    {
+                        CancelAssetLoad(loads + i);
+                    }
+                }
+            }
+
+            auto time = std::chrono::duration<double>(Clock::now() - start).count();
+            bestTime = pass == 0u || time < bestTime ? time : bestTime;
+            *outFailCount = failCount;
+        }
+
+        return bestTime;
+    }
+
+    static void PrintResult(const char* name, double time, uint32_t failCount, uint32_t fileCount, uint64_t totalSize)
+    {
+        printf("%-16s Time: %8.2fms, Files: %10.0f/s, Read: %8.1fMB/s, Failed: %u \n",
+            name,
+            time * 1000.0,
+            fileCount / time,
+            totalSize / (time * 1e6),
+            failCount);
+    }
+
+    int RunLoadingBenchmark(const std::string& path)
+    {
+        std::vector<std::string> paths;
+        std::vector<const char*> filepaths;
+        auto totalSize = 0ull;
+
+        if (std::filesystem::is_directory(path))
+        {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file())
+                {
+                    paths.push_back(entry.path().string());
+                    totalSize += entry.file_size();
+                }
+            }
+        }
+        else if (std::filesystem::is_regular_file(path))
+        {
+            paths.push_back(path);
+            totalSize += std::filesystem::file_size(path);
+        }
+
+        if (paths.empty())
+        {
+            printf("No benchmark inputs found: %s \n", path.c_str());
+            return -1;
+        }
+
+        for (const auto& filepath : paths)
+        {
+            filepaths.push_back(filepath.c_str());
+        }
+
+        auto fileCount = (uint32_t)filepaths.size();
+        auto failCount = 0u;
+        printf("Loading benchmark: %u files, %4.2fMiB \n", fileCount, totalSize / (1024.0 * 1024.0));
+
+        // The batch loader silently falls back to stdio, so availability is probed up front.
+        auto ring = CreateAssetUring();
+
+        auto time = RunReadPasses(filepaths, nullptr, &failCount);
+        PrintResult("Read stdio", time, failCount, fileCount, totalSize);
+
+        if (ring != nullptr)
+        {
+            time = RunReadPasses(filepaths, ring, &failCount);
+            PrintResult("Read io_uring", time, failCount, fileCount, totalSize);
+        }
+
+        time = RunSerialPasses(filepaths, &failCount);
+        PrintResult("OpenAsset", time, failCount, fileCount, totalSize);
+
+        time = RunBatchPasses(filepaths, 0u, &failCount);
+        PrintResult("Batch stdio", time, failCount, fileCount, totalSize);
+
+        if (ring != nullptr)
+        {
+            time = RunBatchPasses(filepaths, PK_ASSET_BATCH_LOADER_FLAG_IO_URING, &failCount);
+            PrintResult("Batch io_uring", time, failCount, fileCount, totalSize);
+        }
+        else
+        {
+            printf("%-16s Unavailable \n", "io_uring");
+        }
+
+        DestroyAssetUring(ring);
+        fflush(stdout);
+        return 0;
+    }
+}
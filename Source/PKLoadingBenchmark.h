@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+namespace PKAssets::Benchmark
+{
+    // Each loading mode is run this many times & the fastest pass is reported, so results measure a warm page cache.
+    constexpr static const uint32_t PK_BENCHMARK_LOAD_PASS_COUNT = 5u;
+
+    // Loads every file under the given path with OpenAsset & the batch loader, on stdio & on io_uring when available. File I/O without decoding is measured separately.
+    // Reports files & file bytes loaded per second. Intended for directories of many small assets such as cooked shaders.
+    int RunLoadingBenchmark(const std::string& path);
+}
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <mutex>
+#include "PKLogUtilities.h"
+
+namespace PKAssets::LogUtilities
+{
+    struct LogBuffer
+    {
+        std::string text;
+        bool isActive = false;
+    };
+
+    static thread_local LogBuffer s_threadBuffer;
+    static std::mutex s_outputLock;
+
+    void Printf(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+
+        if (!s_threadBuffer.isActive)
+        {
+            std::lock_guard<std::mutex> lock(s_outputLock);
+            vprintf(format, args);
+            va_end(args);
+            return;
+        }
+
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        auto length = vsnprintf(nullptr, 0, format, argsCopy);
+        va_end(argsCopy);
+
+        if (length > 0)
+        {
+            auto offset = s_threadBuffer.text.size();
+            s_threadBuffer.text.resize(offset + length + 1);
+            vsnprintf(s_threadBuffer.text.data() + offset, length + 1, format, args);
+            s_threadBuffer.text.resize(offset + length);
+        }
+
+        va_end(args);
+    }
+
+    void BeginBuffer()
+    {
+        s_threadBuffer.text.clear();
+        s_threadBuffer.isActive = true;
+    }
+
+    void EndBuffer()
+    {
+        s_threadBuffer.isActive = false;
+        Flush(s_threadBuffer.text);
+        s_threadBuffer.text.clear();
+    }
+
+    void EndBuffer(std::string& outText)
+    {
+        s_threadBuffer.isActive = false;
+        outText = std::move(s_threadBuffer.text);
+        s_threadBuffer.text.clear();
+    }
+
+    void Flush(const std::string& text)
+    {
+        std::lock_guard<std::mutex> lock(s_outputLock);
+        fwrite(text.data(), sizeof(char), text.size(), stdout);
+        fflush(stdout);
+    }
+}
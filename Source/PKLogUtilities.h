@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+namespace PKAssets::LogUtilities
+{
+    // Output is written directly to stdout unless a buffer is active on the calling thread.
+    // Buffered output is flushed as a single block so that logs from concurrent jobs dont interleave.
+    void Printf(const char* format, ...);
+    void BeginBuffer();
+    void EndBuffer();
+
+    // Ends the buffer without flushing it. Used to forward worker process output.
+    void EndBuffer(std::string& outText);
+    void Flush(const std::string& text);
+}
@@ -4,9 +4,13 @@
 #include <tinyobjloader/tiny_obj_loader.h>
 #include <meshoptimizer/meshoptimizer.h>
 #include <PKAssetLoader.h>
+#include <PKAssetEncoding.h>
 #include "PKAssetWriter.h"
 #include "PKStringUtilities.h"
 #include "PKFileVersionUtilities.h"
+#include "PKCookCache.h"
+#include "PKLogUtilities.h"
+#include "PKProfiler.h"
 #include "PKMeshUtilities.h"
 #include "PKMeshletWriter.h"
 
@@ -103,6 +107,7 @@ namespace PKAssets::Mesh
         uint32_t vcount,
         uint32_t icount)
     {
+        PK_PROFILE_SCOPE("CalculateTangents");
         MikktsInterface1::PKMeshData data;
         data.vertices = reinterpret_cast<float*>(vertices);
         data.stride = stride / sizeof(float);
@@ -131,7 +136,7 @@ namespace PKAssets::Mesh
 
         if (!result)
         {
-            printf("Failed to calculate tangents");
+            LogUtilities::Printf("Failed to calculate tangents");
             return -1;
         }
 
@@ -194,6 +199,7 @@ namespace PKAssets::Mesh
 
     void OptimizeMesh(Buffer& vertices, size_t stride, std::vector<uint32_t>& indices, const std::vector<PKSubmesh>& submeshes)
     {
+        PK_PROFILE_SCOPE("OptimizeMesh");
         auto vcount = vertices.size() / stride;
 
         std::vector<uint32_t> remap(indices.size());
@@ -203,7 +209,7 @@ namespace PKAssets::Mesh
 
         auto submeshIndex = 0u;
 
-        printf("    Statistics:\n");
+        LogUtilities::Printf("    Statistics:\n");
 
         for (const auto& sm : submeshes)
         {
@@ -214,18 +220,19 @@ namespace PKAssets::Mesh
             meshopt_optimizeOverdraw(pSmIndices, pSmIndices, sm.indexCount, reinterpret_cast<float*>(vertices.data()), total_vertices, stride, 1.05f);
             
             auto statisticsOverdraw = meshopt_analyzeOverdraw(pSmIndices, sm.indexCount, reinterpret_cast<float*>(vertices.data()), total_vertices, stride);
-            printf("        Submesh: %i Overdraw: %4.2f, Covered: %ipx, Shared: %ipx\n", submeshIndex++, statisticsOverdraw.overdraw, statisticsOverdraw.pixels_covered, statisticsOverdraw.pixels_shaded);
+            LogUtilities::Printf("        Submesh: %i Overdraw: %4.2f, Covered: %ipx, Shared: %ipx\n", submeshIndex++, statisticsOverdraw.overdraw, statisticsOverdraw.pixels_covered, statisticsOverdraw.pixels_shaded);
         }
 
         total_vertices = meshopt_optimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.data(), total_vertices, stride);
         vertices.reduce(stride * total_vertices);
 
         auto statisticsVertexFetch = meshopt_analyzeVertexFetch(indices.data(), indices.size(), vcount, stride);
-        printf("        OverFetch: %4.2f, Fetched: %ibytes\n", statisticsVertexFetch.overfetch, statisticsVertexFetch.bytes_fetched);
+        LogUtilities::Printf("        OverFetch: %4.2f, Fetched: %ibytes\n", statisticsVertexFetch.overfetch, statisticsVertexFetch.bytes_fetched);
     }
 
     void SimplifyMesh(Buffer& vertices, size_t stride, const SimplificationDesc& desc, std::vector<uint32_t>& indices, std::vector<PKSubmesh>& submeshes)
     {
+        PK_PROFILE_SCOPE("SimplifyMesh");
         if (desc.targetError == 0.0f) 
         {
             return;
@@ -271,7 +278,7 @@ namespace PKAssets::Mesh
         newIndices.resize(indices.size());
         size_t totalIndices = 0u;
 
-        printf("    Simplification:\n");
+        LogUtilities::Printf("    Simplification:\n");
 
         for (auto i = 0u; i < submeshes.size(); ++i)
         {
@@ -297,7 +304,7 @@ namespace PKAssets::Mesh
                 &error
             );
 
-            printf("        Submesh: %u Triangle count: %u -> %u, Error: %4.2f%%\n", i, sm.indexCount / 3u, (uint32_t)newIndexCount / 3u, error * 100.0f);
+            LogUtilities::Printf("        Submesh: %u Triangle count: %u -> %u, Error: %4.2f%%\n", i, sm.indexCount / 3u, (uint32_t)newIndexCount / 3u, error * 100.0f);
             sm.firstIndex = totalIndices;
             totalIndices += newIndexCount;
             sm.indexCount = newIndexCount;
@@ -307,7 +314,7 @@ namespace PKAssets::Mesh
         auto totalVertices = meshopt_optimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.data(), vcount, stride);
         vertices.reduce(stride * totalVertices);
 
-        printf("        VertexCount: %u -> %u\n", (uint32_t)vcount, (uint32_t)totalVertices);
+        LogUtilities::Printf("        VertexCount: %u -> %u\n", (uint32_t)vcount, (uint32_t)totalVertices);
     }
 
     void SplitPositionStream(Buffer& vertices, size_t stride, size_t vertexCount)
@@ -374,36 +381,49 @@ namespace PKAssets::Mesh
 
     int WriteMesh(const char* pathSrc, const char* pathDst, const size_t pathStemOffset)
     {
-        if (!PKVersionUtilities::IsFileOutOfDate(pathSrc, pathDst))
+        if (!PKVersionUtilities::IsAssetOutOfDate(pathSrc, pathDst))
         {
             return 1;
         }
 
+        auto cacheKey = CookCache::GetKey(pathSrc, pathDst);
+
+        if (CookCache::Restore(cacheKey, pathDst, pathStemOffset))
+        {
+            PKVersionUtilities::RecordAsset(pathSrc, pathDst, {});
+            return 0;
+        }
+
         auto filename = StringUtilities::ReadFileName(pathSrc);
-        printf("Preprocessing mesh: %s \n", filename.c_str());
+        LogUtilities::Printf("Preprocessing mesh: %s \n", filename.c_str());
 
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
         std::string err;
 
-        bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, pathSrc, StringUtilities::ReadDirectory(pathSrc).c_str(), true);
+        bool success = false;
+
+        {
+            PK_PROFILE_SCOPE("tinyobj::LoadObj");
+            success = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, pathSrc, StringUtilities::ReadDirectory(pathSrc).c_str(), true);
+        }
 
         if (!err.empty())
         {
-            printf("%s", err.c_str());
+            LogUtilities::Printf("%s", err.c_str());
             return -1;
         }
 
         if (attrib.vertices.empty())
         {
-            printf("Mesh doesn't contain vertices");
+            LogUtilities::Printf("Mesh doesn't contain vertices");
             return -1;
         }
 
         if (!success)
         {
-            printf("Failed to load .obj");
+            LogUtilities::Printf("Failed to load .obj");
             return -1;
         }
 
@@ -608,7 +628,7 @@ namespace PKAssets::Mesh
 
         if (hasNormals && useHalfPrecisionNormals)
         {
-            printf("Packing half precision normals\n");
+            LogUtilities::Printf("Packing half precision normals\n");
             auto strideDelta = ConvertFloatToHalfAttribute(vertices, stride, offsetNormals, 3, vcount);
             stride += strideDelta;
             offsetTangents += strideDelta;
@@ -617,7 +637,7 @@ namespace PKAssets::Mesh
 
         if (hasTangents && useHalfPrecisionTangents)
         {
-            printf("Packing half precision tangents\n");
+            LogUtilities::Printf("Packing half precision tangents\n");
             auto strideDelta = ConvertFloatToHalfAttribute(vertices, stride, offsetTangents, 4, vcount);
             stride += strideDelta;
             offsetUVs += strideDelta;
@@ -625,7 +645,7 @@ namespace PKAssets::Mesh
 
         if (hasUvs && useHalfPrecisionUVs)
         {
-            printf("Packing half precision uvs\n");
+            LogUtilities::Printf("Packing half precision uvs\n");
             auto strideDelta = ConvertFloatToHalfAttribute(vertices, stride, offsetUVs, 2, vcount);
             stride += strideDelta;
         }
@@ -655,6 +675,18 @@ namespace PKAssets::Mesh
         auto pVertexBuffer = buffer.Write(vertices.data(), vertices.size());
         mesh->vertexBuffer.Set(buffer.data(), pVertexBuffer.get());
 
+        if (splitPositionStream)
+        {
+            auto positionSize = sizeof(float) * 3u;
+            auto attributeStride = stride - positionSize;
+            buffer.AddFilter(pVertexBuffer, attributeStride * vcount, (uint32_t)attributeStride, PK_ASSET_ENCODE_FILTER_DELTA);
+            buffer.AddFilter(WritePtr<char>(&buffer, pVertexBuffer.offset + (uint32_t)(attributeStride * vcount)), positionSize * vcount, (uint32_t)positionSize, PK_ASSET_ENCODE_FILTER_DELTA);
+        }
+        else
+        {
+            buffer.AddFilter(pVertexBuffer, vertices.size(), (uint32_t)stride, PK_ASSET_ENCODE_FILTER_DELTA);
+        }
+
         if (indexSize == sizeof(uint32_t))
         {
             auto pIndexBuffer = buffer.Write(indices.data(), indices.size());
@@ -698,6 +730,13 @@ namespace PKAssets::Mesh
 
         mesh->meshletMesh.Set(buffer.data(), meshletMesh.get());
 
-        return WriteAsset(pathDst, pathStemOffset, buffer, false);
+        if (WriteAsset(pathDst, pathStemOffset, buffer, false) != 0)
+        {
+            return -1;
+        }
+
+        CookCache::Store(cacheKey, pathDst);
+        PKVersionUtilities::RecordAsset(pathSrc, pathDst, {});
+        return 0;
     }
 }
\ No newline at end of file
@@ -3,8 +3,11 @@
 #define CLUSTERLOD_IMPLEMENTATION
 #include <meshoptimizer/pkmod_clusterlod.h>
 #include <METIS/metis.h>
+#include <PKAssetEncoding.h>
 #include "PKMeshUtilities.h"
 #include "PKMeshletWriter.h"
+#include "PKLogUtilities.h"
+#include "PKProfiler.h"
 
 namespace PKAssets::Mesh
 {
@@ -354,7 +357,7 @@ namespace PKAssets::Mesh
 
         stats_final_triangle_count += total_simplified_index_count / 3u;
 
-        printf("        Submesh DAG: Tris: %u -> %u, Meshlets: %u, Levels: %u\n", 
+        LogUtilities::Printf("        Submesh DAG: Tris: %u -> %u, Meshlets: %u, Levels: %u\n", 
             stats_initial_triangle_count, 
             stats_final_triangle_count, 
             stats_new_meshlet_count, 
@@ -606,22 +609,24 @@ namespace PKAssets::Mesh
         
         auto pMeshlets = buffer.Write(out_meshlets.data(), out_meshlets.size());
         mesh->meshlets.Set(buffer.data(), pMeshlets.get());
+        buffer.AddFilter(pMeshlets, out_meshlets.size() * sizeof(PKMeshlet), sizeof(PKMeshlet), PK_ASSET_ENCODE_FILTER_DELTA);
 
         auto pSubmeshes = buffer.Write(out_submeshes.data(), out_submeshes.size());
         mesh->submeshes.Set(buffer.data(), pSubmeshes.get());
 
         auto pVertices = buffer.Write(out_vertices.data(), out_vertices.size());
         mesh->vertices.Set(buffer.data(), pVertices.get());
+        buffer.AddFilter(pVertices, out_vertices.size() * sizeof(PKMeshletVertex), sizeof(PKMeshletVertex), PK_ASSET_ENCODE_FILTER_DELTA);
 
         auto pIndices = buffer.Write(out_indices.data(), out_indices.size());
         mesh->indices.Set(buffer.data(), pIndices.get());
 
-        printf("    Meshlet Statistics:\n");
-        printf("        Vertex Count: %i -> %i\n", vertexCount, (uint32_t)out_vertices.size());
-        printf("        Triangle Count: %i -> %i\n", indexCount / 3u, (uint32_t)(out_indices.size() / 3ull));
-        printf("        Vertex Buffer Size: %i -> %i\n", (uint32_t)(vertexCount * vertexStride), (uint32_t)(out_vertices.size() * sizeof(PKMeshletVertex)));
-        printf("        Triangle Buffer Size: %i -> %i\n", (uint32_t)(indexCount * sizeof(uint32_t)), (uint32_t)(out_indices.size()));
-        printf("        Meshlet Count: %i\n", (uint32_t)out_meshlets.size());
+        LogUtilities::Printf("    Meshlet Statistics:\n");
+        LogUtilities::Printf("        Vertex Count: %i -> %i\n", vertexCount, (uint32_t)out_vertices.size());
+        LogUtilities::Printf("        Triangle Count: %i -> %i\n", indexCount / 3u, (uint32_t)(out_indices.size() / 3ull));
+        LogUtilities::Printf("        Vertex Buffer Size: %i -> %i\n", (uint32_t)(vertexCount * vertexStride), (uint32_t)(out_vertices.size() * sizeof(PKMeshletVertex)));
+        LogUtilities::Printf("        Triangle Buffer Size: %i -> %i\n", (uint32_t)(indexCount * sizeof(uint32_t)), (uint32_t)(out_indices.size()));
+        LogUtilities::Printf("        Meshlet Count: %i\n", (uint32_t)out_meshlets.size());
 
         return mesh;
     }
@@ -724,6 +729,7 @@ namespace PKAssets::Mesh
 
             groups.clear();
 
+            PK_PROFILE_SCOPE("clodBuild");
             clodBuild(config, ctx, [&](clodGroup group, const clodCluster* clusters, size_t cluster_count) -> int
             {
                 groups.push_back(group);
@@ -839,22 +845,24 @@ namespace PKAssets::Mesh
 
         auto pMeshlets = buffer.Write(out_meshlets.data(), out_meshlets.size());
         mesh->meshlets.Set(buffer.data(), pMeshlets.get());
+        buffer.AddFilter(pMeshlets, out_meshlets.size() * sizeof(PKMeshlet), sizeof(PKMeshlet), PK_ASSET_ENCODE_FILTER_DELTA);
 
         auto pSubmeshes = buffer.Write(out_submeshes.data(), out_submeshes.size());
         mesh->submeshes.Set(buffer.data(), pSubmeshes.get());
 
         auto pVertices = buffer.Write(out_vertices.data(), out_vertices.size());
         mesh->vertices.Set(buffer.data(), pVertices.get());
+        buffer.AddFilter(pVertices, out_vertices.size() * sizeof(PKMeshletVertex), sizeof(PKMeshletVertex), PK_ASSET_ENCODE_FILTER_DELTA);
 
         auto pIndices = buffer.Write(out_indices.data(), out_indices.size());
         mesh->indices.Set(buffer.data(), pIndices.get());
 
-        printf("    Meshlet Statistics:\n");
-        printf("        Vertex Count: %i -> %i\n", vertexCount, (uint32_t)out_vertices.size());
-        printf("        Triangle Count: %i -> %i\n", indexCount / 3u, (uint32_t)(out_indices.size() / 3ull));
-        printf("        Vertex Buffer Size: %i -> %i\n", (uint32_t)(vertexCount * vertexStride), (uint32_t)(out_vertices.size() * sizeof(PKMeshletVertex)));
-        printf("        Triangle Buffer Size: %i -> %i\n", (uint32_t)(indexCount * sizeof(uint32_t)), (uint32_t)(out_indices.size()));
-        printf("        Meshlet Count: %i\n", (uint32_t)out_meshlets.size());
+        LogUtilities::Printf("    Meshlet Statistics:\n");
+        LogUtilities::Printf("        Vertex Count: %i -> %i\n", vertexCount, (uint32_t)out_vertices.size());
+        LogUtilities::Printf("        Triangle Count: %i -> %i\n", indexCount / 3u, (uint32_t)(out_indices.size() / 3ull));
+        LogUtilities::Printf("        Vertex Buffer Size: %i -> %i\n", (uint32_t)(vertexCount * vertexStride), (uint32_t)(out_vertices.size() * sizeof(PKMeshletVertex)));
+        LogUtilities::Printf("        Triangle Buffer Size: %i -> %i\n", (uint32_t)(indexCount * sizeof(uint32_t)), (uint32_t)(out_indices.size()));
+        LogUtilities::Printf("        Meshlet Count: %i\n", (uint32_t)out_meshlets.size());
 
         return mesh;
     }
@@ -0,0 +1,180 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+#include <PKAssetPack.h>
+#include "PKPackWriter.h"
+
+namespace PKAssets::Packer
+{
+    struct PackEntry
+    {
+        std::string name;
+        std::string filepath;
+        PKAssetPackEntry entry;
+    };
+
+    static uint64_t AlignPackOffset(uint64_t offset)
+    {
+        return (offset + PK_ASSET_PACK_ALIGNMENT - 1ull) & ~(uint64_t)(PK_ASSET_PACK_ALIGNMENT - 1ull);
+    }
+
+    static bool ReadPackEntryHeader(const std::filesystem::path& path, PKAssetHeader* outHeader)
+    {
+        auto file = fopen(path.string().c_str(), "rb");
+
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        auto isRead = fread(outHeader, sizeof(PKAssetHeader), 1u, file) == 1u;
+        fclose(file);
+        return isRead && outHeader->magicNumber == PK_ASSET_MAGIC_NUMBER;
+    }
+
+    static bool WritePadding(FILE* file, uint64_t* offset, uint64_t targetOffset)
+    {
+        const char zeros[PK_ASSET_PACK_ALIGNMENT] = {};
+        auto size = (size_t)(targetOffset - *offset);
+        *offset = targetOffset;
+        return fwrite(zeros, 1u, size, file) == size;
+    }
+
+    static bool WritePackEntry(FILE* file, uint64_t* offset, const PackEntry& entry, std::vector<char>& buffer)
+    {
+        auto source = fopen(entry.filepath.c_str(), "rb");
+
+        if (source == nullptr)
+        {
+            return false;
+        }
+
+        buffer.resize(entry.entry.size);
+        auto isRead = fread(buffer.data(), 1u, buffer.size(), source) == buffer.size() && fgetc(source) == EOF;
+        fclose(source);
+        auto isWritten = isRead && WritePadding(file, offset, entry.entry.offset) && fwrite(buffer.data(), 1u, buffer.size(), file) == buffer.size();
+        *offset += buffer.size();
+        return isWritten;
+    }
+
+    int WritePack(const std::string& srcdir, const std::string& filepath)
+    {
+        std::vector<PackEntry> entries;
+        auto packPath = std::filesystem::absolute(filepath);
+
+        if (!std::filesystem::is_directory(srcdir))
+        {
+            printf("Pack source directory not found: %s \n", srcdir.c_str());
+            return -1;
+        }
+
+        for (const auto& directoryEntry : std::filesystem::recursive_directory_iterator(srcdir))
+        {
+            PKAssetHeader header;
+
+            if (!directoryEntry.is_regular_file() || std::filesystem::absolute(directoryEntry.path()) == packPath || !ReadPackEntryHeader(directoryEntry.path(), &header))
+            {
+                continue;
+            }
+
+            PackEntry entry;
+            entry.name = std::filesystem::relative(directoryEntry.path(), srcdir).generic_string();
+            entry.filepath = directoryEntry.path().string();
+            entry.entry.nameHash = GetAssetNameHash(entry.name.c_str());
+            entry.entry.size = directoryEntry.file_size();
+            entry.entry.flags |= header.isCompressed ? PK_ASSET_PACK_ENTRY_FLAG_COMPRESSED : 0u;
+            entry.entry.flags |= header.isCompressed && header.blockShift != 0u ? PK_ASSET_PACK_ENTRY_FLAG_BLOCKED : 0u;
+            entries.push_back(entry);
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b)
+        {
+            return a.entry.nameHash != b.entry.nameHash ? a.entry.nameHash < b.entry.nameHash : a.name < b.name;
+        });
+
+        // One bucket per entry rounded up to a power of two.
+        PKAssetPackHeader header;
+        header.entryCount = (uint32_t)entries.size();
+
+        while (header.bucketBits < PK_ASSET_PACK_MAX_BUCKET_BITS && (1ull << header.bucketBits) < entries.size())
+        {
+            header.bucketBits++;
+        }
+
+        std::vector<uint32_t> buckets((1ull << header.bucketBits) + 1ull, 0u);
+        std::vector<char> names;
+
+        for (auto i = 0u; i < entries.size(); ++i)
+        {
+            auto bucket = header.bucketBits > 0u ? (size_t)(entries[i].entry.nameHash >> (64u - header.bucketBits)) : 0ull;
+            buckets[bucket + 1ull]++;
+            entries[i].entry.nameOffset = (uint32_t)names.size();
+            names.insert(names.end(), entries[i].name.c_str(), entries[i].name.c_str() + entries[i].name.size() + 1u);
+        }
+
+        for (auto i = 1ull; i < buckets.size(); ++i)
+        {
+            buckets[i] += buckets[i - 1ull];
+        }
+
+        header.namesSize = (uint32_t)names.size();
+        auto offset = AlignPackOffset(GetAssetPackTableSize(header.entryCount, header.bucketBits, header.namesSize));
+
+        for (auto& entry : entries)
+        {
+            entry.entry.offset = offset;
+            offset = AlignPackOffset(offset + entry.entry.size);
+        }
+
+        header.size = entries.empty() ? GetAssetPackTableSize(0u, header.bucketBits, 0u) : entries.back().entry.offset + entries.back().entry.size;
+
+        std::filesystem::create_directories(packPath.parent_path());
+        auto file = fopen(packPath.string().c_str(), "wb");
+
+        if (file == nullptr)
+        {
+            printf("Failed to open pack for writing: %s \n", packPath.string().c_str());
+            return -1;
+        }
+
+        auto fileOffset = (uint64_t)(sizeof(PKAssetPackHeader) + buckets.size() * sizeof(uint32_t));
+        auto isWritten = fwrite(&header, sizeof(PKAssetPackHeader), 1u, file) == 1u;
+        isWritten = isWritten && fwrite(buckets.data(), sizeof(uint32_t), buckets.size(), file) == buckets.size();
+        isWritten = isWritten && WritePadding(file, &fileOffset, GetAssetPackTableSize(0u, header.bucketBits, 0u));
+
+        for (auto i = 0u; i < entries.size() && isWritten; ++i)
+        {
+            isWritten = fwrite(&entries[i].entry, sizeof(PKAssetPackEntry), 1u, file) == 1u;
+        }
+
+        isWritten = isWritten && fwrite(names.data(), 1u, names.size(), file) == names.size();
+        fileOffset += entries.size() * sizeof(PKAssetPackEntry) + names.size();
+
+        // Assets are read one at a time & written sequentially with zero padding up to their aligned offsets.
+        std::vector<char> buffer;
+
+        for (auto i = 0u; i < entries.size() && isWritten; ++i)
+        {
+            isWritten = WritePackEntry(file, &fileOffset, entries[i], buffer);
+
+            if (!isWritten)
+            {
+                printf("Failed to pack asset: %s \n", entries[i].filepath.c_str());
+            }
+        }
+
+        isWritten = fclose(file) == 0 && isWritten;
+
+        if (!isWritten)
+        {
+            printf("Failed to write pack: %s \n", packPath.string().c_str());
+            std::filesystem::remove(packPath);
+            return -1;
+        }
+
+        printf("Packed %u assets (%llu bytes) to: %s \n", header.entryCount, (unsigned long long)header.size, packPath.string().c_str());
+        return 0;
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+namespace PKAssets::Packer
+{
+    // Packs every cooked asset under the source directory into a single .pkpack archive. Other files are skipped.
+    // Entries are named by their path relative to the source directory with '/' separators.
+    int WritePack(const std::string& srcdir, const std::string& filepath);
+}
@@ -0,0 +1,366 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <sstream>
+#include "PKProfiler.h"
+
+namespace PKAssets::Profiler
+{
+    struct ProfileEvent
+    {
+        const char* name;
+        uint32_t assetIndex;
+        uint32_t depth;
+        int64_t startTime;
+        int64_t duration;
+    };
+
+    struct ThreadProfile
+    {
+        std::vector<ProfileEvent> events;
+        uint32_t threadIndex = 0u;
+        uint32_t assetIndex = 0u;
+        uint32_t depth = 0u;
+        int64_t assetStartTime = 0ll;
+    };
+
+    struct Profile
+    {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<ThreadProfile>> threads;
+        std::vector<std::string> assetNames = { "" };
+        // Names of events added from other processes. Set nodes keep the pointers stable.
+        std::unordered_set<std::string> eventNames;
+        std::mutex lock;
+        std::atomic<bool> isEnabled = false;
+    };
+
+    constexpr static const char* PROFILE_ASSET_EVENT_NAME = "Cook";
+
+    static Profile s_profile;
+    static thread_local ThreadProfile* s_threadProfile = nullptr;
+
+    static int64_t GetTimeMicroseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_profile.startTime).count();
+    }
+
+    static ThreadProfile* GetThreadProfile()
+    {
+        if (s_threadProfile == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(s_profile.lock);
+            s_profile.threads.push_back(std::make_unique<ThreadProfile>());
+            s_threadProfile = s_profile.threads.back().get();
+            s_threadProfile->threadIndex = (uint32_t)s_profile.threads.size();
+        }
+
+        return s_threadProfile;
+    }
+
+    static std::string EscapeJson(const std::string& value)
+    {
+        std::string result;
+        result.reserve(value.size());
+
+        for (auto c : value)
+        {
+            switch (c)
+            {
+                case '\\': result += "\\\\"; break;
+                case '\"': result += "\\\""; break;
+                default: result += (unsigned char)c < 0x20u ? ' ' : c; break;
+            }
+        }
+
+        return result;
+    }
+
+    ProfileScope::ProfileScope(const char* name) : name(name), startTime(-1ll)
+    {
+        if (s_profile.isEnabled.load(std::memory_order_relaxed))
+        {
+            GetThreadProfile()->depth++;
+            startTime = GetTimeMicroseconds();
+        }
+    }
+
+    ProfileScope::~ProfileScope()
+    {
+        if (startTime >= 0ll)
+        {
+            auto thread = GetThreadProfile();
+            thread->depth--;
+            thread->events.push_back({ name, thread->assetIndex, thread->depth + 1u, startTime, GetTimeMicroseconds() - startTime });
+        }
+    }
+
+    void Enable()
+    {
+        s_profile.isEnabled = true;
+    }
+
+    bool IsEnabled()
+    {
+        return s_profile.isEnabled;
+    }
+
+    void BeginAsset(const char* name)
+    {
+        if (!s_profile.isEnabled)
+        {
+            return;
+        }
+
+        auto thread = GetThreadProfile();
+
+        {
+            std::lock_guard<std::mutex> lock(s_profile.lock);
+            thread->assetIndex = (uint32_t)s_profile.assetNames.size();
+            s_profile.assetNames.push_back(name);
+        }
+
+        thread->assetStartTime = GetTimeMicroseconds();
+    }
+
+    void EndAsset()
+    {
+        if (!s_profile.isEnabled)
+        {
+            return;
+        }
+
+        auto thread = GetThreadProfile();
+        thread->events.push_back({ PROFILE_ASSET_EVENT_NAME, thread->assetIndex, 0u, thread->assetStartTime, GetTimeMicroseconds() - thread->assetStartTime });
+        thread->assetIndex = 0u;
+    }
+
+    int64_t GetTime()
+    {
+        return GetTimeMicroseconds();
+    }
+
+    // One event per line: depth, start time, duration & name. The asset name replaces the name of asset events.
+    void TakeEvents(int64_t startTime, std::string& outEvents)
+    {
+        std::lock_guard<std::mutex> lock(s_profile.lock);
+        std::ostringstream stream;
+
+        for (const auto& thread : s_profile.threads)
+        {
+            for (const auto& event : thread->events)
+            {
+                auto name = event.depth == 0u ? s_profile.assetNames.at(event.assetIndex).c_str() : event.name;
+                stream << event.depth << '\t' << event.startTime - startTime << '\t' << event.duration << '\t' << name << '\n';
+            }
+
+            thread->events.clear();
+        }
+
+        outEvents = stream.str();
+    }
+
+    void AddEvents(int64_t startTime, const std::string& events)
+    {
+        if (!s_profile.isEnabled || events.empty())
+        {
+            return;
+        }
+
+        auto thread = GetThreadProfile();
+        std::lock_guard<std::mutex> lock(s_profile.lock);
+        std::istringstream stream(events);
+        std::string line;
+        auto assetIndex = (uint32_t)s_profile.assetNames.size();
+        s_profile.assetNames.emplace_back();
+
+        while (std::getline(stream, line))
+        {
+            std::istringstream lineStream(line);
+            ProfileEvent event{};
+            std::string name;
+            lineStream >> event.depth >> event.startTime >> event.duration;
+            lineStream.ignore(1);
+            std::getline(lineStream, name);
+
+            if (event.depth == 0u)
+            {
+                s_profile.assetNames.at(assetIndex) = name;
+                name = PROFILE_ASSET_EVENT_NAME;
+            }
+
+            event.name = s_profile.eventNames.insert(name).first->c_str();
+            event.assetIndex = assetIndex;
+            event.startTime += startTime;
+            thread->events.push_back(event);
+        }
+    }
+
+    bool WriteTrace(const char* path)
+    {
+        std::lock_guard<std::mutex> lock(s_profile.lock);
+        auto file = fopen(path, "w");
+
+        if (file == nullptr)
+        {
+            printf("Failed to write trace: %s \n", path);
+            return false;
+        }
+
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"PKAssetTools\"}}");
+
+        for (const auto& thread : s_profile.threads)
+        {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Cook Thread %u\"}}", thread->threadIndex, thread->threadIndex);
+
+            for (const auto& event : thread->events)
+            {
+                auto assetName = EscapeJson(s_profile.assetNames.at(event.assetIndex));
+                auto eventName = event.depth == 0u ? assetName : EscapeJson(event.name);
+
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%u,\"args\":{\"asset\":\"%s\"}}",
+                    eventName.c_str(),
+                    event.depth == 0u ? PROFILE_ASSET_EVENT_NAME : "Stage",
+                    (long long)event.startTime,
+                    (long long)event.duration,
+                    thread->threadIndex,
+                    assetName.c_str());
+            }
+        }
+
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        printf("Trace written to: %s \n", path);
+        return true;
+    }
+
+    void WriteSummary(uint32_t maxAssetCount)
+    {
+        struct StageSummary
+        {
+            const char* name = nullptr;
+            uint32_t count = 0u;
+            int64_t total = 0ll;
+            int64_t self = 0ll;
+            int64_t max = 0ll;
+        };
+
+        struct AssetSummary
+        {
+            uint32_t index = 0u;
+            int64_t total = 0ll;
+            std::unordered_map<std::string, int64_t> stages;
+        };
+
+        std::lock_guard<std::mutex> lock(s_profile.lock);
+        std::unordered_map<std::string, StageSummary> stages;
+        std::vector<AssetSummary> assets(s_profile.assetNames.size());
+        int64_t totalTime = 0ll;
+
+        for (const auto& thread : s_profile.threads)
+        {
+            // Events are recorded in completion order. Nested scopes complete before their parent.
+            std::vector<int64_t> childTimes;
+
+            for (const auto& event : thread->events)
+            {
+                childTimes.resize(std::max<size_t>(childTimes.size(), event.depth + 2u), 0ll);
+                auto selfTime = event.duration - childTimes[event.depth + 1u];
+                childTimes[event.depth + 1u] = 0ll;
+                childTimes[event.depth] += event.duration;
+
+                auto& asset = assets.at(event.assetIndex);
+                asset.index = event.assetIndex;
+
+                if (event.depth == 0u)
+                {
+                    asset.total += event.duration;
+                    totalTime += event.duration;
+                    continue;
+                }
+
+                auto& stage = stages[event.name];
+                stage.name = event.name;
+                stage.count++;
+                stage.total += event.duration;
+                stage.self += selfTime;
+                stage.max = std::max(stage.max, event.duration);
+                asset.stages[event.name] += selfTime;
+            }
+        }
+
+        std::vector<StageSummary> sortedStages;
+
+        for (const auto& kv : stages)
+        {
+            sortedStages.push_back(kv.second);
+        }
+
+        std::sort(sortedStages.begin(), sortedStages.end(), [](const StageSummary& a, const StageSummary& b) { return a.self > b.self; });
+        std::sort(assets.begin(), assets.end(), [](const AssetSummary& a, const AssetSummary& b) { return a.total > b.total; });
+
+        // Total & max include nested stages, self time & share dont. Shares are relative to the summed asset cook time.
+        printf("\n%-32s %8s %12s %12s %12s %12s %8s \n", "Stage", "Count", "Total (ms)", "Self (ms)", "Avg (ms)", "Max (ms)", "Share");
+
+        for (const auto& stage : sortedStages)
+        {
+            printf("%-32s %8u %12.2f %12.2f %12.2f %12.2f %7.1f%% \n",
+                stage.name,
+                stage.count,
+                stage.total * 1e-3,
+                stage.self * 1e-3,
+                stage.total * 1e-3 / stage.count,
+                stage.max * 1e-3,
+                totalTime > 0ll ? 100.0 * stage.self / totalTime : 0.0);
+        }
+
+        printf("\n%-48s %12s %8s  %s \n", "Asset", "Total (ms)", "Share", "Dominant stage");
+
+        auto assetCount = 0u;
+
+        for (const auto& asset : assets)
+        {
+            if (asset.index == 0u || asset.total <= 0ll)
+            {
+                continue;
+            }
+
+            if (assetCount++ >= maxAssetCount)
+            {
+                continue;
+            }
+
+            auto dominant = std::max_element(asset.stages.begin(), asset.stages.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+            auto name = s_profile.assetNames.at(asset.index);
+            char dominantText[128] = "-";
+
+            if (dominant != asset.stages.end())
+            {
+                snprintf(dominantText, sizeof(dominantText), "%s (%.2fms)", dominant->first.c_str(), dominant->second * 1e-3);
+            }
+
+            if (name.size() > 48u)
+            {
+                name = "..." + name.substr(name.size() - 45u);
+            }
+
+            printf("%-48s %12.2f %7.1f%%  %s \n", name.c_str(), asset.total * 1e-3, totalTime > 0ll ? 100.0 * asset.total / totalTime : 0.0, dominantText);
+        }
+
+        if (assetCount > maxAssetCount)
+        {
+            printf("... %u more assets \n", assetCount - maxAssetCount);
+        }
+
+        fflush(stdout);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+#define PK_PROFILE_CONCAT_INTERNAL(a, b) a##b
+#define PK_PROFILE_CONCAT(a, b) PK_PROFILE_CONCAT_INTERNAL(a, b)
+#define PK_PROFILE_SCOPE(name) PKAssets::Profiler::ProfileScope PK_PROFILE_CONCAT(pk_profile_scope_, __LINE__)(name)
+
+namespace PKAssets::Profiler
+{
+    // Scopes are recorded into per thread buffers & tagged with the asset that is being cooked on that thread.
+    // Names are expected to be string literals. Scopes are no-ops unless profiling is enabled.
+    struct ProfileScope
+    {
+        ProfileScope(const char* name);
+        ~ProfileScope();
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+        private:
+            const char* name;
+            int64_t startTime;
+    };
+
+    void Enable();
+    bool IsEnabled();
+    void BeginAsset(const char* name);
+    void EndAsset();
+
+    // Worker processes return their events to the main process. Times are relative to the start time passed to each side.
+    // Events are taken from all threads & added to the calling thread of the main process.
+    int64_t GetTime();
+    void TakeEvents(int64_t startTime, std::string& outEvents);
+    void AddEvents(int64_t startTime, const std::string& events);
+
+    // Chrome/Perfetto trace event json. Open with chrome://tracing or ui.perfetto.dev.
+    bool WriteTrace(const char* path);
+    void WriteSummary(uint32_t maxAssetCount);
+}
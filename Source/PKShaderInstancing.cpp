@@ -2,6 +2,7 @@
 #include "PKStringUtilities.h"
 #include "PKShaderUtilities.h"
 #include "PKAssetWriter.h"
+#include "PKLogUtilities.h"
 
 namespace PKAssets::Shader::Instancing
 {
@@ -35,7 +36,7 @@ namespace PKAssets::Shader::Instancing
 
         if (pos == std::string::npos)
         {
-            printf("Warning: No main() found for instancing instert.\n");
+            LogUtilities::Printf("Warning: No main() found for instancing instert.\n");
             return;
         }
 
@@ -43,7 +44,7 @@ namespace PKAssets::Shader::Instancing
 
         if (pos == std::string::npos)
         {
-            printf("Warning: No { found after main() for instancing instert.\n");
+            LogUtilities::Printf("Warning: No { found after main() for instancing instert.\n");
             return;
         }
 
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include "PKStringUtilities.h"
 #include "PKShaderUtilities.h"
+#include "PKLogUtilities.h"
 
 namespace PKAssets::Shader
 {
@@ -550,7 +551,7 @@ namespace PKAssets::Shader
 
             if (posclose == std::string::npos)
             {
-                printf("Couldnt find a valid control flow scope after [pk_local] attribute.\n");
+                LogUtilities::Printf("Couldnt find a valid control flow scope after [pk_local] attribute.\n");
                 return -1;
             }
 
@@ -976,7 +977,7 @@ namespace PKAssets::Shader
             {
                 if (member.field.compare(field) != 0)
                 {
-                    printf("Warning constant parameter '%s' was declared again with a different format '%s'", member.field.c_str(), field.c_str());
+                    LogUtilities::Printf("Warning constant parameter '%s' was declared again with a different format '%s'", member.field.c_str(), field.c_str());
                 }
 
                 member.stageFlags |= 1u << (uint32_t)stage;
@@ -8,6 +8,9 @@
 #include "PKShaderUtilities.h"
 #include "PKShaderInstancing.h"
 #include "PKFileVersionUtilities.h"
+#include "PKCookCache.h"
+#include "PKLogUtilities.h"
+#include "PKProfiler.h"
 #include "PKAssetWriter.h"
 #include "PKShaderWriter.h"
 
@@ -19,12 +22,6 @@
 
 namespace PKAssets::Shader
 {
-    static bool ReadFile(const std::string& filepath, std::string& ouput, std::filesystem::file_time_type lastDestWriteTime)
-    {
-        std::vector<std::string> includes;
-        ouput = StringUtilities::ReadFileRecursiveInclude(filepath, includes);
-        return PKVersionUtilities::IsFileAnyOutOfDate(includes, lastDestWriteTime);
-    }
 
     static void ExtractMulticompiles(std::string& source, std::vector<std::string>& outVariantDefines, std::vector<PKShaderKeyword>& outKeywords)
     {
@@ -45,13 +42,13 @@ namespace PKAssets::Shader
 
             if (vcount >= PK_ASSET_MAX_SHADER_KEYWORDS)
             {
-                printf("Warning maximum number of shader variants exceeded!.\n");
+                LogUtilities::Printf("Warning maximum number of shader variants exceeded!.\n");
                 continue;
             }
 
             if (dcount >= PK_ASSET_MAX_SHADER_DIRECTIVES)
             {
-                printf("Warning maximum number of shader multicompile directives reached!.\n");
+                LogUtilities::Printf("Warning maximum number of shader multicompile directives reached!.\n");
                 continue;
             }
 
@@ -59,7 +56,7 @@ namespace PKAssets::Shader
 
             if (directive.size() >= PK_ASSET_MAX_SHADER_DIRECTIVE_SIZE)
             {
-                printf("Warning multicompile directive keyword count exceeds supported limits!\n");
+                LogUtilities::Printf("Warning multicompile directive keyword count exceeds supported limits!\n");
                 continue;
             }
 
@@ -127,7 +124,7 @@ namespace PKAssets::Shader
 
             if (directives.size() != 2 && directives.size() != 3)
             {
-                printf("Entry point declaration contains an invalid amount of arguments (should be name, stage)\n");
+                LogUtilities::Printf("Entry point declaration contains an invalid amount of arguments (should be name, stage)\n");
                 return -1;
             }
 
@@ -135,7 +132,7 @@ namespace PKAssets::Shader
 
             if (stage == PKShaderStage::MaxCount)
             {
-                printf("Unsupported shader stage specified! \n");
+                LogUtilities::Printf("Unsupported shader stage specified! \n");
                 return -1;
             }
 
@@ -147,7 +144,7 @@ namespace PKAssets::Shader
 
             if (source.find(info.functionName, 0u) == std::string::npos)
             {
-                printf("Definition for declared entry point %s was not found!", info.name.c_str());
+                LogUtilities::Printf("Definition for declared entry point %s was not found!", info.name.c_str());
                 return -1;
             }
 
@@ -208,14 +205,15 @@ namespace PKAssets::Shader
 
     static int32_t PreprocessGLSL(const ShaderCompiler& compiler, const CompileOptions& options, PKShaderStage stage, const std::string& name, std::string& source)
     {
+        PK_PROFILE_SCOPE("PreprocessGLSL");
         auto result = compiler.PreprocessGlsl(source, ConvertToShadercKind(stage), name.c_str(), options);
 
         if (result.GetCompilationStatus() != shaderc_compilation_status_success)
         {
-            printf("\n ----------BEGIN ERROR---------- \n");
-            printf("\n Stage: %s\n\n", PK_SHADER_STAGE_NAMES[(uint32_t)stage]);
-            printf("%s", result.GetErrorMessage().c_str());
-            printf("\n ----------END ERROR---------- \n\n");
+            LogUtilities::Printf("\n ----------BEGIN ERROR---------- \n");
+            LogUtilities::Printf("\n Stage: %s\n\n", PK_SHADER_STAGE_NAMES[(uint32_t)stage]);
+            LogUtilities::Printf("%s", result.GetErrorMessage().c_str());
+            LogUtilities::Printf("\n ----------END ERROR---------- \n\n");
             return -1;
         }
 
@@ -234,10 +232,10 @@ namespace PKAssets::Shader
             SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 12);
             #endif
 
-            printf("\n ----------BEGIN ERROR---------- \n");
-            printf("\n Stage: %s\n\n", PK_SHADER_STAGE_NAMES[(uint32_t)stage]);
-            printf("%s", FormatErrorMessage(name, source, result.GetErrorMessage()).c_str());
-            printf("\n ----------END ERROR---------- \n\n");
+            LogUtilities::Printf("\n ----------BEGIN ERROR---------- \n");
+            LogUtilities::Printf("\n Stage: %s\n\n", PK_SHADER_STAGE_NAMES[(uint32_t)stage]);
+            LogUtilities::Printf("%s", FormatErrorMessage(name, source, result.GetErrorMessage()).c_str());
+            LogUtilities::Printf("\n ----------END ERROR---------- \n\n");
 
             #if defined(WIN32)
             SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 15);
@@ -246,7 +244,7 @@ namespace PKAssets::Shader
 
         if (result.GetCompilationStatus() != shaderc_compilation_status_success)
         {
-            printf("Failed to compile SPIRV from shader variant source! \n");
+            LogUtilities::Printf("Failed to compile SPIRV from shader variant source! \n");
             return nullptr;
         }
 
@@ -256,7 +254,7 @@ namespace PKAssets::Shader
 
         if (codeStatus != SPV_REFLECT_RESULT_SUCCESS)
         {
-            printf("Failed to extract reflection data from shader variant source! \n");
+            LogUtilities::Printf("Failed to extract reflection data from shader variant source! \n");
             delete module;
             return nullptr;
         }
@@ -297,7 +295,7 @@ namespace PKAssets::Shader
 
         if (count > 0 && reflection.logVerbose)
         {
-            printf("    Interface:");
+            LogUtilities::Printf("    Interface:");
         }
 
         for (auto* variable : variables)
@@ -310,7 +308,7 @@ namespace PKAssets::Shader
 
             if (reflection.vertexAttributes.size() >= PK_ASSET_MAX_VERTEX_ATTRIBUTES)
             {
-                printf("Warning! Shader has more vertex attributes than supported (%i / %i) \n", (int)reflection.vertexAttributes.size(), PK_ASSET_MAX_VERTEX_ATTRIBUTES);
+                LogUtilities::Printf("Warning! Shader has more vertex attributes than supported (%i / %i) \n", (int)reflection.vertexAttributes.size(), PK_ASSET_MAX_VERTEX_ATTRIBUTES);
                 continue;
             }
 
@@ -322,13 +320,13 @@ namespace PKAssets::Shader
 
             if (reflection.logVerbose)
             {
-                printf(" %s ", variable->name);
+                LogUtilities::Printf(" %s ", variable->name);
             }
         }
 
         if (count > 0 && reflection.logVerbose)
         {
-            printf("\n");
+            LogUtilities::Printf("\n");
         }
     }
 
@@ -347,7 +345,7 @@ namespace PKAssets::Shader
 
         if (reflection.logVerbose)
         {
-            printf("    Constants:");
+            LogUtilities::Printf("    Constants:");
         }
 
         reflection.constantRangeStageFlags |= stageFlag;
@@ -368,13 +366,13 @@ namespace PKAssets::Shader
                 
             if (reflection.logVerbose)
             {
-                printf(" %s", name.c_str());
+                LogUtilities::Printf(" %s", name.c_str());
             }
         }
 
         if (reflection.logVerbose)
         {
-            printf("\n");
+            LogUtilities::Printf("\n");
         }
     }
 
@@ -402,7 +400,7 @@ namespace PKAssets::Shader
 
         if (logVerbose && (outSize[0] > 0u || outSize[1] > 0u || outSize[2] > 0u))
         {
-            printf("    GroupSize: %i,%i,%i\n", outSize[0], outSize[1], outSize[2]);
+            LogUtilities::Printf("    GroupSize: %i,%i,%i\n", outSize[0], outSize[1], outSize[2]);
         }
     }
 
@@ -455,13 +453,14 @@ namespace PKAssets::Shader
 
             if (reflection.logVerbose)
             {
-                printf("    Resource %s: %s \n", isWritten ? "Write" : "Read", name.c_str());
+                LogUtilities::Printf("    Resource %s: %s \n", isWritten ? "Write" : "Read", name.c_str());
             }
         }
     }
 
     static void CompressBindIndices(ReflectionData& reflection)
     {
+        PK_PROFILE_SCOPE("CompressBindIndices");
         auto setflags = 0u;
 
         for (auto& kv : reflection.uniqueBindings)
@@ -545,17 +544,23 @@ namespace PKAssets::Shader
 
     int WriteShader(const char* pathSrc, const char* pathDst, const size_t pathStemOffset)
     {
-        std::string source;
-        
-        auto lastWriteTime = PKVersionUtilities::GetLastWriteTime(pathDst);
-        auto isOutOfDate = PKVersionUtilities::IsFileOutOfDate(pathSrc, pathDst);
-        isOutOfDate |= ReadFile(pathSrc, source, lastWriteTime);
-
-        if (!isOutOfDate)
+        if (!PKVersionUtilities::IsAssetOutOfDate(pathSrc, pathDst))
         {
             return 1;
         }
 
+        std::vector<std::string> includes;
+        std::map<std::string, std::vector<std::string>> includeGraph;
+        auto source = StringUtilities::ReadFileRecursiveInclude(pathSrc, includes, &includeGraph);
+        PKVersionUtilities::ValidateIncludeGraph(includeGraph);
+        auto cacheKey = CookCache::GetKey(pathSrc, pathDst, source.data(), source.size());
+
+        if (CookCache::Restore(cacheKey, pathDst, pathStemOffset))
+        {
+            PKVersionUtilities::RecordAsset(pathSrc, pathDst, includeGraph);
+            return 0;
+        }
+
         auto filename = StringUtilities::ReadFileName(pathSrc);
         auto buffer = PKAssetBuffer();
         buffer.header->type = PKAssetType::Shader;
@@ -563,7 +568,8 @@ namespace PKAssets::Shader
 
         auto shader = buffer.Allocate<PKShader>();
 
-        ShaderCompiler compiler;
+        // Compiler construction is expensive. Keep one resident per cook thread.
+        static thread_local ShaderCompiler compiler;
         std::vector<std::string> variantDefines;
         std::vector<PKShaderKeyword> keywords;
         std::vector<PKMaterialProperty> materialProperties;
@@ -597,7 +603,7 @@ namespace PKAssets::Shader
         // Sadly this happens after includes :/
         if (logVerbose)
         {
-            printf("Preprocessing shader: %s \n", filename.c_str());
+            LogUtilities::Printf("Preprocessing shader: %s \n", filename.c_str());
         }
 
         ExtractMulticompiles(source, variantDefines, keywords);
@@ -650,7 +656,7 @@ namespace PKAssets::Shader
 
                 if (RemoveEntryPointLocals(stageSources[stageIndex], entry.name, entry.stage) != 0)
                 {
-                    printf("Failed to remove entry point locals! \n");
+                    LogUtilities::Printf("Failed to remove entry point locals! \n");
                     return -1;
                 }
 
@@ -696,12 +702,23 @@ namespace PKAssets::Shader
 
                     if (logVerbose)
                     {
-                        printf("Compiling %s:%i %s \n", entry.name.c_str(), variantIndex, PK_SHADER_STAGE_NAMES[stageIndex]);
+                        LogUtilities::Printf("Compiling %s:%i %s \n", entry.name.c_str(), variantIndex, PK_SHADER_STAGE_NAMES[stageIndex]);
                     }
 
                     // Need to do double compile as debug mode will have variable names but release mode wont.
-                    auto moduleDeb = CompileToSPIRV(compiler, optionsDebug, entry.stage, entry.name, stageSource);
-                    auto moduleRel = moduleDeb ? CompileToSPIRV(compiler, optionsRelease, entry.stage, entry.name, stageSource) : nullptr;
+                    SpvReflectShaderModule* moduleDeb = nullptr;
+                    SpvReflectShaderModule* moduleRel = nullptr;
+
+                    {
+                        PK_PROFILE_SCOPE("CompileToSPIRV (Debug)");
+                        moduleDeb = CompileToSPIRV(compiler, optionsDebug, entry.stage, entry.name, stageSource);
+                    }
+
+                    if (moduleDeb != nullptr)
+                    {
+                        PK_PROFILE_SCOPE("CompileToSPIRV (Release)");
+                        moduleRel = CompileToSPIRV(compiler, optionsRelease, entry.stage, entry.name, stageSource);
+                    }
 
                     if (moduleDeb == nullptr)
                     {
@@ -752,7 +769,7 @@ namespace PKAssets::Shader
                 {
                     if (j >= PK_ASSET_MAX_PUSH_CONSTANTS)
                     {
-                        printf("Warning! Shader has more push constants than supported (%i / %i) \n", j, PK_ASSET_MAX_PUSH_CONSTANTS);
+                        LogUtilities::Printf("Warning! Shader has more push constants than supported (%i / %i) \n", j, PK_ASSET_MAX_PUSH_CONSTANTS);
                         continue;
                     }
 
@@ -771,7 +788,7 @@ namespace PKAssets::Shader
 
                 if (pVariants[variantIndex].descriptorCount > PK_ASSET_MAX_DESCRIPTORS_PER_SET)
                 {
-                    printf("Warning! Shader has a descriptors outside of supported range (%i / %i) \n", pVariants[variantIndex].descriptorCount, PK_ASSET_MAX_DESCRIPTORS_PER_SET);
+                    LogUtilities::Printf("Warning! Shader has a descriptors outside of supported range (%i / %i) \n", pVariants[variantIndex].descriptorCount, PK_ASSET_MAX_DESCRIPTORS_PER_SET);
                 }
 
                 for (auto j = 0u; j < reflectionData.sortedBindings.size(); ++j)
@@ -789,6 +806,13 @@ namespace PKAssets::Shader
             ReleaseReflectionData(reflectionData);
         }
 
-        return WriteAsset(pathDst, pathStemOffset, buffer, false);
+        if (WriteAsset(pathDst, pathStemOffset, buffer, false) != 0)
+        {
+            return -1;
+        }
+
+        CookCache::Store(cacheKey, pathDst);
+        PKVersionUtilities::RecordAsset(pathSrc, pathDst, includeGraph);
+        return 0;
     }
 }
\ No newline at end of file
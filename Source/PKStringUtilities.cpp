@@ -1,8 +1,62 @@
 #include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
 #include "PKStringUtilities.h"
 
 namespace PKAssets::StringUtilities
 {
+    struct CachedFile
+    {
+        uintmax_t size = 0ull;
+        std::filesystem::file_time_type writeTime;
+        std::string text;
+    };
+
+    // Shared includes are read by most shaders. Keep their contents resident until they change on disk.
+    static std::unordered_map<std::string, CachedFile> s_fileCache;
+    static std::mutex s_fileCacheLock;
+
+    static bool ReadFileCached(const std::string& filepath, std::string& outText)
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(filepath, error);
+        auto writeTime = error ? std::filesystem::file_time_type() : std::filesystem::last_write_time(filepath, error);
+
+        if (error)
+        {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_fileCacheLock);
+            auto iter = s_fileCache.find(filepath);
+
+            if (iter != s_fileCache.end() && iter->second.size == size && iter->second.writeTime == writeTime)
+            {
+                outText = iter->second.text;
+                return true;
+            }
+        }
+
+        std::ifstream file(filepath, std::ios::in);
+
+        if (!file)
+        {
+            return false;
+        }
+
+        outText.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        std::lock_guard<std::mutex> lock(s_fileCacheLock);
+        auto& entry = s_fileCache[filepath];
+        entry.size = size;
+        entry.writeTime = writeTime;
+        entry.text = outText;
+        return true;
+    }
+
     std::string Trim(const std::string& value)
     {
         auto first = value.find_first_not_of(" \n\r");
@@ -88,22 +142,24 @@ namespace PKAssets::StringUtilities
         return filepath.substr(0, lastSlash);
     }
 
-    std::string ReadFileRecursiveInclude(const std::string& filepath, std::vector<std::string>& outIncludes)
+    std::string ReadFileRecursiveInclude(const std::string& filepath, std::vector<std::string>& outIncludes, std::map<std::string, std::vector<std::string>>* outIncludeGraph)
     {
         auto includeOnceToken = "#pragma once";
         auto includeToken = "#include ";
         auto includeTokenLength = strlen(includeToken);
         auto foundPragmaOnce = false;
 
-        std::ifstream file(filepath, std::ios::in);
+        std::string text;
 
-        if (!file)
+        if (!ReadFileCached(filepath, text))
         {
             return "FAILED TO OPEN: " + filepath;
         }
 
+        std::istringstream file(text);
         std::string result;
         std::string lineBuffer;
+        std::vector<std::string> includes;
 
         while (std::getline(file, lineBuffer))
         {
@@ -113,7 +169,6 @@ namespace PKAssets::StringUtilities
 
                 if (std::find(outIncludes.begin(), outIncludes.end(), filepath) != outIncludes.end())
                 {
-                    file.close();
                     return "";
                 }
 
@@ -137,14 +192,18 @@ namespace PKAssets::StringUtilities
 
                 lineBuffer = lineBuffer.substr(pos0 + 1u, pos1 - pos0 - 1u);
                 lineBuffer.insert(0, filepath.substr(0, filepath.find_last_of("/\\") + 1));
-                result += ReadFileRecursiveInclude(lineBuffer, outIncludes);
+                includes.push_back(lineBuffer);
+                result += ReadFileRecursiveInclude(lineBuffer, outIncludes, outIncludeGraph);
                 continue;
             }
 
             result += lineBuffer + '\n';
         }
 
-        file.close();
+        if (outIncludeGraph != nullptr)
+        {
+            (*outIncludeGraph)[filepath] = std::move(includes);
+        }
 
         return result;
     }
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <map>
 
 namespace PKAssets::StringUtilities
 {
@@ -9,7 +10,7 @@ namespace PKAssets::StringUtilities
     std::vector<std::string> SplitNoWhiteSpace(const std::string& value, const char* symbols);
     std::string ReadFileName(const std::string& filepath);
     std::string ReadDirectory(const std::string& filepath);
-    std::string ReadFileRecursiveInclude(const std::string& filepath, std::vector<std::string>& outIncludes);
+    std::string ReadFileRecursiveInclude(const std::string& filepath, std::vector<std::string>& outIncludes, std::map<std::string, std::vector<std::string>>* outIncludeGraph = nullptr);
     std::string ExtractToken(const char* token, std::string& source, bool includeToken, bool trim = false);
     std::string GetLineAtIndex(const std::string& string, size_t index);
     size_t ExtractToken(size_t offset, const char* token, std::string& source, std::string& output, bool includeToken, bool trim = false);
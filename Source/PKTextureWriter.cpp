@@ -4,6 +4,8 @@
 #include "PKStringUtilities.h"
 #include "PKAssetWriter.h"
 #include "PKFileVersionUtilities.h"
+#include "PKCookCache.h"
+#include "PKLogUtilities.h"
 
 namespace PKAssets::Texture
 {
@@ -87,11 +89,19 @@ namespace PKAssets::Texture
 
     int WriteTexture(const char* pathSrc, const char* pathDst, const size_t pathStemOffset)
     {
-        if (!PKVersionUtilities::IsFileOutOfDate(pathSrc, pathDst))
+        if (!PKVersionUtilities::IsAssetOutOfDate(pathSrc, pathDst))
         {
             return 1;
         }
 
+        auto cacheKey = CookCache::GetKey(pathSrc, pathDst);
+
+        if (CookCache::Restore(cacheKey, pathDst, pathStemOffset))
+        {
+            PKVersionUtilities::RecordAsset(pathSrc, pathDst, {});
+            return 0;
+        }
+
         auto filename = StringUtilities::ReadFileName(pathSrc);
 
         ktxTexture2* ktxTex2;
@@ -100,7 +110,7 @@ namespace PKAssets::Texture
 
         if (result != KTX_SUCCESS)
         {
-            printf("Failed to load KTX texture: %s", ktxErrorString(result));
+            LogUtilities::Printf("Failed to load KTX texture: %s", ktxErrorString(result));
             return -1;
         }
 
@@ -146,30 +156,56 @@ namespace PKAssets::Texture
         }
 
 
-        std::vector<uint32_t> levelOffsets;
-        levelOffsets.resize(ktxTex2->numLevels);
+        std::vector<uint32_t> ktxOffsets;
+        ktxOffsets.resize(ktxTex2->numLevels);
 
         // KTX 2 stores all levels in tightly packed form. no need to iterate on other data.
         for (auto level = 0u; level < ktxTex2->numLevels; ++level)
         {
             size_t offset = 0ull;
             auto result = ktxTexture_GetImageOffset(ktxTexture(ktxTex2), level, 0, 0, &offset);
-            levelOffsets[level] = (uint32_t)offset;
+            ktxOffsets[level] = (uint32_t)offset;
             
             if (result != KTX_SUCCESS)
             {
-                printf("Failed to get image buffer offset");
+                LogUtilities::Printf("Failed to get image buffer offset");
                 return -1;
             }
         }
 
-        auto pData = buffer.Write(ktxTextureData, ktxTextureSize);
-        auto pLevels = buffer.Write(levelOffsets.data(), levelOffsets.size());
+        // Levels are stored smallest first, each in a section of its own. Small levels can be loaded ahead of & without the large ones.
+        auto pLevels = buffer.Allocate<uint32_t>(ktxTex2->numLevels);
+        auto pData = buffer.Allocate<uint8_t>(ktxTextureSize);
+        auto dataSize = 0ull;
+
+        for (auto level = ktxTex2->numLevels; level-- > 0u;)
+        {
+            auto levelEnd = (uint32_t)ktxTextureSize;
+
+            for (auto other : ktxOffsets)
+            {
+                levelEnd = other > ktxOffsets[level] && other < levelEnd ? other : levelEnd;
+            }
+
+            auto levelSize = levelEnd - ktxOffsets[level];
+            memcpy(pData.get() + dataSize, ktxTextureData + ktxOffsets[level], levelSize);
+            buffer.AddSection(WritePtr<uint8_t>(&buffer, pData.offset + (uint32_t)dataSize), levelSize);
+            pLevels[level] = (uint32_t)dataSize;
+            dataSize += levelSize;
+        }
+
         pkTexture->data.Set(buffer.data(), pData.get());
         pkTexture->levelOffsets.Set(buffer.data(), pLevels.get());
 
         ktxTexture_Destroy(ktxTexture(ktxTex2));
 
-        return WriteAsset(pathDst, pathStemOffset, buffer, true);
+        if (WriteAsset(pathDst, pathStemOffset, buffer, false) != 0)
+        {
+            return -1;
+        }
+
+        CookCache::Store(cacheKey, pathDst);
+        PKVersionUtilities::RecordAsset(pathSrc, pathDst, {});
+        return 0;
     }
 }
\ No newline at end of file
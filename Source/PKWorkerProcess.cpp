@@ -0,0 +1,403 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <stdint.h>
+#include "PKWorkerProcess.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+namespace PKAssets
+{
+    constexpr static const uint32_t WORKER_MESSAGE_MAX_SIZE = 1u << 30u;
+
+#ifdef _WIN32
+    struct WorkerProcess
+    {
+        PROCESS_INFORMATION process{};
+        HANDLE input = nullptr;
+        HANDLE output = nullptr;
+    };
+
+    static bool WriteBytes(HANDLE handle, const void* data, size_t size)
+    {
+        auto head = reinterpret_cast<const char*>(data);
+
+        while (size > 0ull)
+        {
+            DWORD written = 0u;
+
+            if (!WriteFile(handle, head, (DWORD)size, &written, nullptr) || written == 0u)
+            {
+                return false;
+            }
+
+            head += written;
+            size -= written;
+        }
+
+        return true;
+    }
+
+    static bool ReadBytes(HANDLE handle, void* data, size_t size)
+    {
+        auto head = reinterpret_cast<char*>(data);
+
+        while (size > 0ull)
+        {
+            DWORD read = 0u;
+
+            if (!ReadFile(handle, head, (DWORD)size, &read, nullptr) || read == 0u)
+            {
+                return false;
+            }
+
+            head += read;
+            size -= read;
+        }
+
+        return true;
+    }
+
+    static std::string QuoteArgument(const std::string& argument)
+    {
+        if (!argument.empty() && argument.find_first_of(" \t\"") == std::string::npos)
+        {
+            return argument;
+        }
+
+        std::string result = "\"";
+        auto backslashCount = 0ull;
+
+        for (auto c : argument)
+        {
+            if (c == '\\')
+            {
+                backslashCount++;
+                continue;
+            }
+
+            // Backslashes preceding a quote need to be escaped as well.
+            result.append(c == '\"' ? backslashCount * 2ull + 1ull : backslashCount, '\\');
+            result += c;
+            backslashCount = 0ull;
+        }
+
+        result.append(backslashCount * 2ull, '\\');
+        result += '\"';
+        return result;
+    }
+
+    WorkerProcess* StartWorkerProcess(const std::vector<std::string>& arguments)
+    {
+        SECURITY_ATTRIBUTES attributes{};
+        attributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+        attributes.bInheritHandle = TRUE;
+
+        HANDLE childInput = nullptr;
+        HANDLE childOutput = nullptr;
+        auto worker = new WorkerProcess();
+
+        if (!CreatePipe(&childInput, &worker->input, &attributes, 0u) || !CreatePipe(&worker->output, &childOutput, &attributes, 0u))
+        {
+            StopWorkerProcess(worker);
+            return nullptr;
+        }
+
+        // Parent ends must not be inherited. Otherwise the child never observes the end of its input.
+        SetHandleInformation(worker->input, HANDLE_FLAG_INHERIT, 0u);
+        SetHandleInformation(worker->output, HANDLE_FLAG_INHERIT, 0u);
+
+        std::string commandLine;
+
+        for (const auto& argument : arguments)
+        {
+            commandLine += commandLine.empty() ? "" : " ";
+            commandLine += QuoteArgument(argument);
+        }
+
+        STARTUPINFOA startupInfo{};
+        startupInfo.cb = sizeof(STARTUPINFOA);
+        startupInfo.dwFlags = STARTF_USESTDHANDLES;
+        startupInfo.hStdInput = childInput;
+        startupInfo.hStdOutput = childOutput;
+        startupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+        auto isCreated = CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE, 0u, nullptr, nullptr, &startupInfo, &worker->process);
+        CloseHandle(childInput);
+        CloseHandle(childOutput);
+
+        if (!isCreated)
+        {
+            worker->process = PROCESS_INFORMATION();
+            StopWorkerProcess(worker);
+            return nullptr;
+        }
+
+        return worker;
+    }
+
+    std::string StopWorkerProcess(WorkerProcess* worker)
+    {
+        if (worker == nullptr)
+        {
+            return "";
+        }
+
+        if (worker->input != nullptr)
+        {
+            CloseHandle(worker->input);
+        }
+
+        if (worker->output != nullptr)
+        {
+            CloseHandle(worker->output);
+        }
+
+        std::string result;
+
+        if (worker->process.hProcess != nullptr)
+        {
+            DWORD exitCode = 0u;
+            WaitForSingleObject(worker->process.hProcess, INFINITE);
+            GetExitCodeProcess(worker->process.hProcess, &exitCode);
+            CloseHandle(worker->process.hProcess);
+            CloseHandle(worker->process.hThread);
+            char text[64];
+            snprintf(text, sizeof(text), "exit code 0x%08lx", (unsigned long)exitCode);
+            result = text;
+        }
+
+        delete worker;
+        return result;
+    }
+
+    static HANDLE s_channelInput = nullptr;
+    static HANDLE s_channelOutput = nullptr;
+
+    bool OpenWorkerChannel()
+    {
+        fflush(stdout);
+        s_channelInput = GetStdHandle(STD_INPUT_HANDLE);
+        s_channelOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+
+        auto error = GetStdHandle(STD_ERROR_HANDLE);
+        SetStdHandle(STD_OUTPUT_HANDLE, error);
+        _dup2(_fileno(stderr), _fileno(stdout));
+        return s_channelInput != INVALID_HANDLE_VALUE && s_channelOutput != INVALID_HANDLE_VALUE;
+    }
+#else
+    struct WorkerProcess
+    {
+        pid_t process = -1;
+        int input = -1;
+        int output = -1;
+    };
+
+    static bool WriteBytes(int descriptor, const void* data, size_t size)
+    {
+        auto head = reinterpret_cast<const char*>(data);
+
+        while (size > 0ull)
+        {
+            auto written = write(descriptor, head, size);
+
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (written <= 0)
+            {
+                return false;
+            }
+
+            head += written;
+            size -= (size_t)written;
+        }
+
+        return true;
+    }
+
+    static bool ReadBytes(int descriptor, void* data, size_t size)
+    {
+        auto head = reinterpret_cast<char*>(data);
+
+        while (size > 0ull)
+        {
+            auto read = ::read(descriptor, head, size);
+
+            if (read < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (read <= 0)
+            {
+                return false;
+            }
+
+            head += read;
+            size -= (size_t)read;
+        }
+
+        return true;
+    }
+
+    WorkerProcess* StartWorkerProcess(const std::vector<std::string>& arguments)
+    {
+        // Writes to a crashed worker should fail instead of terminating the parent.
+        signal(SIGPIPE, SIG_IGN);
+
+        int childInput[2] = { -1, -1 };
+        int childOutput[2] = { -1, -1 };
+
+        // Workers are started from pool threads. Pipes are created close on exec so that a concurrent fork doesnt inherit them.
+        // Otherwise a worker never observes the end of its input & the parent never observes the end of a dead worker's output.
+        if (pipe2(childInput, O_CLOEXEC) != 0 || pipe2(childOutput, O_CLOEXEC) != 0)
+        {
+            for (auto descriptor : { childInput[0], childInput[1], childOutput[0], childOutput[1] })
+            {
+                if (descriptor >= 0)
+                {
+                    close(descriptor);
+                }
+            }
+
+            return nullptr;
+        }
+
+        std::vector<char*> argv;
+
+        for (const auto& argument : arguments)
+        {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+
+        argv.push_back(nullptr);
+
+        auto process = fork();
+
+        if (process == 0)
+        {
+            // Duplicated descriptors are not close on exec. Pipe ends that already are stdin or stdout keep the flag, so it is cleared.
+            if (childInput[0] != STDIN_FILENO)
+            {
+                dup2(childInput[0], STDIN_FILENO);
+            }
+            else
+            {
+                fcntl(STDIN_FILENO, F_SETFD, 0);
+            }
+
+            if (childOutput[1] != STDOUT_FILENO)
+            {
+                dup2(childOutput[1], STDOUT_FILENO);
+            }
+            else
+            {
+                fcntl(STDOUT_FILENO, F_SETFD, 0);
+            }
+
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+
+        close(childInput[0]);
+        close(childOutput[1]);
+
+        auto worker = new WorkerProcess();
+        worker->process = process;
+        worker->input = childInput[1];
+        worker->output = childOutput[0];
+
+        if (process < 0)
+        {
+            StopWorkerProcess(worker);
+            return nullptr;
+        }
+
+        return worker;
+    }
+
+    std::string StopWorkerProcess(WorkerProcess* worker)
+    {
+        if (worker == nullptr)
+        {
+            return "";
+        }
+
+        if (worker->input >= 0)
+        {
+            close(worker->input);
+        }
+
+        if (worker->output >= 0)
+        {
+            close(worker->output);
+        }
+
+        std::string result;
+
+        if (worker->process > 0)
+        {
+            int status = 0;
+
+            while (waitpid(worker->process, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+
+            result = WIFSIGNALED(status) ? "signal " + std::to_string(WTERMSIG(status)) : "exit code " + std::to_string(WEXITSTATUS(status));
+        }
+
+        delete worker;
+        return result;
+    }
+
+    static int s_channelInput = -1;
+    static int s_channelOutput = -1;
+
+    bool OpenWorkerChannel()
+    {
+        fflush(stdout);
+        s_channelInput = STDIN_FILENO;
+        s_channelOutput = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        return s_channelOutput >= 0;
+    }
+#endif
+
+    template<typename THandle>
+    static bool WriteMessage(THandle handle, const std::string& message)
+    {
+        auto size = (uint32_t)message.size();
+        return WriteBytes(handle, &size, sizeof(uint32_t)) && WriteBytes(handle, message.data(), message.size());
+    }
+
+    template<typename THandle>
+    static bool ReadMessage(THandle handle, std::string& outMessage)
+    {
+        uint32_t size = 0u;
+
+        if (!ReadBytes(handle, &size, sizeof(uint32_t)) || size > WORKER_MESSAGE_MAX_SIZE)
+        {
+            return false;
+        }
+
+        outMessage.resize(size);
+        return ReadBytes(handle, outMessage.data(), size);
+    }
+
+    bool WriteWorkerMessage(WorkerProcess* worker, const std::string& message) { return WriteMessage(worker->input, message); }
+    bool ReadWorkerMessage(WorkerProcess* worker, std::string& outMessage) { return ReadMessage(worker->output, outMessage); }
+    bool ReadChannelMessage(std::string& outMessage) { return ReadMessage(s_channelInput, outMessage); }
+    bool WriteChannelMessage(const std::string& message) { return WriteMessage(s_channelOutput, message); }
+}
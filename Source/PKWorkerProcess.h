@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace PKAssets
+{
+    // Child process with a bidirectional message channel over its stdin & stdout.
+    // Messages are length prefixed binary blobs.
+    struct WorkerProcess;
+
+    WorkerProcess* StartWorkerProcess(const std::vector<std::string>& arguments);
+
+    // Closes the channel & waits for the process to exit. Returns a description of how the process exited.
+    std::string StopWorkerProcess(WorkerProcess* worker);
+    bool WriteWorkerMessage(WorkerProcess* worker, const std::string& message);
+    bool ReadWorkerMessage(WorkerProcess* worker, std::string& outMessage);
+
+    // Worker side of the channel. Regular stdout output is redirected to stderr so that it cannot corrupt the channel.
+    bool OpenWorkerChannel();
+    bool ReadChannelMessage(std::string& outMessage);
+    bool WriteChannelMessage(const std::string& message);
+}
@@ -1,14 +1,26 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <filesystem>
+#include <chrono>
+#include <thread>
+#include <memory>
 #include <PKAsset.h>
-#include "PKShaderWriter.h"
-#include "PKMeshWriter.h"
-#include "PKFontWriter.h"
-#include "PKTextureWriter.h"
+#include <PKAssetEncoding.h>
+#include "PKAssetCooker.h"
+#include "PKAssetWriter.h"
+#include "PKJobScheduler.h"
+#include "PKCookCache.h"
+#include "PKProfiler.h"
+#include "PKEncodingBenchmark.h"
+#include "PKLoadingBenchmark.h"
+#include "PKPackWriter.h"
 #include "PKFileVersionUtilities.h"
 
 using namespace PKAssets;
 
+constexpr static const uint32_t PK_PROFILE_SUMMARY_ASSET_COUNT = 32u;
+
 static std::string ProcessPath(const std::string& path)
 {
     if (path.size() < 2)
@@ -31,76 +43,190 @@ static std::string ProcessPath(const std::string& path)
     return outpath;
 }
 
-static void WriteFileStatus(const int32_t status, const char* path, const size_t stemOffset)
+// Parses "<shader|mesh|font|texture>:<auto|huffman|rans>".
+static bool ParseCodecOption(const char* option)
 {
-    switch (status)
+    const char* typeNames[] = { "shader", "mesh", "font", "texture" };
+    const PKAssetType types[] = { PKAssetType::Shader, PKAssetType::Mesh, PKAssetType::Font, PKAssetType::Texture };
+    const char* codecNames[] = { "auto", "huffman", "rans" };
+    const uint32_t codecs[] = { PK_ASSET_CODEC_AUTO, PK_ASSET_ENCODE_CODEC_HUFFMAN, PK_ASSET_ENCODE_CODEC_RANS };
+
+    auto separator = strchr(option, ':');
+
+    if (separator == nullptr)
     {
-        case -1: printf("Failed to asset: %s \n", path + stemOffset); break;
-        case 1: printf("Asset was up to date: %s \n", path + stemOffset); break;
+        return false;
     }
+
+    for (auto i = 0u; i < 4u; ++i)
+    {
+        if (strncmp(option, typeNames[i], separator - option) != 0 || strlen(typeNames[i]) != (size_t)(separator - option))
+        {
+            continue;
+        }
+
+        for (auto j = 0u; j < 3u; ++j)
+        {
+            if (strcmp(separator + 1, codecNames[j]) == 0)
+            {
+                SetAssetCodec(types[i], codecs[j]);
+                return true;
+            }
+        }
+    }
+
+    return false;
 }
 
-void ProcessFilesRecursive(const std::string& basedir, const std::filesystem::path& subdir, const std::string& dstdir)
+static uint64_t GetCookerHash(const char* executablePath)
 {
-    for (const auto& entry : std::filesystem::directory_iterator(subdir))
+    // Any change in the cooker binary or the encoding options invalidates previously cooked assets.
+    uint64_t cookerHash = 0ull;
+    PKVersionUtilities::HashFile(std::filesystem::absolute(executablePath), &cookerHash);
+    cookerHash = PKVersionUtilities::HashBuffer(&PKVersionUtilities::PK_ASSET_TOOLS_VERSION, sizeof(uint64_t), cookerHash);
+
+    uint32_t codecs[] = { GetAssetCodec(PKAssetType::Shader), GetAssetCodec(PKAssetType::Mesh), GetAssetCodec(PKAssetType::Font), GetAssetCodec(PKAssetType::Texture) };
+    double costModel[] = { GetDiskBandwidth(), GetEncodeBudget(), GetDecodeSpeed() };
+    cookerHash = PKVersionUtilities::HashBuffer(codecs, sizeof(codecs), cookerHash);
+    return PKVersionUtilities::HashBuffer(costModel, sizeof(costModel), cookerHash);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> paths = { argv[0] };
+    auto threadCount = 1u;
+    auto workerCount = 0u;
+    auto isWatching = false;
+    auto isWorker = false;
+    auto memoryBudget = 0ull;
+    auto cacheSize = CookCache::PK_ASSET_CACHE_DEFAULT_SIZE;
+    const char* cachedir = nullptr;
+    const char* tracePath = nullptr;
+    std::vector<const char*> encodeOptions;
+
+    for (auto i = 1; i < argc; ++i)
     {
-        auto& entryPath = entry.path();
+        if (strcmp(argv[i], "--bench-encoding") == 0 && i + 1 < argc)
+        {
+            return Benchmark::RunEncodingBenchmark(argv[i + 1]) == 0 ? 0 : 1;
+        }
+
+        if (strcmp(argv[i], "--check-encoding") == 0)
+        {
+            return Benchmark::RunEncodingCheck() == 0 ? 0 : 1;
+        }
+
+        if (strcmp(argv[i], "--bench-loading") == 0 && i + 1 < argc)
+        {
+            return Benchmark::RunLoadingBenchmark(argv[i + 1]) == 0 ? 0 : 1;
+        }
+
+        if (strcmp(argv[i], "--pack") == 0 && i + 2 < argc)
+        {
+            return Packer::WritePack(argv[i + 1], argv[i + 2]) == 0 ? 0 : 1;
+        }
+
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            // Zero selects one thread per hardware thread.
+            threadCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            threadCount = threadCount == 0u ? std::thread::hardware_concurrency() : threadCount;
+            continue;
+        }
 
-        if (!entryPath.has_extension())
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
         {
-            ProcessFilesRecursive(basedir, entryPath, dstdir);
+            cachedir = argv[++i];
             continue;
         }
 
-        auto extension = entryPath.extension();
-        auto dstpath = std::filesystem::path(dstdir + std::filesystem::relative(entryPath, basedir).string());
-        auto stemOffset = dstdir.length();
+        if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc)
+        {
+            // Size limit in MiB.
+            cacheSize = strtoull(argv[++i], nullptr, 10) << 20ull;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            tracePath = argv[++i];
+            Profiler::Enable();
+            continue;
+        }
+
+        if (strcmp(argv[i], "--profile") == 0)
+        {
+            Profiler::Enable();
+            continue;
+        }
+
+        if (strcmp(argv[i], "--mem-budget") == 0 && i + 1 < argc)
+        {
+            // Estimated peak memory budget of concurrently cooked assets in MiB. Zero disables the budget.
+            memoryBudget = strtoull(argv[++i], nullptr, 10) << 20ull;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            // Zero selects one worker process per hardware thread.
+            workerCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            workerCount = workerCount == 0u ? std::thread::hardware_concurrency() : workerCount;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--codec") == 0 && i + 1 < argc)
+        {
+            if (!ParseCodecOption(argv[++i]))
+            {
+                printf("Invalid codec option: %s \n", argv[i]);
+                return 1;
+            }
+
+            encodeOptions.insert(encodeOptions.end(), { argv[i - 1], argv[i] });
+            continue;
+        }
 
-        if (extension.compare(Shader::PK_ASSET_SHADER_SRC_EXTENSION) == 0)
+        if (strcmp(argv[i], "--disk-bandwidth") == 0 && i + 1 < argc)
         {
-            auto dstpathstr = dstpath.replace_extension(PK_ASSET_EXTENSION_SHADER).string();
-            auto srcpathstr = entryPath.string();
-            auto writeStatus = Shader::WriteShader(srcpathstr.c_str(), dstpathstr.c_str(), stemOffset);
-            WriteFileStatus(writeStatus, dstpathstr.c_str(), stemOffset);
-            fflush(stdout);
+            // Disk bandwidth in MB/s used to model asset load cost when selecting encodings.
+            SetDiskBandwidth(strtod(argv[++i], nullptr) * 1e6);
+            encodeOptions.insert(encodeOptions.end(), { argv[i - 1], argv[i] });
             continue;
         }
 
-        if (extension.compare(Mesh::PK_ASSET_MESH_SRC_EXTENSION) == 0)
+        if (strcmp(argv[i], "--decode-speed") == 0 && i + 1 < argc)
         {
-            auto dstpathstr = dstpath.replace_extension(PK_ASSET_EXTENSION_MESH).string();
-            auto srcpathstr = entryPath.string();
-            auto writeStatus = Mesh::WriteMesh(srcpathstr.c_str(), dstpathstr.c_str(), stemOffset);
-            WriteFileStatus(writeStatus, dstpathstr.c_str(), stemOffset);
-            fflush(stdout);
+            // Scale of the modeled per codec decode throughput. Values below one model slower target CPUs.
+            SetDecodeSpeed(strtod(argv[++i], nullptr));
+            encodeOptions.insert(encodeOptions.end(), { argv[i - 1], argv[i] });
             continue;
         }
 
-        if (extension.compare(Font::PK_ASSET_FONT_SRC_EXTENSION) == 0)
+        if (strcmp(argv[i], "--encode-budget") == 0 && i + 1 < argc)
         {
-            auto dstpathstr = dstpath.replace_extension(PK_ASSET_EXTENSION_FONT).string();
-            auto srcpathstr = entryPath.string();
-            auto writeStatus = Font::WriteFont(srcpathstr.c_str(), dstpathstr.c_str(), stemOffset);
-            WriteFileStatus(writeStatus, dstpathstr.c_str(), stemOffset);
-            fflush(stdout);
+            // Modeled encode time budget per asset in milliseconds. Zero disables the budget.
+            SetEncodeBudget(strtod(argv[++i], nullptr) * 1e-3);
+            encodeOptions.insert(encodeOptions.end(), { argv[i - 1], argv[i] });
             continue;
         }
 
-        if (extension.compare(Texture::PK_ASSET_TEXTURE_SRC_EXTENSION) == 0)
+        if (strcmp(argv[i], "--worker") == 0)
         {
-            auto dstpathstr = dstpath.replace_extension(PK_ASSET_EXTENSION_TEXTURE).string();
-            auto srcpathstr = entryPath.string();
-            auto writeStatus = Texture::WriteTexture(srcpathstr.c_str(), dstpathstr.c_str(), stemOffset);
-            WriteFileStatus(writeStatus, dstpathstr.c_str(), stemOffset);
-            fflush(stdout);
+            isWorker = true;
             continue;
         }
+
+        if (strcmp(argv[i], "--watch") == 0)
+        {
+            isWatching = true;
+            continue;
+        }
+
+        paths.push_back(argv[i]);
     }
-}
 
-int main(int argc, char** argv)
-{
-    if (argc < 2 || argc > 3)
+    if (paths.size() < 2 || paths.size() > 3)
     {
         printf("Invalid number of arguments. current: %i \n", argc);
 
@@ -109,13 +235,34 @@ int main(int argc, char** argv)
             printf("%s \n", argv[i]);
         }
 
+        printf("Usage: <source directory> <destination directory> [-j thread count] [--workers process count] [--mem-budget MiB] [--cache directory] [--cache-size MiB] [--profile] [--trace file.json] [--watch] \n");
+        printf("       [--codec <shader|mesh|font|texture>:<auto|huffman|rans>] [--disk-bandwidth MB/s] [--decode-speed scale] [--encode-budget ms] \n");
+        printf("       --bench-encoding <file or directory> \n");
+        printf("       --check-encoding \n");
+        printf("       --bench-loading <file or directory> \n");
+        printf("       --pack <cooked directory> <file.pkpack> \n");
         return 0;
     }
 
     // Three arguments usually means that the working directory is included as the first argument.
-    auto offs = argc == 3 ? 1 : 0;
-    auto srcdir = std::filesystem::absolute(ProcessPath(argv[offs + 0])).string();
-    auto dstdir = std::filesystem::absolute(ProcessPath(argv[offs + 1])).string();
+    auto offs = paths.size() == 3 ? 1 : 0;
+    auto srcdir = std::filesystem::absolute(ProcessPath(paths[offs + 0])).string();
+    auto dstdir = std::filesystem::absolute(ProcessPath(paths[offs + 1])).string();
+
+    if (isWorker)
+    {
+        // Worker processes only cook the jobs they receive. The main process owns the manifest & snapshots.
+        // Other workers cook in parallel, so blocks are encoded on the worker thread only.
+        SetEncodeThreadCount(1u);
+        PKVersionUtilities::LoadManifest(srcdir, dstdir, GetCookerHash(argv[0]));
+
+        if (cachedir != nullptr)
+        {
+            CookCache::Open(std::filesystem::absolute(cachedir), cacheSize, GetCookerHash(argv[0]));
+        }
+
+        return Cooker::RunCookWorker();
+    }
 
     printf("Processing assets from: %s \n", srcdir.c_str());
     printf("to: %s \n", dstdir.c_str());
@@ -126,12 +273,117 @@ int main(int argc, char** argv)
         return 0;
     }
 
-    if (!PKVersionUtilities::IsDirectoryOutOfDate(srcdir, dstdir))
+    auto cookerHash = GetCookerHash(argv[0]);
+    PKVersionUtilities::LoadManifest(srcdir, dstdir, cookerHash);
+
+    if (cachedir != nullptr)
     {
-        printf("Assets are up to date.");
-        return 0;
+        CookCache::Open(std::filesystem::absolute(cachedir), cacheSize, cookerHash);
     }
 
-    ProcessFilesRecursive(srcdir, srcdir, dstdir);
+    // Each worker process is driven by one scheduler thread.
+    threadCount = workerCount > 0u ? workerCount : threadCount;
+    std::unique_ptr<JobScheduler> scheduler = threadCount > 1u || workerCount > 0u ? std::make_unique<JobScheduler>(threadCount) : nullptr;
+
+    // Jobs already run on every pool thread. Encoding the blocks of each job on all hardware threads would oversubscribe the cores.
+    SetEncodeThreadCount(scheduler ? 1u : 0u);
+
+    if (workerCount > 0u)
+    {
+        std::vector<std::string> workerArguments = { std::filesystem::absolute(argv[0]).string(), "--worker", srcdir, dstdir };
+
+        if (cachedir != nullptr)
+        {
+            workerArguments.insert(workerArguments.end(), { "--cache", std::filesystem::absolute(cachedir).string(), "--cache-size", std::to_string(cacheSize >> 20ull) });
+        }
+
+        workerArguments.insert(workerArguments.end(), encodeOptions.begin(), encodeOptions.end());
+
+        // Workers return their profile events with each job. The main process writes the summary & trace.
+        if (Profiler::IsEnabled())
+        {
+            workerArguments.push_back("--profile");
+        }
+
+        Cooker::StartWorkerProcesses(workerArguments, workerCount);
+    }
+
+    // File metadata is captured once per run & diffed against the previous run.
+    auto snapshotStart = std::chrono::steady_clock::now();
+    auto snapshotPath = std::filesystem::path(dstdir) / PKVersionUtilities::PK_ASSET_SNAPSHOT_FILENAME;
+    PKVersionUtilities::DirectorySnapshot sourceSnapshot;
+    PKVersionUtilities::DirectorySnapshot destinationSnapshot;
+    PKVersionUtilities::DirectorySnapshot previousSourceSnapshot;
+    PKVersionUtilities::DirectorySnapshot previousDestinationSnapshot;
+    PKVersionUtilities::SnapshotDiff sourceDiff;
+    PKVersionUtilities::SnapshotDiff destinationDiff;
+    uint64_t previousCookerHash = 0ull;
+    auto previousIsClean = false;
+
+    PKVersionUtilities::CaptureSnapshot(srcdir, scheduler.get(), {}, sourceSnapshot);
+    PKVersionUtilities::CaptureSnapshot(dstdir, scheduler.get(), { PKVersionUtilities::PK_ASSET_MANIFEST_FILENAME, PKVersionUtilities::PK_ASSET_SNAPSHOT_FILENAME }, destinationSnapshot);
+    auto hasPreviousSnapshot = PKVersionUtilities::LoadSnapshots(snapshotPath, &previousCookerHash, &previousIsClean, previousSourceSnapshot, previousDestinationSnapshot);
+    PKVersionUtilities::DiffSnapshots(previousSourceSnapshot, sourceSnapshot, sourceDiff);
+    PKVersionUtilities::DiffSnapshots(previousDestinationSnapshot, destinationSnapshot, destinationDiff);
+
+    printf("Snapshot: %u source files, %u destination files in %4.2fms \n",
+        (uint32_t)sourceSnapshot.entries.size(),
+        (uint32_t)destinationSnapshot.entries.size(),
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - snapshotStart).count());
+
+    if (hasPreviousSnapshot)
+    {
+        printf("Source changes since last run: Added: %u, Removed: %u, Modified: %u \n", (uint32_t)sourceDiff.added.size(), (uint32_t)sourceDiff.removed.size(), (uint32_t)sourceDiff.modified.size());
+    }
+
+    std::vector<Cooker::CookJob> jobs;
+    Cooker::GatherCookJobs(sourceSnapshot, srcdir, dstdir, jobs);
+
+    // Nothing to validate if neither tree nor any recorded include outside of the source directory changed since a run that cooked everything successfully.
+    auto isUpToDate = hasPreviousSnapshot && previousIsClean && previousCookerHash == cookerHash && sourceDiff.IsEmpty() && destinationDiff.IsEmpty();
+    isUpToDate = isUpToDate && !PKVersionUtilities::IsExternalFileChanged();
+
+    if (isUpToDate)
+    {
+        printf("No changes since last run. Assets up to date: %u \n", (uint32_t)jobs.size());
+    }
+    else
+    {
+        PKVersionUtilities::SetSnapshots(&sourceSnapshot, &destinationSnapshot);
+        auto statistics = Cooker::ExecuteCookJobs(jobs, scheduler.get(), memoryBudget);
+        PKVersionUtilities::SetSnapshots(nullptr, nullptr);
+        Cooker::WriteCookStatistics(statistics);
+
+        if (Profiler::IsEnabled())
+        {
+            Profiler::WriteSummary(PK_PROFILE_SUMMARY_ASSET_COUNT);
+        }
+
+        if (tracePath != nullptr)
+        {
+            Profiler::WriteTrace(tracePath);
+        }
+
+        for (const auto& job : jobs)
+        {
+            if (job.status != 1)
+            {
+                PKVersionUtilities::UpdateSnapshotEntry(destinationSnapshot, job.pathDst);
+            }
+        }
+
+        CookCache::Trim();
+        CookCache::WriteStatistics();
+        PKVersionUtilities::SaveManifest();
+        PKVersionUtilities::SaveSnapshots(snapshotPath, cookerHash, statistics.failedCount == 0u, sourceSnapshot, destinationSnapshot);
+    }
+
+    if (isWatching)
+    {
+        Cooker::WatchCookJobs(srcdir, dstdir, jobs, scheduler.get(), memoryBudget);
+    }
+
+    Cooker::StopWorkerProcesses();
+
     return 0;
 }
\ No newline at end of file
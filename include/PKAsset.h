@@ -1,4 +1,5 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 
 namespace PKAssets
@@ -12,6 +13,8 @@ namespace PKAssets
     constexpr static const uint32_t PK_ASSET_MAX_SHADER_DIRECTIVES = 16u;
     constexpr static const uint32_t PK_ASSET_MAX_SHADER_DIRECTIVE_SIZE = 16u;
     constexpr static const uint32_t PK_ASSET_MAX_UNBOUNDED_SIZE = 2048u;
+    constexpr static const uint32_t PK_ASSET_MAX_FILTERS = 16u;
+    constexpr static const uint32_t PK_ASSET_MAX_SECTIONS = 32u;
 
     constexpr static const char* PK_ASSET_EXTENSION_SHADER = ".pkshader";
     constexpr static const char* PK_ASSET_EXTENSION_MESH = ".pkmesh";
@@ -61,6 +64,44 @@ namespace PKAssets
 
         uint16_t decodePadding = 0u;                    // 76 bytes
         uint32_t uncompressedSize = 0u;                 // 80 bytes
+        uint8_t streamCount = 1u;                       // 81 bytes
+        uint8_t blockShift = 0u;                        // 82 bytes
+        uint8_t encodeFlags = 0u;                       // 83 bytes
+        uint8_t filterCount = 0u;                       // 84 bytes
+        uint8_t codec = 0u;                             // 85 bytes
+        uint8_t sectionCount = 0u;                      // 86 bytes
+        uint8_t __padding[2]{};                         // 88 bytes
+    };
+
+    // Byte plane filtered payload region. Compressed assets store filterCount of these between the header & the encoded payload.
+    // Offset is relative to the start of the asset (including the header).
+    struct PKAssetFilter
+    {
+        uint32_t offset = 0u;
+        uint32_t size = 0u;
+        uint16_t stride = 0u;
+        uint16_t flags = 0u;
+    };
+
+    // Independently block encoded payload region. Compressed assets store sectionCount of these after the filters.
+    // Sections cover the payload in order. Offset is relative to the start of the asset, encodedOffset to the start of the encoded payload.
+    struct PKAssetSection
+    {
+        uint32_t offset = 0u;
+        uint32_t size = 0u;
+        uint32_t encodedOffset = 0u;
+        uint32_t encodedSize = 0u;
+    };
+
+    // Allocations must be aligned to at least 16 bytes. Loads may allocate from several threads when used by the batch loader.
+    typedef void* (*PKAssetAllocateFunction)(void* userData, size_t size);
+    typedef void (*PKAssetFreeFunction)(void* userData, void* memory);
+
+    struct PKAssetAllocator
+    {
+        PKAssetAllocateFunction allocate = nullptr;
+        PKAssetFreeFunction free = nullptr;
+        void* userData = nullptr;
     };
 
     struct PKAsset
@@ -70,11 +111,25 @@ namespace PKAssets
             void* rawData = nullptr;
             PKAssetHeader* header;
         };
+
+        // Non zero when rawData points into a read only file mapping.
+        size_t mappedSize = 0ull;
+        // Allocator that owns rawData. Null for malloc.
+        const PKAssetAllocator* allocator = nullptr;
+        // rawData is a caller supplied buffer & isn't released by CloseAsset.
+        bool isExternal = false;
     };
 
+    constexpr static const intptr_t PK_ASSET_INVALID_FILE = -1;
+
+    // Streams read with positional reads on a file descriptor (a file handle on Windows) & can be used from several threads at once.
     struct PKAssetStream
     {
-        void* stream = nullptr;
+        intptr_t file = PK_ASSET_INVALID_FILE;
+        uint32_t* blockOffsets = nullptr;
+        PKAssetFilter* filters = nullptr;
+        PKAssetSection* sections = nullptr;
+        void* decoder = nullptr;
         PKAssetHeader header;
     };
 
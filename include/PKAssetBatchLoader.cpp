@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PKAssetBatchLoader.h"
+#include "PKAssetUring.h"
+
+namespace PKAssets
+{
+    struct PKAssetLoadJob
+    {
+        std::string filepath;
+        std::function<void(PKAsset*, int)> complete;
+        PKAssetLoad load;
+        int result = 0;
+    };
+
+    struct PKAssetBatchLoader
+    {
+        std::mutex mutex;
+        std::condition_variable ioCondition;
+        std::condition_variable decodeCondition;
+        std::condition_variable memoryCondition;
+        std::condition_variable idleCondition;
+        std::deque<PKAssetLoadJob*> ioQueue;
+        std::deque<PKAssetLoadJob*> decodeQueue;
+        std::vector<std::thread> threads;
+        size_t memoryBudget = 0ull;
+        size_t memoryInFlight = 0ull;
+        size_t pendingCount = 0ull;
+        uint32_t flags = 0u;
+        const PKAssetAllocator* allocator = nullptr;
+        bool isStopping = false;
+    };
+
+    static void PushDecodeJobs(PKAssetBatchLoader* loader, PKAssetLoadJob* const* jobs, uint32_t count)
+    {
+        {
+            std::unique_lock<std::mutex> lock(loader->mutex);
+            loader->decodeQueue.insert(loader->decodeQueue.end(), jobs, jobs + count);
+        }
+
+        loader->decodeCondition.notify_all();
+    }
+
+    // Begins a batch of loads in one submission & reads them in runs that fit the memory budget.
+    static void RunUringIOThread(PKAssetBatchLoader* loader, PKAssetUring* ring)
+    {
+        PKAssetLoadJob* jobs[PK_ASSET_URING_BATCH_SIZE];
+        const char* filepaths[PK_ASSET_URING_BATCH_SIZE];
+        PKAssetLoad* loads[PK_ASSET_URING_BATCH_SIZE];
+        int results[PK_ASSET_URING_BATCH_SIZE];
+
+        for (;;)
+        {
+            auto count = 0u;
+
+            {
+                std::unique_lock<std::mutex> lock(loader->mutex);
+                loader->ioCondition.wait(lock, [loader]() { return loader->isStopping || !loader->ioQueue.empty(); });
+
+                if (loader->ioQueue.empty())
+                {
+                    return;
+                }
+
+                for (; count < PK_ASSET_URING_BATCH_SIZE && !loader->ioQueue.empty(); ++count)
+                {
+                    jobs[count] = loader->ioQueue.front();
+                    loader->ioQueue.pop_front();
+                }
+            }
+
+            for (auto i = 0u; i < count; ++i)
+            {
+                filepaths[i] = jobs[i]->filepath.c_str();
+                loads[i] = &jobs[i]->load;
+            }
+
+            BeginAssetLoadsUring(ring, filepaths, loads, results, count);
+
+            for (auto i = 0u; i < count; ++i)
+            {
+                jobs[i]->load.memorySize = results[i] == 0 ? jobs[i]->load.memorySize : 0ull;
+            }
+
+            for (auto first = 0u; first < count;)
+            {
+                auto runCount = 0u;
+
+                // Waits for the first load of a run only. Further loads join the run while they fit so that a run never holds memory that an earlier load waits for.
+                {
+                    std::unique_lock<std::mutex> lock(loader->mutex);
+                    auto job = jobs[first];
+                    loader->memoryCondition.wait(lock, [loader, job]()
+                    {
+                        return loader->memoryBudget == 0ull || loader->memoryInFlight == 0ull || loader->memoryInFlight + job->load.memorySize <= loader->memoryBudget;
+                    });
+
+                    do
+                    {
+                        loader->memoryInFlight += jobs[first + runCount++]->load.memorySize;
+                    }
+                    while (first + runCount < count && (loader->memoryBudget == 0ull || loader->memoryInFlight + jobs[first + runCount]->load.memorySize <= loader->memoryBudget));
+                }
+
+                ReadAssetLoadsUring(ring, loads, results, first, runCount);
+
+                for (auto i = first; i < first + runCount; ++i)
+                {
+                    jobs[i]->result = results[i];
+                }
+
+                PushDecodeJobs(loader, jobs + first, runCount);
+                first += runCount;
+            }
+        }
+    }
+
+    static void RunIOThread(PKAssetBatchLoader* loader)
+    {
+        if ((loader->flags & PK_ASSET_BATCH_LOADER_FLAG_IO_URING) != 0u)
+        {
+            auto ring = CreateAssetUring();
+
+            if (ring != nullptr)
+            {
+                RunUringIOThread(loader, ring);
+                DestroyAssetUring(ring);
+                return;
+            }
+        }
+
+        for (;;)
+        {
+            PKAssetLoadJob* job = nullptr;
+
+            {
+                std::unique_lock<std::mutex> lock(loader->mutex);
+                loader->ioCondition.wait(lock, [loader]() { return loader->isStopping || !loader->ioQueue.empty(); });
+
+                if (loader->ioQueue.empty())
+                {
+                    return;
+                }
+
+                job = loader->ioQueue.front();
+                loader->ioQueue.pop_front();
+            }
+
+            job->result = BeginAssetLoad(job->filepath.c_str(), &job->load);
+            job->load.memorySize = job->result == 0 ? job->load.memorySize : 0ull;
+
+            // Reads wait for decodes to release memory. Nothing in flight always admits the next load so that oversized assets can't stall the queue.
+            {
+                std::unique_lock<std::mutex> lock(loader->mutex);
+                loader->memoryCondition.wait(lock, [loader, job]()
+                {
+                    return loader->memoryBudget == 0ull || loader->memoryInFlight == 0ull || loader->memoryInFlight + job->load.memorySize <= loader->memoryBudget;
+                });
+
+                loader->memoryInFlight += job->load.memorySize;
+            }
+
+            job->result = job->result == 0 ? ReadAssetLoad(&job->load) : job->result;
+            PushDecodeJobs(loader, &job, 1u);
+        }
+    }
+
+    static void RunDecodeThread(PKAssetBatchLoader* loader)
+    {
+        for (;;)
+        {
+            PKAssetLoadJob* job = nullptr;
+
+            {
+                std::unique_lock<std::mutex> lock(loader->mutex);
+                loader->decodeCondition.wait(lock, [loader]() { return loader->isStopping || !loader->decodeQueue.empty(); });
+
+                if (loader->decodeQueue.empty())
+                {
+                    return;
+                }
+
+                job = loader->decodeQueue.front();
+                loader->decodeQueue.pop_front();
+            }
+
+            // Each asset is decoded on a single thread. The pool decodes separate assets in parallel.
+            PKAsset asset{};
+            job->result = job->result == 0 ? DecodeAssetLoad(&job->load, &asset, 1u) : job->result;
+            job->complete(job->result == 0 ? &asset : nullptr, job->result);
+
+            {
+                std::unique_lock<std::mutex> lock(loader->mutex);
+                loader->memoryInFlight -= job->load.memorySize;
+                loader->pendingCount--;
+            }
+
+            delete job;
+            loader->memoryCondition.notify_all();
+            loader->idleCondition.notify_all();
+        }
+    }
+
+    static void SubmitJobs(PKAssetBatchLoader* loader, std::vector<PKAssetLoadJob*>& jobs)
+    {
+        {
+            std::unique_lock<std::mutex> lock(loader->mutex);
+            for (auto job : jobs)
+            {
+                job->load.allocator = loader->allocator;
+            }
+
+            loader->ioQueue.insert(loader->ioQueue.end(), jobs.begin(), jobs.end());
+            loader->pendingCount += jobs.size();
+        }
+
+        loader->ioCondition.notify_all();
+    }
+
+    PKAssetBatchLoader* CreateAssetBatchLoader(uint32_t ioThreadCount, uint32_t decodeThreadCount, size_t memoryBudget, uint32_t flags, const PKAssetAllocator* allocator)
+    {
+        ioThreadCount = ioThreadCount == 0u ? 1u : ioThreadCount;
+        decodeThreadCount = decodeThreadCount == 0u ? std::thread::hardware_concurrency() : decodeThreadCount;
+        decodeThreadCount = decodeThreadCount == 0u ? 1u : decodeThreadCount;
+
+        auto loader = new PKAssetBatchLoader();
+        loader->memoryBudget = memoryBudget;
+        loader->flags = flags;
+        loader->allocator = allocator;
+
+        for (auto i = 0u; i < ioThreadCount; ++i)
+        {
+            loader->threads.emplace_back(RunIOThread, loader);
+        }
+
+        for (auto i = 0u; i < decodeThreadCount; ++i)
+        {
+            loader->threads.emplace_back(RunDecodeThread, loader);
+        }
+
+        return loader;
+    }
+
+    void DestroyAssetBatchLoader(PKAssetBatchLoader* loader)
+    {
+        if (loader == nullptr)
+        {
+            return;
+        }
+
+        WaitAssetBatchLoader(loader);
+
+        {
+            std::unique_lock<std::mutex> lock(loader->mutex);
+            loader->isStopping = true;
+        }
+
+        loader->ioCondition.notify_all();
+        loader->decodeCondition.notify_all();
+
+        for (auto& thread : loader->threads)
+        {
+            thread.join();
+        }
+
+        delete loader;
+    }
+
+    int LoadAssetsAsync(PKAssetBatchLoader* loader, const char* const* filepaths, uint32_t count, PKAssetLoadCallback callback, void* userData)
+    {
+        if (loader == nullptr || filepaths == nullptr || callback == nullptr)
+        {
+            return -1;
+        }
+
+        std::vector<PKAssetLoadJob*> jobs;
+        jobs.reserve(count);
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            auto job = new PKAssetLoadJob();
+            job->filepath = filepaths[i] != nullptr ? filepaths[i] : "";
+            job->complete = [callback, userData, i, job](PKAsset* asset, int result) { callback(userData, i, job->filepath.c_str(), asset, result); };
+            jobs.push_back(job);
+        }
+
+        SubmitJobs(loader, jobs);
+        return 0;
+    }
+
+    std::future<PKAssetLoadResult> LoadAssetAsync(PKAssetBatchLoader* loader, const char* filepath)
+    {
+        auto promise = std::make_shared<std::promise<PKAssetLoadResult>>();
+        auto future = promise->get_future();
+
+        if (loader == nullptr || filepath == nullptr)
+        {
+            promise->set_value(PKAssetLoadResult());
+            return future;
+        }
+
+        std::vector<PKAssetLoadJob*> jobs = { new PKAssetLoadJob() };
+        jobs[0]->filepath = filepath;
+        jobs[0]->complete = [promise](PKAsset* asset, int result)
+        {
+            PKAssetLoadResult value;
+            value.asset = asset != nullptr ? *asset : PKAsset();
+            value.result = result;
+            promise->set_value(value);
+        };
+
+        SubmitJobs(loader, jobs);
+        return future;
+    }
+
+    void WaitAssetBatchLoader(PKAssetBatchLoader* loader)
+    {
+        std::unique_lock<std::mutex> lock(loader->mutex);
+        loader->idleCondition.wait(lock, [loader]() { return loader->pendingCount == 0ull; });
+    }
+}
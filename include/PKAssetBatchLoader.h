@@ -0,0 +1,34 @@
+#pragma once
+#include <future>
+#include "PKAssetLoader.h"
+
+namespace PKAssets
+{
+    // I/O threads batch opens, stats & reads through io_uring when available & fall back to stdio otherwise.
+    constexpr static const uint32_t PK_ASSET_BATCH_LOADER_FLAG_IO_URING = 1u << 0u;
+
+    struct PKAssetBatchLoader;
+
+    struct PKAssetLoadResult
+    {
+        PKAsset asset;
+        int result = -1;
+    };
+
+    // Invoked on a decode thread once an asset has been loaded. The asset is owned by the callback & released with CloseAsset.
+    typedef void (*PKAssetLoadCallback)(void* userData, uint32_t index, const char* filepath, PKAsset* asset, int result);
+
+    // Asynchronous batch loading. Files are read on a queue of I/O threads & decoded on a pool of decode threads, so reading one file overlaps decoding the previous ones.
+    // The memory budget bounds the encoded & decoded bytes of loads that have been read but not yet handed over. A single load larger than the budget still runs on its own.
+    // Zero decode threads selects one per hardware thread. A zero budget disables the limit.
+    // Assets are allocated from the allocator when one is given. It is called from I/O & decode threads concurrently & must outlive the loaded assets.
+    PKAssetBatchLoader* CreateAssetBatchLoader(uint32_t ioThreadCount, uint32_t decodeThreadCount, size_t memoryBudget, uint32_t flags = 0u, const PKAssetAllocator* allocator = nullptr);
+    void DestroyAssetBatchLoader(PKAssetBatchLoader* loader);
+
+    // File paths are copied on submission. Results are reported through the callback in completion order with the index of their path.
+    int LoadAssetsAsync(PKAssetBatchLoader* loader, const char* const* filepaths, uint32_t count, PKAssetLoadCallback callback, void* userData);
+    std::future<PKAssetLoadResult> LoadAssetAsync(PKAssetBatchLoader* loader, const char* filepath);
+
+    // Blocks until all submitted loads have completed.
+    void WaitAssetBatchLoader(PKAssetBatchLoader* loader);
+}
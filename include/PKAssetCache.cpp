@@ -0,0 +1,300 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "PKAssetCache.h"
+
+namespace PKAssets
+{
+    struct PKAssetCacheEntry
+    {
+        std::string filepath;
+        PKAsset asset;
+        size_t size = 0ull;
+        std::atomic<uint32_t> referenceCount{ 0u };
+        uint32_t shardIndex = 0u;
+        bool isLoading = true;
+        bool isLoaded = false;
+        // Unreferenced entries are linked into the eviction list, most recently released first.
+        bool isUnreferenced = false;
+        PKAssetCacheEntry* previous = nullptr;
+        PKAssetCacheEntry* next = nullptr;
+    };
+
+    struct PKAssetCacheShard
+    {
+        std::mutex mutex;
+        std::condition_variable loadCondition;
+        std::unordered_map<std::string, PKAssetCacheEntry*> entries;
+    };
+
+    // Shards are locked before the list. The list is only locked when an entry is loaded, evicted or gains its first or loses its last reference.
+    struct PKAssetCache
+    {
+        PKAssetCacheShard shards[PK_ASSET_CACHE_SHARD_COUNT];
+        std::mutex listMutex;
+        PKAssetCacheEntry* head = nullptr;
+        PKAssetCacheEntry* tail = nullptr;
+        const PKAssetAllocator* allocator = nullptr;
+        size_t memoryBudget = 0ull;
+        size_t residentSize = 0ull;
+        size_t unreferencedSize = 0ull;
+        uint32_t residentCount = 0u;
+        std::atomic<uint64_t> hitCount{ 0ull };
+        std::atomic<uint64_t> missCount{ 0ull };
+        std::atomic<uint64_t> evictCount{ 0ull };
+    };
+
+    static void LinkEntry(PKAssetCache* cache, PKAssetCacheEntry* entry)
+    {
+        entry->previous = nullptr;
+        entry->next = cache->head;
+        entry->isUnreferenced = true;
+        (cache->head != nullptr ? cache->head->previous : cache->tail) = entry;
+        cache->head = entry;
+        cache->unreferencedSize += entry->size;
+    }
+
+    static void UnlinkEntry(PKAssetCache* cache, PKAssetCacheEntry* entry)
+    {
+        (entry->previous != nullptr ? entry->previous->next : cache->head) = entry->next;
+        (entry->next != nullptr ? entry->next->previous : cache->tail) = entry->previous;
+        entry->previous = nullptr;
+        entry->next = nullptr;
+        entry->isUnreferenced = false;
+        cache->unreferencedSize -= entry->size;
+    }
+
+    static void DeleteEntry(PKAssetCacheEntry* entry)
+    {
+        CloseAsset(&entry->asset);
+        delete entry;
+    }
+
+    // Evicts the least recently released entries until the resident size fits the budget.
+    static void EvictAssets(PKAssetCache* cache)
+    {
+        for (;;)
+        {
+            std::string filepath;
+            auto shardIndex = 0u;
+
+            {
+                std::unique_lock<std::mutex> lock(cache->listMutex);
+
+                if (cache->tail == nullptr || cache->residentSize <= cache->memoryBudget)
+                {
+                    return;
+                }
+
+                filepath = cache->tail->filepath;
+                shardIndex = cache->tail->shardIndex;
+            }
+
+            // The entry can be acquired or evicted by another thread before its shard is locked, so it is looked up again.
+            PKAssetCacheEntry* victim = nullptr;
+
+            {
+                auto& shard = cache->shards[shardIndex];
+                std::unique_lock<std::mutex> shardLock(shard.mutex);
+                auto iter = shard.entries.find(filepath);
+                std::unique_lock<std::mutex> lock(cache->listMutex);
+
+                if (iter != shard.entries.end() && iter->second->isUnreferenced && cache->residentSize > cache->memoryBudget)
+                {
+                    victim = iter->second;
+                    UnlinkEntry(cache, victim);
+                    shard.entries.erase(iter);
+                    cache->residentSize -= victim->size;
+                    cache->residentCount--;
+                }
+            }
+
+            if (victim != nullptr)
+            {
+                cache->evictCount++;
+                DeleteEntry(victim);
+            }
+        }
+    }
+
+    PKAssetCache* CreateAssetCache(size_t memoryBudget, const PKAssetAllocator* allocator)
+    {
+        auto cache = new PKAssetCache();
+        cache->memoryBudget = memoryBudget;
+        cache->allocator = allocator;
+        return cache;
+    }
+
+    void DestroyAssetCache(PKAssetCache* cache)
+    {
+        if (cache == nullptr)
+        {
+            return;
+        }
+
+        for (auto& shard : cache->shards)
+        {
+            for (auto& iter : shard.entries)
+            {
+                DeleteEntry(iter.second);
+            }
+        }
+
+        delete cache;
+    }
+
+    PKAssetCacheEntry* AcquireAsset(PKAssetCache* cache, const char* filepath)
+    {
+        if (cache == nullptr || filepath == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto shardIndex = (uint32_t)(GetAssetNameHash(filepath) % PK_ASSET_CACHE_SHARD_COUNT);
+        auto& shard = cache->shards[shardIndex];
+        PKAssetCacheEntry* entry = nullptr;
+
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            auto iter = shard.entries.find(filepath);
+
+            if (iter != shard.entries.end())
+            {
+                entry = iter->second;
+
+                if (entry->referenceCount++ == 0u)
+                {
+                    std::unique_lock<std::mutex> listLock(cache->listMutex);
+                    UnlinkEntry(cache, entry);
+                }
+
+                shard.loadCondition.wait(lock, [entry]() { return !entry->isLoading; });
+
+                if (entry->isLoaded)
+                {
+                    cache->hitCount++;
+                    return entry;
+                }
+
+                // Failed loads are removed from the shard by the loading thread. The last waiter deletes the entry.
+                if (--entry->referenceCount == 0u)
+                {
+                    delete entry;
+                }
+
+                return nullptr;
+            }
+
+            entry = new PKAssetCacheEntry();
+            entry->filepath = filepath;
+            entry->shardIndex = shardIndex;
+            entry->referenceCount = 1u;
+            shard.entries.emplace(entry->filepath, entry);
+            cache->missCount++;
+        }
+
+        // Loads run without locks. Other acquires of the same path wait on the shard.
+        auto result = OpenAsset(filepath, &entry->asset, cache->allocator);
+
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            entry->isLoading = false;
+            entry->isLoaded = result == 0;
+
+            if (result == 0)
+            {
+                std::unique_lock<std::mutex> listLock(cache->listMutex);
+                entry->size = entry->asset.header->uncompressedSize;
+                cache->residentSize += entry->size;
+                cache->residentCount++;
+            }
+            else
+            {
+                shard.entries.erase(entry->filepath);
+            }
+        }
+
+        shard.loadCondition.notify_all();
+
+        if (result != 0)
+        {
+            if (--entry->referenceCount == 0u)
+            {
+                delete entry;
+            }
+
+            return nullptr;
+        }
+
+        EvictAssets(cache);
+        return entry;
+    }
+
+    void RetainAsset(PKAssetCacheEntry* entry)
+    {
+        entry->referenceCount++;
+    }
+
+    void ReleaseAsset(PKAssetCache* cache, PKAssetCacheEntry* entry)
+    {
+        if (cache == nullptr || entry == nullptr)
+        {
+            return;
+        }
+
+        // Releases that don't drop the last reference don't lock.
+        auto count = entry->referenceCount.load();
+        while (count > 1u && !entry->referenceCount.compare_exchange_weak(count, count - 1u)) {}
+
+        if (count > 1u)
+        {
+            return;
+        }
+
+        {
+            auto& shard = cache->shards[entry->shardIndex];
+            std::unique_lock<std::mutex> lock(shard.mutex);
+
+            // The entry can be acquired again before the shard is locked.
+            if (--entry->referenceCount != 0u)
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> listLock(cache->listMutex);
+            LinkEntry(cache, entry);
+        }
+
+        EvictAssets(cache);
+    }
+
+    const PKAsset* GetCachedAsset(const PKAssetCacheEntry* entry)
+    {
+        return entry != nullptr ? &entry->asset : nullptr;
+    }
+
+    void SetAssetCacheBudget(PKAssetCache* cache, size_t memoryBudget)
+    {
+        {
+            std::unique_lock<std::mutex> lock(cache->listMutex);
+            cache->memoryBudget = memoryBudget;
+        }
+
+        EvictAssets(cache);
+    }
+
+    PKAssetCacheStats GetAssetCacheStats(PKAssetCache* cache)
+    {
+        PKAssetCacheStats stats;
+        std::unique_lock<std::mutex> lock(cache->listMutex);
+        stats.hitCount = cache->hitCount;
+        stats.missCount = cache->missCount;
+        stats.evictCount = cache->evictCount;
+        stats.residentSize = cache->residentSize;
+        stats.unreferencedSize = cache->unreferencedSize;
+        stats.residentCount = cache->residentCount;
+        return stats;
+    }
+}
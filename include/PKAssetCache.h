@@ -0,0 +1,40 @@
+#pragma once
+#include "PKAssetLoader.h"
+
+namespace PKAssets
+{
+    // Paths are spread over shards by hash. Lookups only lock the shard of their path.
+    constexpr static const uint32_t PK_ASSET_CACHE_SHARD_COUNT = 16u;
+
+    struct PKAssetCache;
+    struct PKAssetCacheEntry;
+
+    struct PKAssetCacheStats
+    {
+        uint64_t hitCount = 0ull;
+        uint64_t missCount = 0ull;
+        uint64_t evictCount = 0ull;
+        size_t residentSize = 0ull;
+        size_t unreferencedSize = 0ull;
+        uint32_t residentCount = 0u;
+    };
+
+    // Decoded assets shared by path. Acquiring a path that is resident or being loaded returns the same refcounted entry, so each file is loaded once.
+    // Entries without references stay resident & are evicted in least recently released order once the decoded bytes exceed the budget.
+    // Referenced entries are never evicted, the budget can be exceeded while they are held. A zero budget evicts entries as soon as they are released.
+    // Assets are allocated from the allocator when one is given. The cache can be used from any number of threads.
+    PKAssetCache* CreateAssetCache(size_t memoryBudget, const PKAssetAllocator* allocator = nullptr);
+    // All entries must have been released.
+    void DestroyAssetCache(PKAssetCache* cache);
+
+    // Returns a referenced entry or nullptr when the asset fails to load. Concurrent acquires of a path that is being loaded wait for that load.
+    PKAssetCacheEntry* AcquireAsset(PKAssetCache* cache, const char* filepath);
+    // Adds a reference to an entry that is already held.
+    void RetainAsset(PKAssetCacheEntry* entry);
+    void ReleaseAsset(PKAssetCache* cache, PKAssetCacheEntry* entry);
+    // The asset is valid until the last reference to its entry is released. It must not be closed by the caller.
+    const PKAsset* GetCachedAsset(const PKAssetCacheEntry* entry);
+
+    void SetAssetCacheBudget(PKAssetCache* cache, size_t memoryBudget);
+    PKAssetCacheStats GetAssetCacheStats(PKAssetCache* cache);
+}
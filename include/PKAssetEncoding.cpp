@@ -1,6 +1,9 @@
 #include <malloc.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 #include "PKAssetEncoding.h"
 
 namespace PKAssets
@@ -65,15 +68,223 @@ namespace PKAssets
         }
     }
     
-    void EncodeBuffer(const void* in_data, size_t in_data_size, PKEncodeTable* table, uint8_t* out_data)
+    static void BuildDecodeTable(const uint8_t* in_data, uint16_t* out_table)
+    {
+        uint8_t lengths[PK_ASSET_ENCODE_CODE_COUNT]{};
+        uint16_t codes[PK_ASSET_ENCODE_CODE_COUNT]{};
+
+        for (auto i = 0u; i < PK_ASSET_ENCODE_TABLE_SIZE; ++i)
+        {
+            lengths[i * 2u + 0u] = in_data[i] & 0xFu;
+            lengths[i * 2u + 1u] = in_data[i] >> 4u;
+        }
+
+        GenerateCodes(codes, lengths);
+
+        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+        {
+            if (lengths[i] > 0)
+            {
+                auto step = 1u << lengths[i];
+                auto key = (uint16_t)(i | lengths[i] << 8u);
+
+                for (auto j = codes[i]; j < (1u << PK_ASSET_ENCODE_CODE_LENGTH); j += step)
+                {
+                    out_table[j] = key;
+                }
+            }
+        }
+    }
+
+    // Single stream refills keep up to 7 bytes buffered ahead of the consumed bits. Zero bytes are appended so that refills read at most 8 bytes past the encoded data.
+    constexpr static const size_t ENCODE_STREAM_TAIL_SIZE = 7ull;
+
+    // Packs up to two symbols per entry: symbol0 | symbol1 << 8 | total length << 16 | symbol count << 24.
+    // A second symbol is only resolved when both codes fit into the lookup bits.
+    static void BuildDecodePairTable(const uint16_t* table, uint32_t* out_table)
+    {
+        for (auto i = 0u; i < (1u << PK_ASSET_ENCODE_CODE_LENGTH); ++i)
+        {
+            const auto first = table[i];
+            const auto first_length = (uint32_t)(first >> 8u);
+            const auto second = table[i >> first_length];
+            const auto second_length = (uint32_t)(second >> 8u);
+
+            if (first_length + second_length <= PK_ASSET_ENCODE_CODE_LENGTH)
+            {
+                out_table[i] = (first & 0xFFu) | (second & 0xFFu) << 8u | (first_length + second_length) << 16u | 2u << 24u;
+            }
+            else
+            {
+                out_table[i] = (first & 0xFFu) | first_length << 16u | 1u << 24u;
+            }
+        }
+    }
+
+    // Interleaved streams share one input pointer. Only the bytes that fit into the bit buffer are consumed, the rest belong to the following streams.
+    static inline void RefillInterleaved(const uint8_t*& stream_bytes, uint64_t& bitbuffer, uint32_t& bitcount)
+    {
+        const auto advance = (63u - bitcount) >> 3u;
+        bitbuffer |= (*(const uint64_t*)stream_bytes & ((1ull << (advance << 3u)) - 1ull)) << bitcount;
+        stream_bytes += advance;
+        bitcount += advance << 3u;
+    }
+
+    // Replays the decoder refills so that stream bytes are written in the order they are consumed.
+    // Word i of each group of stream_count words is assigned to stream i. Trailing bytes are assigned to the first stream.
+    // Returns the encoded size (excluding the code table) & the furthest a decoded write gets ahead of the consumed input.
+    static size_t WriteInterleavedStreams(const uint8_t* bytes, size_t in_data_size, const PKEncodeTable* table, uint32_t stream_count, uint8_t* out_data, int64_t* out_max_lead)
+    {
+        const auto group_size = 4ull * stream_count;
+        const auto group_end = (in_data_size / group_size) * group_size;
+
+        uint8_t* stream_data[PK_ASSET_ENCODE_MAX_STREAM_COUNT]{};
+        size_t stream_sizes[PK_ASSET_ENCODE_MAX_STREAM_COUNT]{};
+        size_t stream_cursors[PK_ASSET_ENCODE_MAX_STREAM_COUNT]{};
+        uint32_t bitcounts[PK_ASSET_ENCODE_MAX_STREAM_COUNT]{};
+
+        if (out_data)
+        {
+            uint64_t stream_bitbuffers[PK_ASSET_ENCODE_MAX_STREAM_COUNT]{};
+
+            for (auto i = 0ull; i < in_data_size; ++i)
+            {
+                stream_sizes[i < group_end ? (i >> 2ull) & (stream_count - 1u) : 0u] += table->lengths[bytes[i]];
+            }
+
+            for (auto i = 0u; i < stream_count; ++i)
+            {
+                stream_data[i] = static_cast<uint8_t*>(calloc((stream_sizes[i] + 7ull) / 8ull + 8ull, 1u));
+                stream_sizes[i] = 0ull;
+            }
+
+            for (auto i = 0ull; i < in_data_size; ++i)
+            {
+                const auto stream = i < group_end ? (i >> 2ull) & (stream_count - 1u) : 0u;
+                stream_bitbuffers[stream] |= (uint64_t)table->codes[bytes[i]] << bitcounts[stream];
+                bitcounts[stream] += table->lengths[bytes[i]];
+
+                while (bitcounts[stream] >= 8u)
+                {
+                    stream_data[stream][stream_sizes[stream]++] = stream_bitbuffers[stream] & 0xFFu;
+                    stream_bitbuffers[stream] >>= 8u;
+                    bitcounts[stream] -= 8u;
+                }
+            }
+
+            for (auto i = 0u; i < stream_count; ++i)
+            {
+                if (bitcounts[i])
+                {
+                    stream_data[i][stream_sizes[i]++] = stream_bitbuffers[i] & 0xFFu;
+                }
+
+                bitcounts[i] = 0u;
+            }
+        }
+
+        auto stream_bytecount = 0ull;
+        int64_t max_lead = 0;
+
+        for (auto i = 0ull; i < in_data_size;)
+        {
+            const auto stream = i < group_end ? (i >> 2ull) & (stream_count - 1u) : 0u;
+            const auto symbol_count = i < group_end ? 4ull : 1ull;
+            const auto advance = (63u - bitcounts[stream]) >> 3u;
+
+            for (auto j = 0u; out_data && j < advance; ++j)
+            {
+                const auto cursor = stream_cursors[stream] + j;
+                out_data[stream_bytecount + j] = cursor < stream_sizes[stream] ? stream_data[stream][cursor] : 0u;
+            }
+
+            stream_bytecount += advance;
+            stream_cursors[stream] += advance;
+            bitcounts[stream] += advance << 3u;
+
+            for (auto j = 0ull; j < symbol_count; ++j)
+            {
+                bitcounts[stream] -= table->lengths[bytes[i++]];
+            }
+
+            const auto lead = (int64_t)i - (int64_t)(stream_bytecount + PK_ASSET_ENCODE_TABLE_SIZE);
+            max_lead = lead > max_lead ? lead : max_lead;
+        }
+
+        for (auto i = 0u; i < stream_count; ++i)
+        {
+            free(stream_data[i]);
+        }
+
+        *out_max_lead = max_lead;
+        return stream_bytecount;
+    }
+
+    template<uint32_t stream_count>
+    static int DecodeInterleaved(const uint8_t* stream_bytes, const uint16_t* table, uint8_t* write_data, size_t write_size)
+    {
+        uint64_t bitbuffers[stream_count]{};
+        uint32_t bitcounts[stream_count]{};
+
+        auto buffer_uint32 = reinterpret_cast<uint32_t*>(write_data);
+        auto group_count = write_size / (4ull * stream_count);
+        auto byte_offset = group_count * 4ull * stream_count;
+
+        for (auto i = 0ull; i < group_count; ++i)
+        {
+            uint32_t upacked[stream_count]{};
+
+            for (auto j = 0u; j < stream_count; ++j)
+            {
+                RefillInterleaved(stream_bytes, bitbuffers[j], bitcounts[j]);
+            }
+
+            // Symbols are decoded breadth first so that the independent table lookups of each stream overlap.
+            for (auto k = 0u; k < 4u; ++k)
+            {
+                for (auto j = 0u; j < stream_count; ++j)
+                {
+                    const auto key = table[bitbuffers[j] & ((1ull << PK_ASSET_ENCODE_CODE_LENGTH) - 1ull)];
+                    upacked[j] |= (key & 0xFFu) << (8u * k);
+                    bitbuffers[j] >>= key >> 8u;
+                    bitcounts[j] -= key >> 8u;
+                }
+            }
+
+            #if PK_DEBUG // In case we are using inplace decoding. we want to make sure that the write buffer doesn't overrun the read buffer.
+            if (static_cast<void*>(buffer_uint32 + i * stream_count) >= static_cast<const void*>(stream_bytes))
+            {
+                return -1;
+            }
+            #endif
+
+            for (auto j = 0u; j < stream_count; ++j)
+            {
+                buffer_uint32[i * stream_count + j] = upacked[j];
+            }
+        }
+
+        for (auto i = byte_offset; i < write_size; ++i)
+        {
+            RefillInterleaved(stream_bytes, bitbuffers[0], bitcounts[0]);
+            const auto key = table[bitbuffers[0] & ((1ull << PK_ASSET_ENCODE_CODE_LENGTH) - 1ull)];
+            write_data[i] = (key & 0xFFu);
+            bitbuffers[0] >>= key >> 8u;
+            bitcounts[0] -= key >> 8u;
+        }
+
+        return 0;
+    }
+
+    void EncodeBuffer(const void* in_data, size_t in_data_size, PKEncodeTable* table, uint8_t* out_data, uint32_t stream_count)
     {
         const uint8_t* bytes = static_cast<const uint8_t*>(in_data);
     
         if (!out_data)
         {
-            memset(table, 0, sizeof(PKEncodeTable));
+            *table = PKEncodeTable();
             uint32_t frequencies[PK_ASSET_ENCODE_CODE_COUNT + 1u]{};
-            uint64_t sorted[PK_ASSET_ENCODE_CODE_COUNT]{};
+            uint64_t sorted[PK_ASSET_ENCODE_CODE_COUNT + 1u]{};
             EncodeNode nodes[PK_ASSET_ENCODE_CODE_COUNT * PK_ASSET_ENCODE_CODE_LENGTH * 2]{};
     
             auto sorted_count = 0u;
@@ -156,7 +367,8 @@ namespace PKAssets
                 table->size += table->lengths[bytes[i]];
             }
     
-            table->decodePadding = in_data_size * 8ull - table->size;
+            // Incompressible payloads can't be decoded in place & don't need padding.
+            table->decodePadding = in_data_size * 8ull > table->size ? in_data_size * 8ull - table->size : 0ull;
 
             for (auto i = 0ull; i < in_data_size && table->decodePadding > i * 8ull; ++i)
             {
@@ -167,6 +379,29 @@ namespace PKAssets
             table->size = (table->size + 7ull) / 8ull;
             table->decodePadding = (table->decodePadding + 7ull) / 8ull;
             table->decodePadding = in_data_size - table->decodePadding;
+            table->size += ENCODE_STREAM_TAIL_SIZE;
+            table->decodePadding += ENCODE_STREAM_TAIL_SIZE;
+            table->streamCount = 1u;
+
+            if (stream_count == 4u || stream_count == 8u)
+            {
+                // Compressed data is placed at the end of the decode buffer. Pad until decoded writes stay behind the consumed input.
+                int64_t max_lead = 0;
+                table->streamCount = stream_count;
+                table->size = PK_ASSET_ENCODE_TABLE_SIZE + WriteInterleavedStreams(bytes, in_data_size, table, stream_count, nullptr, &max_lead);
+                auto padding = max_lead - (int64_t)in_data_size + (int64_t)table->size;
+                table->decodePadding = padding > 0ll ? (size_t)padding : 0ull;
+            }
+        }
+        else if (table && table->streamCount > 1u)
+        {
+            for (auto i = 0u; i < PK_ASSET_ENCODE_TABLE_SIZE; ++i)
+            {
+                out_data[i] = (uint8_t)(table->lengths[i * 2u + 0u] | (table->lengths[i * 2u + 1u] << 4u));
+            }
+
+            int64_t max_lead = 0;
+            WriteInterleavedStreams(bytes, in_data_size, table, table->streamCount, out_data + PK_ASSET_ENCODE_TABLE_SIZE, &max_lead);
         }
         else if (table)
         {
@@ -208,13 +443,15 @@ namespace PKAssets
                     stream_bitcount -= 8u;
                 }
             }
+
+            memset(out_data + stream_bytecount, 0, ENCODE_STREAM_TAIL_SIZE);
         }
     }
     
-    int EncodeBuffer(const void* in_data, size_t in_data_size, uint8_t** out_data, size_t* out_data_size)
+    int EncodeBuffer(const void* in_data, size_t in_data_size, uint8_t** out_data, size_t* out_data_size, uint32_t stream_count)
     {
         PKEncodeTable table{};
-        EncodeBuffer(in_data, in_data_size, &table, nullptr);
+        EncodeBuffer(in_data, in_data_size, &table, nullptr, stream_count);
         auto compressed_buff = static_cast<uint8_t*>(malloc(table.size));
         EncodeBuffer(in_data, in_data_size, &table, compressed_buff);
         *out_data = compressed_buff;
@@ -222,86 +459,1167 @@ namespace PKAssets
         return compressed_buff == nullptr ? -1 : 0;
     }
     
-    int DecodeBuffer(const void* in_data, uint8_t* write_data, size_t write_size)
+    static int DecodeHuffman(const void* in_data, uint8_t* write_data, size_t write_size, uint32_t stream_count, bool use_pairs)
     {
-        constexpr uint32_t table_size = 1u << PK_ASSET_ENCODE_CODE_LENGTH;
-    
-        uint8_t lengths[PK_ASSET_ENCODE_CODE_COUNT]{};
-        uint16_t codes[PK_ASSET_ENCODE_CODE_COUNT]{};
-        uint16_t table[table_size]{};
-    
-        auto stream_bytes = static_cast<const uint8_t*>(in_data);
+        uint16_t table[1u << PK_ASSET_ENCODE_CODE_LENGTH]{};
+        BuildDecodeTable(static_cast<const uint8_t*>(in_data), table);
+
+        auto stream_bytes = static_cast<const uint8_t*>(in_data) + PK_ASSET_ENCODE_TABLE_SIZE;
+
+        switch (stream_count)
+        {
+            case 1u: break;
+            case 4u: return DecodeInterleaved<4u>(stream_bytes, table, write_data, write_size);
+            case 8u: return DecodeInterleaved<8u>(stream_bytes, table, write_data, write_size);
+            default: return -1;
+        }
+
+        uint32_t pair_table[1u << PK_ASSET_ENCODE_CODE_LENGTH];
+
+        if (use_pairs)
+        {
+            BuildDecodePairTable(table, pair_table);
+        }
+
+        const auto code_mask = (1ull << PK_ASSET_ENCODE_CODE_LENGTH) - 1ull;
+        const auto write_end = write_data + write_size;
+        const auto is_in_place = stream_bytes >= write_data && stream_bytes < write_end;
+        auto write_head = write_data;
         auto stream_bitbuffer = 0ull;
         auto stream_bitcount = 0u;
         auto stream_bytecount = 0u;
 
-        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+        // Four pair lookups resolve 4-8 symbols per refill. Each lookup stores two bytes & advances by its symbol count, so up to 9 bytes are touched.
+        while (write_head + 9u <= write_end)
         {
             stream_bitbuffer |= *(const uint64_t*)(stream_bytes + stream_bytecount) << stream_bitcount;
             stream_bytecount += (63u - stream_bitcount) >> 3u;
             stream_bitcount |= 56u;
-            lengths[i] = stream_bitbuffer & ((1ull << PK_ASSET_ENCODE_CODE_BIT_COUNT) - 1ull); 
-            stream_bitbuffer >>= PK_ASSET_ENCODE_CODE_BIT_COUNT;
-            stream_bitcount -= PK_ASSET_ENCODE_CODE_BIT_COUNT;
-        }
-    
-        GenerateCodes(codes, lengths);
-    
-        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
-        {
-            if (lengths[i] > 0)
-            {
-                auto step = 1u << lengths[i];
-                auto key = (uint16_t)(i | lengths[i] << 8u);
 
-                for (auto j = codes[i]; j < table_size; j += step)
+            // When decoding in place the speculative second byte could overwrite unread input. Fall back to single symbols until there is enough room.
+            if (!use_pairs || (is_in_place && write_head + 9u > stream_bytes + stream_bytecount))
+            {
+                for (auto j = 0u; j < 4u; ++j)
                 {
-                    table[j] = key;
+                    const auto key = table[stream_bitbuffer & code_mask];
+                    *write_head++ = (key & 0xFFu);
+                    stream_bitbuffer >>= key >> 8u;
+                    stream_bitcount -= key >> 8u;
                 }
+
+                continue;
+            }
+
+            for (auto j = 0u; j < 4u; ++j)
+            {
+                const auto key = pair_table[stream_bitbuffer & code_mask];
+                const auto length = (key >> 16u) & 0xFFu;
+                const auto symbols = (uint16_t)key;
+                memcpy(write_head, &symbols, sizeof(uint16_t));
+                write_head += key >> 24u;
+                stream_bitbuffer >>= length;
+                stream_bitcount -= length;
             }
         }
-    
-        auto buffer_uint32 = reinterpret_cast<uint32_t*>(write_data);
-        auto uint32_count = write_size / sizeof(uint32_t);
-        auto byte_offset = uint32_count * sizeof(uint32_t);
-    
-        for (auto i = 0u; i < uint32_count; ++i)
+
+        while (write_head < write_end)
         {
             stream_bitbuffer |= *(const uint64_t*)(stream_bytes + stream_bytecount) << stream_bitcount;
             stream_bytecount += (63u - stream_bitcount) >> 3u;
             stream_bitcount |= 56u;
-            uint32_t upacked = 0u;
-    
-            for (auto j = 0u; j < 4u; ++j)
-            {
-                const auto key = table[stream_bitbuffer & ((1ull << PK_ASSET_ENCODE_CODE_LENGTH) - 1ull)];
-                upacked |= (key & 0xFFu) << (8u * j);
-                stream_bitbuffer >>= key >> 8u;
-                stream_bitcount -= key >> 8u;
-            }
-    
+            const auto key = table[stream_bitbuffer & code_mask];
+
             #if PK_DEBUG // In case we are using inplace decoding. we want to make sure that the write buffer doesn't overrun the read buffer.
-            if (static_cast<void*>(buffer_uint32 + i) >= static_cast<const void*>(stream_bytes + stream_bytecount))
+            if (is_in_place && write_head >= stream_bytes + stream_bytecount)
             {
                 return -1;
             }
             #endif
 
-            buffer_uint32[i] = upacked;
-        }
-    
-        // If not aligned to 32 bits lets decode the remaining 1-3 bytes separately
-        for (auto i = byte_offset; i < write_size; ++i)
-        {
-            stream_bitbuffer |= *(const uint64_t*)(stream_bytes + stream_bytecount) << stream_bitcount;
-            stream_bytecount += (63u - stream_bitcount) >> 3u;
-            stream_bitcount |= 56u;
-            const auto key = table[stream_bitbuffer & ((1ull << PK_ASSET_ENCODE_CODE_LENGTH) - 1ull)];
-            write_data[i] = (key & 0xFFu);
+            *write_head++ = (key & 0xFFu);
             stream_bitbuffer >>= key >> 8u;
             stream_bitcount -= key >> 8u;
         }
 
         return 0;
     }
-}
\ No newline at end of file
+
+    int DecodeBuffer(const void* in_data, uint8_t* write_data, size_t write_size, uint32_t stream_count)
+    {
+        // Building the pair table costs about as much as decoding a few kilobytes. Small buffers only use the single symbol table.
+        return DecodeHuffman(in_data, write_data, write_size, stream_count, write_size >= PK_ASSET_DECODE_PAIR_MIN_SIZE);
+    }
+
+    int DecodeBufferSingleTable(const void* in_data, uint8_t* write_data, size_t write_size)
+    {
+        return DecodeHuffman(in_data, write_data, write_size, 1u, false);
+    }
+
+    double GetDecodePairRatio(const PKEncodeTable* table, const void* in_data, size_t in_data_size)
+    {
+        const auto bytes = static_cast<const uint8_t*>(in_data);
+        uint32_t histogram[PK_ASSET_ENCODE_CODE_COUNT]{};
+        double length_probs[PK_ASSET_ENCODE_CODE_LENGTH + 1u]{};
+        auto pair_prob = 0.0;
+
+        if (in_data_size == 0ull)
+        {
+            return 1.0;
+        }
+
+        for (auto i = 0ull; i < in_data_size; ++i)
+        {
+            histogram[bytes[i]]++;
+        }
+
+        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+        {
+            length_probs[table->lengths[i]] += (double)histogram[i] / in_data_size;
+        }
+
+        // A lookup resolves a second symbol when both codes fit into the lookup bits.
+        for (auto i = 1u; i < PK_ASSET_ENCODE_CODE_LENGTH; ++i)
+        {
+            for (auto j = 1u; i + j <= PK_ASSET_ENCODE_CODE_LENGTH; ++j)
+            {
+                pair_prob += length_probs[i] * length_probs[j];
+            }
+        }
+
+        return 1.0 + pair_prob;
+    }
+
+    int BeginDecodeStream(PKDecodeStream* stream, size_t encoded_size, size_t write_size, uint32_t stream_count)
+    {
+        if (stream_count != 1u && stream_count != 4u && stream_count != 8u)
+        {
+            return -1;
+        }
+
+        memset(stream, 0, sizeof(PKDecodeStream));
+        stream->encodedSize = encoded_size;
+        stream->writeSize = write_size;
+        stream->streamCount = stream_count;
+        return 0;
+    }
+
+    size_t FeedDecodeStream(PKDecodeStream* stream, const void* in_data, size_t in_data_size)
+    {
+        // Consumed input is discarded. Refills read past the staged input, the slack behind it is kept zeroed.
+        auto remaining = stream->inputSize > stream->inputHead ? stream->inputSize - stream->inputHead : 0ull;
+        memmove(stream->input, stream->input + stream->inputHead, remaining);
+        stream->inputHead = 0ull;
+        stream->inputSize = remaining;
+
+        auto capacity = PK_ASSET_DECODE_STREAM_INPUT_SIZE - stream->inputSize;
+        auto count = in_data_size < capacity ? in_data_size : capacity;
+        count = count < stream->encodedSize - stream->readSize ? count : stream->encodedSize - stream->readSize;
+        memcpy(stream->input + stream->inputSize, in_data, count);
+        stream->inputSize += count;
+        stream->readSize += count;
+        memset(stream->input + stream->inputSize, 0, sizeof(stream->input) - stream->inputSize);
+        return count;
+    }
+
+    size_t DecodeStream(PKDecodeStream* stream, uint8_t* write_data, size_t write_size)
+    {
+        const auto stream_count = stream->streamCount;
+        const auto group_size = 4ull * stream_count;
+        const auto group_end = (stream->writeSize / group_size) * group_size;
+        const auto code_mask = (1ull << PK_ASSET_ENCODE_CODE_LENGTH) - 1ull;
+        const auto is_final = stream->readSize == stream->encodedSize;
+        auto written = 0ull;
+
+        while (written < write_size)
+        {
+            if (stream->pendingHead < stream->pendingSize)
+            {
+                auto count = stream->pendingSize - stream->pendingHead;
+                count = count < write_size - written ? count : (uint32_t)(write_size - written);
+                memcpy(write_data + written, stream->pending + stream->pendingHead, count);
+                stream->pendingHead += count;
+                written += count;
+                continue;
+            }
+
+            if (stream->decodeOffset >= stream->writeSize)
+            {
+                break;
+            }
+
+            // A group refills each stream once. Unless all input has been fed, stage enough for the largest possible refills.
+            auto available = stream->inputSize > stream->inputHead ? stream->inputSize - stream->inputHead : 0ull;
+
+            if (!stream->hasTable)
+            {
+                if (available < PK_ASSET_ENCODE_TABLE_SIZE && !is_final)
+                {
+                    break;
+                }
+
+                BuildDecodeTable(stream->input + stream->inputHead, stream->table);
+                stream->inputHead += PK_ASSET_ENCODE_TABLE_SIZE;
+                stream->hasTable = true;
+                continue;
+            }
+
+            if (available < 8ull * stream_count && !is_final)
+            {
+                break;
+            }
+
+            // Replays the refill order of DecodeBuffer. Groups of interleaved words first, then single symbols from the first stream.
+            auto stream_bytes = static_cast<const uint8_t*>(stream->input + stream->inputHead);
+            auto is_group = stream->decodeOffset < group_end;
+            auto count = is_group ? (uint32_t)group_size : 1u;
+            auto output = write_size - written >= count ? write_data + written : stream->pending;
+
+            for (auto j = 0u; j < (is_group ? stream_count : 1u); ++j)
+            {
+                RefillInterleaved(stream_bytes, stream->bitbuffers[j], stream->bitcounts[j]);
+            }
+
+            for (auto k = 0u; k < (is_group ? 4u : 1u); ++k)
+            {
+                for (auto j = 0u; j < (is_group ? stream_count : 1u); ++j)
+                {
+                    const auto key = stream->table[stream->bitbuffers[j] & code_mask];
+                    output[j * 4u + k] = (key & 0xFFu);
+                    stream->bitbuffers[j] >>= key >> 8u;
+                    stream->bitcounts[j] -= key >> 8u;
+                }
+            }
+
+            stream->inputHead = stream_bytes - stream->input;
+            stream->decodeOffset += count;
+
+            if (output == stream->pending)
+            {
+                stream->pendingHead = 0u;
+                stream->pendingSize = count;
+            }
+            else
+            {
+                written += count;
+            }
+        }
+
+        stream->writeOffset += written;
+        return written;
+    }
+
+    constexpr static const uint32_t MATCH_HASH_BITS = 16u;
+    constexpr static const uint32_t MATCH_SEARCH_DEPTH = 16u;
+    constexpr static const uint32_t MATCH_LAST_LITERALS = 8u;
+
+    static inline uint32_t Read32(const uint8_t* ptr) { uint32_t value; memcpy(&value, ptr, sizeof(uint32_t)); return value; }
+    static inline uint32_t HashMatch(uint32_t value) { return (value * 2654435761u) >> (32u - MATCH_HASH_BITS); }
+
+    static uint8_t* WriteMatchLength(uint8_t* out_data, size_t length)
+    {
+        for (; length >= 255ull; length -= 255ull)
+        {
+            *out_data++ = 255u;
+        }
+
+        *out_data++ = (uint8_t)length;
+        return out_data;
+    }
+
+    static uint8_t* WriteMatchSequence(uint8_t* out_data, const uint8_t* literals, size_t literal_count, size_t offset, size_t length)
+    {
+        auto token = out_data++;
+        *token = (uint8_t)((literal_count < 15ull ? literal_count : 15ull) << 4u);
+
+        if (literal_count >= 15ull)
+        {
+            out_data = WriteMatchLength(out_data, literal_count - 15ull);
+        }
+
+        if (literal_count > 0ull)
+        {
+            memcpy(out_data, literals, literal_count);
+            out_data += literal_count;
+        }
+
+        if (length > 0ull)
+        {
+            length -= PK_ASSET_ENCODE_MATCH_MIN_LENGTH;
+            *token |= (uint8_t)(length < 15ull ? length : 15ull);
+            *out_data++ = (uint8_t)(offset & 0xFFu);
+            *out_data++ = (uint8_t)(offset >> 8u);
+
+            if (length >= 15ull)
+            {
+                out_data = WriteMatchLength(out_data, length - 15ull);
+            }
+        }
+
+        return out_data;
+    }
+
+    size_t GetMatchBound(size_t size)
+    {
+        return size + size / 255ull + 16ull;
+    }
+
+    size_t EncodeMatches(const void* in_data, size_t in_data_size, uint8_t* out_data)
+    {
+        const auto bytes = static_cast<const uint8_t*>(in_data);
+        const auto out_start = out_data;
+
+        if (in_data_size <= MATCH_LAST_LITERALS + PK_ASSET_ENCODE_MATCH_MIN_LENGTH)
+        {
+            return WriteMatchSequence(out_data, bytes, in_data_size, 0ull, 0ull) - out_start;
+        }
+
+        // Hash heads & a chain of previous positions with the same hash over the match window. Positions are stored + 1.
+        auto heads = static_cast<uint32_t*>(calloc(1ull << MATCH_HASH_BITS, sizeof(uint32_t)));
+        auto chain = static_cast<uint32_t*>(calloc(PK_ASSET_ENCODE_MATCH_MAX_OFFSET + 1ull, sizeof(uint32_t)));
+
+        if (heads == nullptr || chain == nullptr)
+        {
+            free(heads);
+            free(chain);
+            return 0ull;
+        }
+
+        const auto match_limit = in_data_size - MATCH_LAST_LITERALS;
+        auto anchor = 0ull;
+        auto hashed = 0ull;
+
+        for (auto i = 0ull; i + PK_ASSET_ENCODE_MATCH_MIN_LENGTH <= match_limit;)
+        {
+            for (; hashed <= i; ++hashed)
+            {
+                const auto hash = HashMatch(Read32(bytes + hashed));
+                chain[hashed & PK_ASSET_ENCODE_MATCH_MAX_OFFSET] = heads[hash];
+                heads[hash] = (uint32_t)hashed + 1u;
+            }
+
+            auto best_length = 0ull;
+            auto best_offset = 0ull;
+            auto candidate = chain[i & PK_ASSET_ENCODE_MATCH_MAX_OFFSET];
+            const auto value = Read32(bytes + i);
+
+            for (auto depth = 0u; depth < MATCH_SEARCH_DEPTH && candidate != 0u && i - (candidate - 1u) <= PK_ASSET_ENCODE_MATCH_MAX_OFFSET; ++depth)
+            {
+                const auto position = candidate - 1ull;
+                candidate = chain[position & PK_ASSET_ENCODE_MATCH_MAX_OFFSET];
+
+                if (Read32(bytes + position) != value)
+                {
+                    continue;
+                }
+
+                auto length = PK_ASSET_ENCODE_MATCH_MIN_LENGTH;
+
+                while (i + length < match_limit && bytes[position + length] == bytes[i + length])
+                {
+                    ++length;
+                }
+
+                if (length > best_length)
+                {
+                    best_length = length;
+                    best_offset = i - position;
+                }
+            }
+
+            if (best_length == 0ull)
+            {
+                // Skip faster through data that doesn't match.
+                i += 1ull + ((i - anchor) >> 6ull);
+                continue;
+            }
+
+            out_data = WriteMatchSequence(out_data, bytes + anchor, i - anchor, best_offset, best_length);
+            i += best_length;
+            anchor = i;
+        }
+
+        out_data = WriteMatchSequence(out_data, bytes + anchor, in_data_size - anchor, 0ull, 0ull);
+        free(heads);
+        free(chain);
+        return out_data - out_start;
+    }
+
+    static inline bool ReadMatchLength(const uint8_t*& in_data, const uint8_t* in_end, size_t& length)
+    {
+        uint8_t value = 255u;
+
+        while (value == 255u)
+        {
+            if (in_data >= in_end)
+            {
+                return false;
+            }
+
+            value = *in_data++;
+            length += value;
+        }
+
+        return true;
+    }
+
+    int DecodeMatches(const void* in_data, size_t in_data_size, uint8_t* write_data, size_t write_size)
+    {
+        auto in_head = static_cast<const uint8_t*>(in_data);
+        const auto in_end = in_head + in_data_size;
+        auto out_head = write_data;
+        const auto out_end = write_data + write_size;
+
+        while (in_head < in_end)
+        {
+            const auto token = *in_head++;
+            size_t literal_count = token >> 4u;
+
+            if (literal_count == 15ull && !ReadMatchLength(in_head, in_end, literal_count))
+            {
+                return -1;
+            }
+
+            if (literal_count > (size_t)(in_end - in_head) || literal_count > (size_t)(out_end - out_head))
+            {
+                return -1;
+            }
+
+            // Copy in 8 byte steps while both buffers have room for the overshoot.
+            if (in_head + literal_count + 8u <= in_end && out_head + literal_count + 8u <= out_end)
+            {
+                for (auto i = 0ull; i < literal_count; i += 8ull)
+                {
+                    memcpy(out_head + i, in_head + i, 8u);
+                }
+            }
+            else
+            {
+                memcpy(out_head, in_head, literal_count);
+            }
+
+            in_head += literal_count;
+            out_head += literal_count;
+
+            if (in_head >= in_end)
+            {
+                break;
+            }
+
+            if (in_end - in_head < 2)
+            {
+                return -1;
+            }
+
+            const auto offset = (size_t)in_head[0] | ((size_t)in_head[1] << 8u);
+            size_t length = token & 0xFu;
+            in_head += 2;
+
+            if (length == 15ull && !ReadMatchLength(in_head, in_end, length))
+            {
+                return -1;
+            }
+
+            length += PK_ASSET_ENCODE_MATCH_MIN_LENGTH;
+
+            if (offset == 0ull || offset > (size_t)(out_head - write_data) || length > (size_t)(out_end - out_head))
+            {
+                return -1;
+            }
+
+            const auto match = out_head - offset;
+
+            if (offset >= 8ull && out_head + length + 8u <= out_end)
+            {
+                for (auto i = 0ull; i < length; i += 8ull)
+                {
+                    memcpy(out_head + i, match + i, 8u);
+                }
+            }
+            else
+            {
+                for (auto i = 0ull; i < length; ++i)
+                {
+                    out_head[i] = match[i];
+                }
+            }
+
+            out_head += length;
+        }
+
+        return out_head == out_end ? 0 : -1;
+    }
+
+    constexpr static const uint32_t RANS_PROB_BITS = 12u;
+    constexpr static const uint32_t RANS_PROB_SCALE = 1u << RANS_PROB_BITS;
+    constexpr static const uint32_t RANS_LOWER_BOUND = 1u << 16u;
+    constexpr static const uint8_t RANS_MODE_STATES = 0u;
+    constexpr static const uint8_t RANS_MODE_RUN = 1u;
+
+    // Scales the histogram to RANS_PROB_SCALE. Every present symbol keeps a frequency of at least one.
+    static void NormalizeRansFrequencies(const uint32_t* histogram, size_t total, uint32_t* out_freqs)
+    {
+        auto sum = 0u;
+        auto largest = 0u;
+
+        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+        {
+            out_freqs[i] = histogram[i] > 0u ? (uint32_t)(((uint64_t)histogram[i] * RANS_PROB_SCALE) / total) : 0u;
+            out_freqs[i] = histogram[i] > 0u && out_freqs[i] == 0u ? 1u : out_freqs[i];
+            largest = out_freqs[i] > out_freqs[largest] ? i : largest;
+            sum += out_freqs[i];
+        }
+
+        if (sum < RANS_PROB_SCALE)
+        {
+            out_freqs[largest] += RANS_PROB_SCALE - sum;
+        }
+
+        // Rounding up rare symbols can overshoot. Take the excess from the most frequent symbols.
+        while (sum > RANS_PROB_SCALE)
+        {
+            for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+            {
+                largest = out_freqs[i] > out_freqs[largest] ? i : largest;
+            }
+
+            auto excess = sum - RANS_PROB_SCALE;
+            auto amount = out_freqs[largest] / 2u < excess ? out_freqs[largest] / 2u : excess;
+            out_freqs[largest] -= amount;
+            sum -= amount;
+        }
+    }
+
+    size_t GetRansBound(size_t size, uint32_t stream_count)
+    {
+        return 2ull + 32ull + PK_ASSET_ENCODE_CODE_COUNT * 2ull + stream_count * sizeof(uint32_t) * 2ull + (size + 1ull) * sizeof(uint16_t);
+    }
+
+    size_t EncodeRans(const void* in_data, size_t in_data_size, uint32_t stream_count, uint8_t* out_data)
+    {
+        if (stream_count != 1u && stream_count != 4u && stream_count != 8u)
+        {
+            return 0ull;
+        }
+
+        const auto bytes = static_cast<const uint8_t*>(in_data);
+        uint32_t histogram[PK_ASSET_ENCODE_CODE_COUNT]{};
+        uint32_t freqs[PK_ASSET_ENCODE_CODE_COUNT]{};
+        uint32_t starts[PK_ASSET_ENCODE_CODE_COUNT]{};
+        auto symbol_count = 0u;
+
+        for (auto i = 0ull; i < in_data_size; ++i)
+        {
+            histogram[bytes[i]]++;
+        }
+
+        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+        {
+            symbol_count += histogram[i] > 0u ? 1u : 0u;
+        }
+
+        // Single symbol payloads can't be represented with a frequency below the probability scale.
+        if (symbol_count <= 1u)
+        {
+            out_data[0] = RANS_MODE_RUN;
+            out_data[1] = in_data_size > 0ull ? bytes[0] : 0u;
+            return 2ull;
+        }
+
+        NormalizeRansFrequencies(histogram, in_data_size, freqs);
+
+        // Frequency table: presence bitmap followed by the frequency of each present symbol in one or two bytes.
+        auto head = out_data;
+        *head++ = RANS_MODE_STATES;
+        memset(head, 0, 32u);
+
+        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+        {
+            head[i >> 3u] |= freqs[i] > 0u ? (uint8_t)(1u << (i & 7u)) : 0u;
+        }
+
+        head += 32u;
+
+        for (auto i = 0u, start = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; start += freqs[i++])
+        {
+            starts[i] = start;
+
+            if (freqs[i] >= 128u)
+            {
+                *head++ = (uint8_t)(0x80u | (freqs[i] >> 8u));
+                *head++ = (uint8_t)(freqs[i] & 0xFFu);
+            }
+            else if (freqs[i] > 0u)
+            {
+                *head++ = (uint8_t)freqs[i];
+            }
+        }
+
+        // Symbol i belongs to state i % stream_count. Each state writes its own word stream, in reverse so that the decoder reads words in ascending order.
+        // A state emits at most one word per symbol, so its region holds its symbol count plus the two words of its final state.
+        auto words = static_cast<uint16_t*>(malloc((in_data_size + stream_count * 2ull) * sizeof(uint16_t)));
+
+        if (words == nullptr)
+        {
+            return 0ull;
+        }
+
+        uint32_t states[PK_ASSET_ENCODE_MAX_STREAM_COUNT];
+        uint16_t* region_ends[PK_ASSET_ENCODE_MAX_STREAM_COUNT];
+        uint16_t* word_heads[PK_ASSET_ENCODE_MAX_STREAM_COUNT];
+        auto region_end = words;
+
+        for (auto i = 0u; i < stream_count; ++i)
+        {
+            region_end += (in_data_size + stream_count - 1ull - i) / stream_count + 2ull;
+            region_ends[i] = region_end;
+            word_heads[i] = region_end;
+            states[i] = RANS_LOWER_BOUND;
+        }
+
+        for (auto i = in_data_size; i-- > 0ull;)
+        {
+            const auto symbol = bytes[i];
+            const auto freq = freqs[symbol];
+            const auto lane = i & (stream_count - 1u);
+            auto& state = states[lane];
+
+            if (state >= (freq << (32u - RANS_PROB_BITS)))
+            {
+                *--word_heads[lane] = (uint16_t)(state & 0xFFFFu);
+                state >>= 16u;
+            }
+
+            state = ((state / freq) << RANS_PROB_BITS) + (state % freq) + starts[symbol];
+        }
+
+        // Stream table: uint32 word count of each stream. Streams follow in state order, each starting with its initial state.
+        auto stream_table = head;
+        head += stream_count * sizeof(uint32_t);
+
+        for (auto i = 0u; i < stream_count; ++i)
+        {
+            *--word_heads[i] = (uint16_t)(states[i] >> 16u);
+            *--word_heads[i] = (uint16_t)(states[i] & 0xFFFFu);
+
+            const auto word_count = (uint32_t)(region_ends[i] - word_heads[i]);
+            memcpy(stream_table + i * sizeof(uint32_t), &word_count, sizeof(uint32_t));
+            memcpy(head, word_heads[i], word_count * sizeof(uint16_t));
+            head += word_count * sizeof(uint16_t);
+        }
+
+        // Renormalization reads one word ahead of the last stream.
+        memset(head, 0, sizeof(uint16_t));
+        head += sizeof(uint16_t);
+        free(words);
+        return (size_t)(head - out_data);
+    }
+
+    template<uint32_t N>
+    static int DecodeRansStates(const uint32_t* table, const uint8_t* streams, size_t streams_size, uint8_t* write_data, size_t write_size)
+    {
+        const auto mask = RANS_PROB_SCALE - 1u;
+        const uint8_t* words[N];
+        const uint8_t* stream_ends[N];
+        uint32_t states[N];
+        auto stream_head = streams + N * sizeof(uint32_t);
+
+        if (streams_size < N * sizeof(uint32_t))
+        {
+            return -1;
+        }
+
+        // Every stream holds at least its initial state & is followed by the padding word.
+        for (auto i = 0u; i < N; ++i)
+        {
+            uint32_t word_count;
+            memcpy(&word_count, streams + i * sizeof(uint32_t), sizeof(uint32_t));
+
+            if (word_count < 2u || (size_t)(streams + streams_size - stream_head) < (word_count + 1ull) * sizeof(uint16_t))
+            {
+                return -1;
+            }
+
+            memcpy(&states[i], stream_head, sizeof(uint32_t));
+            words[i] = stream_head + sizeof(uint32_t);
+            stream_head += word_count * sizeof(uint16_t);
+            stream_ends[i] = stream_head;
+        }
+
+        // Lanes don't share any state. Every lane decodes a symbol & then renormalizes from its own stream in the same step,
+        // with the word read unconditionally & the pointer only advancing when it is used, so the lane loops have no branches.
+        const auto group_end = (write_size / N) * N;
+
+        for (auto i = 0ull; i < group_end; i += N)
+        {
+            for (auto j = 0u; j < N; ++j)
+            {
+                const auto entry = table[states[j] & mask];
+                write_data[i + j] = (uint8_t)entry;
+                states[j] = ((entry >> 8u) & mask) * (states[j] >> RANS_PROB_BITS) + (entry >> 20u);
+            }
+
+            for (auto j = 0u; j < N; ++j)
+            {
+                uint16_t word;
+                memcpy(&word, words[j], sizeof(uint16_t));
+                const auto is_renorm = states[j] < RANS_LOWER_BOUND;
+                states[j] = is_renorm ? (states[j] << 16u) | word : states[j];
+                words[j] += is_renorm ? sizeof(uint16_t) : 0u;
+            }
+        }
+
+        for (auto i = group_end; i < write_size; ++i)
+        {
+            auto& state = states[i - group_end];
+            const auto entry = table[state & mask];
+            write_data[i] = (uint8_t)entry;
+            state = ((entry >> 8u) & mask) * (state >> RANS_PROB_BITS) + (entry >> 20u);
+        }
+
+        // Valid streams are consumed exactly.
+        for (auto i = 0u; i < N; ++i)
+        {
+            if (words[i] != stream_ends[i])
+            {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    int DecodeRans(const void* in_data, size_t in_data_size, uint8_t* write_data, size_t write_size, uint32_t stream_count)
+    {
+        auto head = static_cast<const uint8_t*>(in_data);
+        const auto end = head + in_data_size;
+
+        if (in_data_size < 2ull)
+        {
+            return -1;
+        }
+
+        if (head[0] == RANS_MODE_RUN)
+        {
+            memset(write_data, head[1], write_size);
+            return 0;
+        }
+
+        if (in_data_size < 33ull)
+        {
+            return -1;
+        }
+
+        // Entry: symbol | frequency << 8 | (slot - start) << 20. Frequencies stay below the probability scale with two or more symbols.
+        uint32_t table[RANS_PROB_SCALE];
+        const auto bitmap = head + 1u;
+        auto start = 0u;
+        head += 33u;
+
+        for (auto i = 0u; i < PK_ASSET_ENCODE_CODE_COUNT; ++i)
+        {
+            if ((bitmap[i >> 3u] & (1u << (i & 7u))) == 0u)
+            {
+                continue;
+            }
+
+            if (end - head < 2)
+            {
+                return -1;
+            }
+
+            auto freq = (uint32_t)*head++;
+            freq = (freq & 0x80u) != 0u ? ((freq & 0x7Fu) << 8u) | *head++ : freq;
+
+            if (start + freq > RANS_PROB_SCALE)
+            {
+                return -1;
+            }
+
+            for (auto j = 0u; j < freq; ++j)
+            {
+                table[start + j] = i | (freq << 8u) | (j << 20u);
+            }
+
+            start += freq;
+        }
+
+        if (start != RANS_PROB_SCALE)
+        {
+            return -1;
+        }
+
+        switch (stream_count)
+        {
+            case 1u: return DecodeRansStates<1u>(table, head, (size_t)(end - head), write_data, write_size);
+            case 4u: return DecodeRansStates<4u>(table, head, (size_t)(end - head), write_data, write_size);
+            case 8u: return DecodeRansStates<8u>(table, head, (size_t)(end - head), write_data, write_size);
+            default: return -1;
+        }
+    }
+
+    template<typename TFunction>
+    static void ForEachBlock(size_t block_count, uint32_t thread_count, const TFunction& function)
+    {
+        thread_count = thread_count == 0u ? std::thread::hardware_concurrency() : thread_count;
+        thread_count = block_count < thread_count ? (uint32_t)block_count : thread_count;
+
+        if (thread_count <= 1u)
+        {
+            for (auto i = 0ull; i < block_count; ++i)
+            {
+                function(i);
+            }
+
+            return;
+        }
+
+        std::atomic<size_t> next_block = 0ull;
+        std::vector<std::thread> threads;
+
+        auto worker = [&]()
+        {
+            for (auto i = next_block++; i < block_count; i = next_block++)
+            {
+                function(i);
+            }
+        };
+
+        for (auto i = 1u; i < thread_count; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    static int EncodeEntropy(const uint8_t* in_data, size_t in_data_size, uint32_t codec, uint32_t stream_count, size_t header_size, uint8_t** out_data, size_t* out_data_size)
+    {
+        // Reserves header_size bytes in front of the encoded stream.
+        *out_data = nullptr;
+        *out_data_size = 0ull;
+
+        if (codec == PK_ASSET_ENCODE_CODEC_RANS)
+        {
+            auto encoded = static_cast<uint8_t*>(malloc(header_size + GetRansBound(in_data_size, stream_count)));
+            auto encoded_size = encoded ? EncodeRans(in_data, in_data_size, stream_count, encoded + header_size) : 0ull;
+
+            if (encoded_size == 0ull)
+            {
+                free(encoded);
+                return -1;
+            }
+
+            *out_data = encoded;
+            *out_data_size = header_size + encoded_size;
+            return 0;
+        }
+
+        PKEncodeTable table{};
+        EncodeBuffer(in_data, in_data_size, &table, nullptr, stream_count);
+        auto encoded = static_cast<uint8_t*>(malloc(header_size + table.size));
+
+        if (encoded == nullptr)
+        {
+            return -1;
+        }
+
+        EncodeBuffer(in_data, in_data_size, &table, encoded + header_size);
+        *out_data = encoded;
+        *out_data_size = header_size + table.size;
+        return 0;
+    }
+
+    static int DecodeEntropy(const uint8_t* in_data, size_t in_data_size, uint8_t* write_data, size_t write_size, uint32_t codec, uint32_t stream_count)
+    {
+        switch (codec)
+        {
+            case PK_ASSET_ENCODE_CODEC_HUFFMAN: return DecodeBuffer(in_data, write_data, write_size, stream_count);
+            case PK_ASSET_ENCODE_CODEC_RANS: return DecodeRans(in_data, in_data_size, write_data, write_size, stream_count);
+            default: return -1;
+        }
+    }
+
+    static int EncodeBlock(const uint8_t* in_data, size_t in_data_size, uint32_t codec, uint32_t stream_count, uint32_t flags, uint8_t** out_data, size_t* out_data_size)
+    {
+        if ((flags & PK_ASSET_ENCODE_FLAG_MATCHES) == 0u)
+        {
+            return EncodeEntropy(in_data, in_data_size, codec, stream_count, 0ull, out_data, out_data_size);
+        }
+
+        auto matches = static_cast<uint8_t*>(malloc(GetMatchBound(in_data_size)));
+        auto match_size = matches ? EncodeMatches(in_data, in_data_size, matches) : 0ull;
+        uint8_t* encoded = nullptr;
+        size_t encoded_size = 0ull;
+
+        if (match_size > 0ull && EncodeEntropy(matches, match_size, codec, stream_count, sizeof(uint32_t), &encoded, &encoded_size) == 0)
+        {
+            auto match_size32 = (uint32_t)match_size;
+            memcpy(encoded, &match_size32, sizeof(uint32_t));
+        }
+
+        free(matches);
+        *out_data = encoded;
+        *out_data_size = encoded_size;
+        return encoded == nullptr ? -1 : 0;
+    }
+
+    static int DecodeBlock(const uint8_t* in_data, size_t in_data_size, uint8_t* write_data, size_t write_size, uint32_t codec, uint32_t stream_count, uint32_t flags)
+    {
+        if ((flags & PK_ASSET_ENCODE_FLAG_MATCHES) == 0u)
+        {
+            return DecodeEntropy(in_data, in_data_size, write_data, write_size, codec, stream_count);
+        }
+
+        if (in_data_size < sizeof(uint32_t))
+        {
+            return -1;
+        }
+
+        uint32_t match_size = 0u;
+        memcpy(&match_size, in_data, sizeof(uint32_t));
+
+        // Decoders may write & read up to 8 bytes past the end of their buffers.
+        auto matches = static_cast<uint8_t*>(malloc(match_size + 8ull));
+        auto result = matches ? DecodeEntropy(in_data + sizeof(uint32_t), in_data_size - sizeof(uint32_t), matches, match_size, codec, stream_count) : -1;
+        result = result == 0 ? DecodeMatches(matches, match_size, write_data, write_size) : -1;
+        free(matches);
+        return result;
+    }
+
+    size_t GetBlockCount(size_t size, uint32_t block_shift)
+    {
+        return (size + (1ull << block_shift) - 1ull) >> block_shift;
+    }
+
+    int EncodeBufferBlocks(const void* in_data, size_t in_data_size, uint32_t block_shift, uint32_t codec, uint32_t stream_count, uint32_t flags, uint32_t thread_count, uint8_t** out_data, size_t* out_data_size)
+    {
+        const auto bytes = static_cast<const uint8_t*>(in_data);
+        const auto block_size = 1ull << block_shift;
+        const auto block_count = GetBlockCount(in_data_size, block_shift);
+        std::vector<uint8_t*> blocks(block_count, nullptr);
+        std::vector<size_t> block_sizes(block_count, 0ull);
+
+        ForEachBlock(block_count, thread_count, [&](size_t i)
+        {
+            const auto offset = i * block_size;
+            const auto size = in_data_size - offset < block_size ? in_data_size - offset : block_size;
+            EncodeBlock(bytes + offset, size, codec, stream_count, flags, &blocks[i], &block_sizes[i]);
+        });
+
+        auto table_size = block_count * sizeof(uint32_t);
+        auto total_size = table_size;
+        auto is_valid = true;
+
+        for (auto i = 0ull; i < block_count; ++i)
+        {
+            total_size += block_sizes[i];
+            is_valid &= blocks[i] != nullptr;
+        }
+
+        auto encoded = is_valid && total_size - table_size <= UINT32_MAX ? static_cast<uint8_t*>(malloc(total_size)) : nullptr;
+
+        if (encoded)
+        {
+            auto offsets = reinterpret_cast<uint32_t*>(encoded);
+            auto head = table_size;
+
+            for (auto i = 0ull; i < block_count; ++i)
+            {
+                memcpy(encoded + head, blocks[i], block_sizes[i]);
+                head += block_sizes[i];
+                offsets[i] = (uint32_t)(head - table_size);
+            }
+        }
+
+        for (auto block : blocks)
+        {
+            free(block);
+        }
+
+        *out_data = encoded;
+        *out_data_size = encoded ? total_size : 0ull;
+        return encoded == nullptr ? -1 : 0;
+    }
+
+    int ValidateBufferBlocks(const void* in_data, size_t in_data_size, size_t data_size, uint32_t block_shift)
+    {
+        if (block_shift == 0u || block_shift >= 32u)
+        {
+            return -1;
+        }
+
+        const auto block_count = GetBlockCount(data_size, block_shift);
+        const auto table_size = block_count * sizeof(uint32_t);
+        const auto offsets = static_cast<const uint32_t*>(in_data);
+        auto end = 0ull;
+
+        if (in_data_size < table_size)
+        {
+            return -1;
+        }
+
+        for (auto i = 0ull; i < block_count; ++i)
+        {
+            if (offsets[i] < end)
+            {
+                return -1;
+            }
+
+            end = offsets[i];
+        }
+
+        return end <= in_data_size - table_size ? 0 : -1;
+    }
+
+    int DecodeBufferBlocks(const void* in_data, uint8_t* write_data, size_t write_size, uint32_t block_shift, uint32_t codec, uint32_t stream_count, uint32_t flags, uint32_t thread_count)
+    {
+        const auto block_size = 1ull << block_shift;
+        const auto block_count = GetBlockCount(write_size, block_shift);
+        const auto offsets = static_cast<const uint32_t*>(in_data);
+        const auto blocks = static_cast<const uint8_t*>(in_data) + block_count * sizeof(uint32_t);
+        std::atomic<int> result = 0;
+
+        ForEachBlock(block_count, thread_count, [&](size_t i)
+        {
+            const auto offset = i * block_size;
+            const auto size = write_size - offset < block_size ? write_size - offset : block_size;
+
+            const auto block_start = i > 0ull ? offsets[i - 1ull] : 0u;
+
+            if (DecodeBlock(blocks + block_start, offsets[i] - block_start, write_data + offset, size, codec, stream_count, flags) != 0)
+            {
+                result = -1;
+            }
+        });
+
+        return result;
+    }
+
+    int DecodeBufferRange(const void* in_data, size_t data_size, uint32_t block_shift, uint32_t codec, uint32_t stream_count, uint32_t flags, size_t offset, size_t size, uint8_t* write_data)
+    {
+        if (offset + size > data_size)
+        {
+            return -1;
+        }
+
+        const auto block_size = 1ull << block_shift;
+        const auto block_count = GetBlockCount(data_size, block_shift);
+        const auto offsets = static_cast<const uint32_t*>(in_data);
+        const auto blocks = static_cast<const uint8_t*>(in_data) + block_count * sizeof(uint32_t);
+        uint8_t* scratch = nullptr;
+
+        for (auto i = offset >> block_shift; i < block_count && i * block_size < offset + size; ++i)
+        {
+            const auto block_offset = i * block_size;
+            const auto block_end = data_size - block_offset < block_size ? data_size : block_offset + block_size;
+            const auto copy_offset = offset > block_offset ? offset : block_offset;
+            const auto copy_end = offset + size < block_end ? offset + size : block_end;
+            const auto block_start = i > 0ull ? offsets[i - 1ull] : 0u;
+            const auto block = blocks + block_start;
+            const auto block_encoded_size = offsets[i] - block_start;
+
+            // Blocks fully inside the range are decoded directly into the destination.
+            if (copy_offset == block_offset && copy_end == block_end)
+            {
+                if (DecodeBlock(block, block_encoded_size, write_data + (block_offset - offset), block_end - block_offset, codec, stream_count, flags) != 0)
+                {
+                    free(scratch);
+                    return -1;
+                }
+
+                continue;
+            }
+
+            scratch = scratch ? scratch : static_cast<uint8_t*>(malloc(block_size));
+
+            if (scratch == nullptr || DecodeBlock(block, block_encoded_size, scratch, block_end - block_offset, codec, stream_count, flags) != 0)
+            {
+                free(scratch);
+                return -1;
+            }
+
+            memcpy(write_data + (copy_offset - offset), scratch + (copy_offset - block_offset), copy_end - copy_offset);
+        }
+
+        free(scratch);
+        return 0;
+    }
+
+    size_t GetFilterGroupSize(uint32_t stride)
+    {
+        return (size_t)stride * PK_ASSET_ENCODE_FILTER_GROUP_COUNT;
+    }
+
+    int EncodeFilter(uint8_t* data, size_t size, uint32_t stride, uint32_t flags)
+    {
+        if (stride == 0u || stride > PK_ASSET_ENCODE_FILTER_MAX_STRIDE)
+        {
+            return -1;
+        }
+
+        uint8_t scratch[PK_ASSET_ENCODE_FILTER_MAX_STRIDE * PK_ASSET_ENCODE_FILTER_GROUP_COUNT];
+        const auto is_delta = (flags & PK_ASSET_ENCODE_FILTER_DELTA) != 0u;
+        const auto element_count = size / stride;
+
+        for (auto first = 0ull; first < element_count; first += PK_ASSET_ENCODE_FILTER_GROUP_COUNT)
+        {
+            const auto count = element_count - first < PK_ASSET_ENCODE_FILTER_GROUP_COUNT ? element_count - first : PK_ASSET_ENCODE_FILTER_GROUP_COUNT;
+            auto group = data + first * stride;
+
+            for (auto k = 0u; k < stride; ++k)
+            {
+                auto plane = scratch + k * count;
+                auto previous = 0u;
+
+                for (auto i = 0ull; i < count; ++i)
+                {
+                    const auto value = group[i * stride + k];
+                    plane[i] = is_delta ? (uint8_t)(value - previous) : value;
+                    previous = value;
+                }
+            }
+
+            memcpy(group, scratch, count * stride);
+        }
+
+        return 0;
+    }
+
+    int DecodeFilter(uint8_t* data, size_t size, uint32_t stride, uint32_t flags)
+    {
+        if (stride == 0u || stride > PK_ASSET_ENCODE_FILTER_MAX_STRIDE)
+        {
+            return -1;
+        }
+
+        uint8_t scratch[PK_ASSET_ENCODE_FILTER_MAX_STRIDE * PK_ASSET_ENCODE_FILTER_GROUP_COUNT];
+        const auto is_delta = (flags & PK_ASSET_ENCODE_FILTER_DELTA) != 0u;
+        const auto element_count = size / stride;
+
+        for (auto first = 0ull; first < element_count; first += PK_ASSET_ENCODE_FILTER_GROUP_COUNT)
+        {
+            const auto count = element_count - first < PK_ASSET_ENCODE_FILTER_GROUP_COUNT ? element_count - first : PK_ASSET_ENCODE_FILTER_GROUP_COUNT;
+            auto group = data + first * stride;
+            memcpy(scratch, group, count * stride);
+
+            for (auto k = 0u; k < stride; ++k)
+            {
+                auto plane = scratch + k * count;
+                uint8_t previous = 0u;
+
+                for (auto i = 0ull; i < count; ++i)
+                {
+                    previous = is_delta ? (uint8_t)(plane[i] + previous) : plane[i];
+                    group[i * stride + k] = previous;
+                }
+            }
+        }
+
+        return 0;
+    }
+}
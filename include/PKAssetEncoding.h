@@ -6,6 +6,22 @@ namespace PKAssets
     constexpr static const uint32_t PK_ASSET_ENCODE_CODE_COUNT = 256u;
     constexpr static const uint32_t PK_ASSET_ENCODE_CODE_LENGTH = 11u;
     constexpr static const uint32_t PK_ASSET_ENCODE_CODE_BIT_COUNT = 4u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_TABLE_SIZE = PK_ASSET_ENCODE_CODE_COUNT * PK_ASSET_ENCODE_CODE_BIT_COUNT / 8u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_MAX_STREAM_COUNT = 8u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_BLOCK_SHIFT = 18u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_FLAG_MATCHES = 1u << 0u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_CODEC_HUFFMAN = 0u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_CODEC_RANS = 1u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_CODEC_COUNT = 2u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_MATCH_MIN_LENGTH = 4u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_MATCH_MAX_OFFSET = 65535u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_FILTER_DELTA = 1u << 0u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_FILTER_MAX_STRIDE = 64u;
+    constexpr static const uint32_t PK_ASSET_ENCODE_FILTER_GROUP_COUNT = 256u;
+
+    constexpr static const uint32_t PK_ASSET_DECODE_STREAM_INPUT_SIZE = 16384u;
+    // Single stream buffers of at least this size are decoded with a table resolving up to two symbols per lookup.
+    constexpr static const uint32_t PK_ASSET_DECODE_PAIR_MIN_SIZE = 16384u;
 
     struct PKEncodeTable
     {
@@ -13,9 +29,84 @@ namespace PKAssets
         uint16_t codes[PK_ASSET_ENCODE_CODE_COUNT]{};
         size_t decodePadding;
         size_t size;
+        uint32_t streamCount;
+    };
+
+    // Stream counts of 4 & 8 split the payload into interleaved 32 bit words decoded by independent bit streams sharing one code table.
+    // Stream bytes are stored in the order the decoder consumes them so that in place decoding works the same as with a single stream.
+    // The stream count is selected in the measure pass (out_data == nullptr).
+    void EncodeBuffer(const void* in_data, size_t in_data_size, PKEncodeTable* table, uint8_t* out_data, uint32_t stream_count = 1u);
+    int EncodeBuffer(const void* in_data, size_t in_data_size, uint8_t** out_data, size_t* out_data_size, uint32_t stream_count = 1u);
+    int DecodeBuffer(const void* in_data, uint8_t* write_data, size_t write_size, uint32_t stream_count = 1u);
+    // Single stream decode resolving one symbol per lookup. Baseline for the pair table used by DecodeBuffer.
+    int DecodeBufferSingleTable(const void* in_data, uint8_t* write_data, size_t write_size);
+    // Expected symbols resolved per pair table lookup (1-2) for the codes of a measured table, assuming independent symbols.
+    double GetDecodePairRatio(const PKEncodeTable* table, const void* in_data, size_t in_data_size);
+
+    // Resumable decoder for buffers encoded with EncodeBuffer. Encoded input is fed in chunks & decoded output is produced into caller provided windows.
+    // Only PK_ASSET_DECODE_STREAM_INPUT_SIZE bytes of input are staged. Neither the whole encoded nor the whole decoded buffer needs to be resident.
+    // DecodeStream returns the number of bytes written. It stops early when more input is needed or the end of the decoded buffer is reached.
+    struct PKDecodeStream
+    {
+        uint16_t table[1u << PK_ASSET_ENCODE_CODE_LENGTH];
+        uint64_t bitbuffers[PK_ASSET_ENCODE_MAX_STREAM_COUNT];
+        uint32_t bitcounts[PK_ASSET_ENCODE_MAX_STREAM_COUNT];
+        uint8_t pending[4u * PK_ASSET_ENCODE_MAX_STREAM_COUNT];
+        uint8_t input[PK_ASSET_DECODE_STREAM_INPUT_SIZE + 8u * PK_ASSET_ENCODE_MAX_STREAM_COUNT + 8u];
+        size_t inputHead;
+        size_t inputSize;
+        size_t readSize;
+        size_t encodedSize;
+        size_t decodeOffset;
+        size_t writeOffset;
+        size_t writeSize;
+        uint32_t pendingHead;
+        uint32_t pendingSize;
+        uint32_t streamCount;
+        bool hasTable;
     };
 
-    void EncodeBuffer(const void* in_data, size_t in_data_size, PKEncodeTable* table, uint8_t* out_data);
-    int EncodeBuffer(const void* in_data, size_t in_data_size, uint8_t** out_data, size_t* out_data_size);
-    int DecodeBuffer(const void* in_data, uint8_t* write_data, size_t write_size);
-}
\ No newline at end of file
+    int BeginDecodeStream(PKDecodeStream* stream, size_t encoded_size, size_t write_size, uint32_t stream_count);
+    size_t FeedDecodeStream(PKDecodeStream* stream, const void* in_data, size_t in_data_size);
+    size_t DecodeStream(PKDecodeStream* stream, uint8_t* write_data, size_t write_size);
+
+    // Match stage. Byte oriented LZ77 style token stream that is entropy coded instead of the raw payload.
+    // Sequence: token (literal length << 4 | match length - 4), extended lengths as 255 terminated runs, literals, uint16 match offset.
+    // The last sequence only contains literals.
+    size_t GetMatchBound(size_t size);
+    size_t EncodeMatches(const void* in_data, size_t in_data_size, uint8_t* out_data);
+    int DecodeMatches(const void* in_data, size_t in_data_size, uint8_t* write_data, size_t write_size);
+
+    // rANS entropy coder. 32 bit states with 16 bit renormalization & 12 bit probabilities.
+    // stream_count (1, 4 or 8) states are interleaved symbol by symbol. Each state renormalizes from its own word stream.
+    // Layout: mode byte, symbol presence bitmap, 1-2 byte frequency per present symbol, uint32 word count of each stream,
+    // the streams (initial state followed by 16 bit words) & one padding word.
+    // Payloads with a single distinct symbol are stored as a run. Decoding fails when the tables don't fit into in_data_size or a stream isn't consumed exactly.
+    size_t GetRansBound(size_t size, uint32_t stream_count);
+    size_t EncodeRans(const void* in_data, size_t in_data_size, uint32_t stream_count, uint8_t* out_data);
+    int DecodeRans(const void* in_data, size_t in_data_size, uint8_t* write_data, size_t write_size, uint32_t stream_count);
+
+    // Block encoding. The payload is split into blocks of (1 << block_shift) bytes that are encoded independently with their own code tables.
+    // Layout: uint32 end offset of each block (relative to the end of the offset table) followed by the encoded blocks.
+    // Blocks are encoded & decoded on up to thread_count threads. Zero uses all hardware threads, callers running on a job pool should pass 1.
+    // Block encoded buffers can't be decoded in place.
+    // With PK_ASSET_ENCODE_FLAG_MATCHES each block stores the uint32 size of its match stream followed by the entropy coded match stream.
+    // Codec selects the entropy coder of each block (PK_ASSET_ENCODE_CODEC_HUFFMAN or PK_ASSET_ENCODE_CODEC_RANS).
+    size_t GetBlockCount(size_t size, uint32_t block_shift);
+    int EncodeBufferBlocks(const void* in_data, size_t in_data_size, uint32_t block_shift, uint32_t codec, uint32_t stream_count, uint32_t flags, uint32_t thread_count, uint8_t** out_data, size_t* out_data_size);
+    int DecodeBufferBlocks(const void* in_data, uint8_t* write_data, size_t write_size, uint32_t block_shift, uint32_t codec, uint32_t stream_count, uint32_t flags, uint32_t thread_count);
+    // Checks that the offset table of in_data_size encoded bytes is ordered & ends within them. Decoding assumes a valid table.
+    // Only the table is read, so it can be checked before the blocks are read.
+    int ValidateBufferBlocks(const void* in_data, size_t in_data_size, size_t data_size, uint32_t block_shift);
+
+    // Decodes size bytes starting at offset of the decoded payload. Only the overlapping blocks are decoded.
+    int DecodeBufferRange(const void* in_data, size_t data_size, uint32_t block_shift, uint32_t codec, uint32_t stream_count, uint32_t flags, size_t offset, size_t size, uint8_t* write_data);
+
+    // Byte plane filter. Regions of fixed stride elements are transposed so that equal bytes of each field are coded next to each other.
+    // Elements are transposed in groups of PK_ASSET_ENCODE_FILTER_GROUP_COUNT so that a group aligned sub range can be decoded on its own.
+    // PK_ASSET_ENCODE_FILTER_DELTA stores each plane as the difference to the previous element within the group.
+    // Trailing bytes that don't form a full element are left as is.
+    size_t GetFilterGroupSize(uint32_t stride);
+    int EncodeFilter(uint8_t* data, size_t size, uint32_t stride, uint32_t flags);
+    int DecodeFilter(uint8_t* data, size_t size, uint32_t stride, uint32_t flags);
+}
@@ -2,8 +2,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/stat.h>
 #include <malloc.h>
+#include <algorithm>
+#include <mutex>
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "PKAssetLoader.h"
 #include "PKAssetEncoding.h"
 
@@ -24,7 +36,11 @@ namespace PKAssets
         }
 
         struct stat filestat;
+#if _WIN32
         int fileNumber = _fileno(file);
+#else
+        int fileNumber = fileno(file);
+#endif
         if (fstat(fileNumber, &filestat) != 0)
         {
             fclose(file);
@@ -42,96 +58,740 @@ namespace PKAssets
         return file;
     }
 
+    static intptr_t OpenFileDescriptor(const char* filepath, size_t* size)
+    {
+        if (filepath == nullptr)
+        {
+            return PK_ASSET_INVALID_FILE;
+        }
+
+#if _WIN32
+        // Synchronous handles serialize all reads. Overlapped handles let concurrent reads proceed independently.
+        auto fileHandle = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+        LARGE_INTEGER fileSize;
+
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            return PK_ASSET_INVALID_FILE;
+        }
+
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(fileHandle);
+            return PK_ASSET_INVALID_FILE;
+        }
+
+        *size = (size_t)fileSize.QuadPart;
+        return reinterpret_cast<intptr_t>(fileHandle);
+#else
+        auto fileDescriptor = open(filepath, O_RDONLY | O_CLOEXEC);
+        struct stat filestat;
+
+        if (fileDescriptor < 0)
+        {
+            return PK_ASSET_INVALID_FILE;
+        }
+
+        if (fstat(fileDescriptor, &filestat) != 0 || filestat.st_size == 0)
+        {
+            close(fileDescriptor);
+            return PK_ASSET_INVALID_FILE;
+        }
+
+        *size = (size_t)filestat.st_size;
+        return fileDescriptor;
+#endif
+    }
+
+    static void CloseFileDescriptor(intptr_t file)
+    {
+#if _WIN32
+        CloseHandle(reinterpret_cast<HANDLE>(file));
+#else
+        close((int)file);
+#endif
+    }
+
+    // Positional reads don't move a shared file position, so any number of threads can read from the same descriptor.
+    // Reads are split into chunks as single reads are limited to less than 2GB on some platforms.
+    static int ReadFileAt(intptr_t file, void* dst, size_t size, size_t offset)
+    {
+        constexpr auto maxChunkSize = 1ull << 30ull;
+        auto bytes = static_cast<uint8_t*>(dst);
+
+        while (size > 0ull)
+        {
+            auto chunkSize = size < maxChunkSize ? size : maxChunkSize;
+#if _WIN32
+            // Each read waits on an event of its own so that completions of concurrent reads on the same handle aren't confused.
+            OVERLAPPED overlapped{};
+            overlapped.Offset = (DWORD)(offset & 0xFFFFFFFFull);
+            overlapped.OffsetHigh = (DWORD)(offset >> 32ull);
+            overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            DWORD readSize = 0u;
+
+            if (overlapped.hEvent == nullptr)
+            {
+                return -1;
+            }
+
+            auto isRead = ReadFile(reinterpret_cast<HANDLE>(file), bytes, (DWORD)chunkSize, nullptr, &overlapped) || GetLastError() == ERROR_IO_PENDING;
+            isRead = isRead && GetOverlappedResult(reinterpret_cast<HANDLE>(file), &overlapped, &readSize, TRUE);
+            CloseHandle(overlapped.hEvent);
+
+            if (!isRead || readSize == 0u)
+            {
+                return -1;
+            }
+#else
+            auto readSize = pread((int)file, bytes, chunkSize, (off_t)offset);
+
+            if (readSize < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (readSize <= 0)
+            {
+                return -1;
+            }
+#endif
+            bytes += readSize;
+            offset += readSize;
+            size -= readSize;
+        }
+
+        return 0;
+    }
+
+
+    static int ValidateFilters(const PKAssetHeader& header, const PKAssetFilter* filters)
+    {
+        for (auto i = 0u; i < header.filterCount; ++i)
+        {
+            if (filters[i].offset < sizeof(PKAssetHeader) || (uint64_t)filters[i].offset + filters[i].size > header.uncompressedSize)
+            {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    static int ReadFilters(FILE* file, const PKAssetHeader& header, PKAssetFilter* filters)
+    {
+        if (header.filterCount > PK_ASSET_MAX_FILTERS || (header.filterCount > 0u && !header.isCompressed))
+        {
+            return -1;
+        }
+
+        if (fread(filters, sizeof(PKAssetFilter), header.filterCount, file) != header.filterCount)
+        {
+            return -1;
+        }
+
+        return ValidateFilters(header, filters);
+    }
+
+    // Sections must cover the payload in order & be block encoded. Filters can't be reversed on partially decoded payloads, so the two are exclusive.
+    static int ValidateSections(const PKAssetHeader& header, const PKAssetSection* sections, size_t encodedSize)
+    {
+        auto offset = (uint64_t)sizeof(PKAssetHeader);
+
+        if (header.sectionCount > 0u && (!header.isCompressed || header.blockShift == 0u || header.filterCount > 0u))
+        {
+            return -1;
+        }
+
+        for (auto i = 0u; i < header.sectionCount; ++i)
+        {
+            if (sections[i].offset != offset || (uint64_t)sections[i].encodedOffset + sections[i].encodedSize > encodedSize)
+            {
+                return -1;
+            }
+
+            offset += sections[i].size;
+        }
+
+        return header.sectionCount == 0u || offset == header.uncompressedSize ? 0 : -1;
+    }
+
+    static int ReadSections(FILE* file, const PKAssetHeader& header, PKAssetSection* sections)
+    {
+        if (header.sectionCount > PK_ASSET_MAX_SECTIONS)
+        {
+            return -1;
+        }
+
+        return fread(sections, sizeof(PKAssetSection), header.sectionCount, file) == header.sectionCount ? 0 : -1;
+    }
+
+    static void* AllocateMemory(const PKAssetAllocator* allocator, size_t size)
+    {
+        return allocator != nullptr ? allocator->allocate(allocator->userData, size) : malloc(size);
+    }
+
+    static void FreeMemory(const PKAssetAllocator* allocator, void* memory)
+    {
+        if (allocator != nullptr && memory != nullptr)
+        {
+            allocator->free(allocator->userData, memory);
+        }
+        else if (memory != nullptr)
+        {
+            free(memory);
+        }
+    }
+
+    uint64_t GetAssetNameHash(const char* name)
+    {
+        auto hash = 0xCBF29CE484222325ull;
+
+        for (; name != nullptr && *name != 0; ++name)
+        {
+            hash = (hash ^ (uint8_t)*name) * 0x100000001B3ull;
+        }
+
+        return hash;
+    }
+
+    size_t GetAssetPayloadOffset(const PKAssetHeader& header)
+    {
+        return sizeof(PKAssetHeader) + header.filterCount * sizeof(PKAssetFilter) + header.sectionCount * sizeof(PKAssetSection);
+    }
+
+    size_t GetAssetDecodeSize(const PKAssetHeader& header)
+    {
+        // In place decoding reads up to 8 bytes past the encoded data at the end of the buffer.
+        auto isInPlace = header.isCompressed && header.blockShift == 0u;
+        return header.uncompressedSize + header.decodePadding * 16ull + (isInPlace ? 8ull : 0ull);
+    }
+
+    // Validates the header, filters & sections of a load & sizes its buffers.
+    static int PrepareAssetLoad(PKAssetLoad* load, size_t fileSize)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        const auto& header = load->header;
+        auto payloadOffset = GetAssetPayloadOffset(header);
+
+        // Only Huffman payloads can be decoded in place. Other codecs are always block encoded.
+        if (header.magicNumber != PK_ASSET_MAGIC_NUMBER || header.codec >= PK_ASSET_ENCODE_CODEC_COUNT || (header.isCompressed && header.blockShift == 0u && header.codec != PK_ASSET_ENCODE_CODEC_HUFFMAN))
+        {
+            return -1;
+        }
+
+        if (header.uncompressedSize < headerSize || fileSize < payloadOffset || ValidateFilters(header, load->filters) != 0 || ValidateSections(header, load->sections, fileSize - payloadOffset) != 0)
+        {
+            return -1;
+        }
+
+        // Block encoded payloads cant be decoded in place & are read into a separate buffer.
+        auto isBlocked = header.isCompressed && header.blockShift != 0u;
+        load->buffer = nullptr;
+        load->encoded = nullptr;
+        load->encodedSize = fileSize - payloadOffset;
+        load->bufferSize = GetAssetDecodeSize(header);
+        load->memorySize = load->bufferSize + (isBlocked ? load->encodedSize + 8ull : 0ull);
+        return 0;
+    }
+
+    int BeginAssetLoad(const char* filepath, PKAssetLoad* load)
+    {
+        size_t size = 0ull;
+        FILE* file = OpenFile(filepath, "rb", &size);
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        auto& header = load->header;
+
+        if (file == nullptr)
+        {
+            return -1;
+        }
+
+        if (size < headerSize || fread(&header, headerSize, 1, file) != 1 || ReadFilters(file, header, load->filters) != 0 || ReadSections(file, header, load->sections) != 0 || PrepareAssetLoad(load, size) != 0)
+        {
+            fclose(file);
+            return -1;
+        }
+
+        load->file = file;
+        return 0;
+    }
+
+    int BeginAssetLoad(const void* head, size_t headSize, size_t fileSize, PKAssetLoad* load)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        auto& header = load->header;
+
+        if (head == nullptr || headSize < headerSize || fileSize < headSize)
+        {
+            return -1;
+        }
+
+        memcpy(&header, head, headerSize);
+        auto filtersSize = header.filterCount * sizeof(PKAssetFilter);
+        auto sectionsSize = header.sectionCount * sizeof(PKAssetSection);
+
+        if (header.filterCount > PK_ASSET_MAX_FILTERS || (header.filterCount > 0u && !header.isCompressed) || header.sectionCount > PK_ASSET_MAX_SECTIONS || headSize < headerSize + filtersSize + sectionsSize)
+        {
+            return -1;
+        }
+
+        memcpy(load->filters, static_cast<const uint8_t*>(head) + headerSize, filtersSize);
+        memcpy(load->sections, static_cast<const uint8_t*>(head) + headerSize + filtersSize, sectionsSize);
+        load->file = nullptr;
+        return PrepareAssetLoad(load, fileSize);
+    }
+
+    uint8_t* AllocateAssetLoad(PKAssetLoad* load, size_t* outReadSize)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        const auto& header = load->header;
+
+        if (load->destination != nullptr && load->destinationSize < load->bufferSize)
+        {
+            return nullptr;
+        }
+
+        load->buffer = load->destination != nullptr ? load->destination : static_cast<uint8_t*>(AllocateMemory(load->allocator, load->bufferSize));
+
+        if (load->buffer != nullptr && header.isCompressed && header.blockShift != 0u)
+        {
+            // Decoders may read up to 8 bytes past the encoded data.
+            load->encoded = static_cast<uint8_t*>(AllocateMemory(load->allocator, load->encodedSize + 8ull));
+            *outReadSize = load->encodedSize;
+            return load->encoded;
+        }
+
+        if (load->buffer != nullptr && header.isCompressed && load->encodedSize + 8ull <= load->bufferSize - headerSize)
+        {
+            // Write uncompressed data to the end of the asset buffer & decode in place.
+            // Includes precalculated overscan offset so that inplace decoding doesn't overrun the encoded buffer.
+            load->encoded = load->buffer + (load->bufferSize - 8ull - load->encodedSize);
+            *outReadSize = load->encodedSize;
+            return load->encoded;
+        }
+
+        if (load->buffer != nullptr && !header.isCompressed)
+        {
+            *outReadSize = header.uncompressedSize - headerSize;
+            return load->buffer + headerSize;
+        }
+
+        return nullptr;
+    }
+
+    int ReadAssetLoad(PKAssetLoad* load)
+    {
+        auto file = reinterpret_cast<FILE*>(load->file);
+        size_t readSize = 0ull;
+        auto destination = AllocateAssetLoad(load, &readSize);
+        auto isRead = destination != nullptr && fread(destination, sizeof(uint8_t), readSize, file) == readSize;
+
+        fclose(file);
+        load->file = nullptr;
+
+        if (!isRead)
+        {
+            CancelAssetLoad(load);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    int DecodeAssetLoad(PKAssetLoad* load, PKAsset* asset, uint32_t threadCount)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        auto header = load->header;
+        auto buffer = load->buffer;
+        auto result = 0;
+
+        if (header.isCompressed && header.blockShift != 0u)
+        {
+            // Sections are block encoded independently of each other.
+            for (auto i = 0u; i < header.sectionCount && result == 0; ++i)
+            {
+                const auto& section = load->sections[i];
+                result = ValidateBufferBlocks(load->encoded + section.encodedOffset, section.encodedSize, section.size, header.blockShift);
+                result = result == 0 ? DecodeBufferBlocks(load->encoded + section.encodedOffset, buffer + section.offset, section.size, header.blockShift, header.codec, header.streamCount, header.encodeFlags, threadCount) : -1;
+            }
+
+            if (header.sectionCount == 0u)
+            {
+                result = ValidateBufferBlocks(load->encoded, load->encodedSize, header.uncompressedSize - headerSize, header.blockShift);
+                result = result == 0 ? DecodeBufferBlocks(load->encoded, buffer + headerSize, header.uncompressedSize - headerSize, header.blockShift, header.codec, header.streamCount, header.encodeFlags, threadCount) : -1;
+            }
+
+            FreeMemory(load->allocator, load->encoded);
+            header.isCompressed = false;
+            header.streamCount = 1u;
+            header.blockShift = 0u;
+            header.encodeFlags = 0u;
+            header.codec = 0u;
+        }
+        else if (header.isCompressed)
+        {
+            result = DecodeBuffer(load->encoded, buffer + headerSize, header.uncompressedSize - headerSize, header.streamCount);
+            header.isCompressed = false;
+            header.streamCount = 1u;
+        }
+
+        for (auto i = 0u; i < header.filterCount && result == 0; ++i)
+        {
+            const auto& filter = load->filters[i];
+            result = DecodeFilter(buffer + filter.offset, filter.size, filter.stride, filter.flags);
+        }
+
+        header.filterCount = 0u;
+        header.sectionCount = 0u;
+        auto isExternal = load->destination != nullptr;
+        load->buffer = nullptr;
+        load->encoded = nullptr;
+
+        if (result != 0)
+        {
+            FreeMemory(load->allocator, isExternal ? nullptr : buffer);
+            return -1;
+        }
+
+        asset->rawData = buffer;
+        asset->mappedSize = 0ull;
+        asset->allocator = load->allocator;
+        asset->isExternal = isExternal;
+        *(asset->header) = header;
+        return 0;
+    }
+
+    void CancelAssetLoad(PKAssetLoad* load)
+    {
+        auto isSeparate = load->header.isCompressed && load->header.blockShift != 0u;
+
+        if (load->file != nullptr)
+        {
+            fclose(reinterpret_cast<FILE*>(load->file));
+        }
+
+        if (isSeparate)
+        {
+            FreeMemory(load->allocator, load->encoded);
+        }
+
+        if (load->buffer != load->destination)
+        {
+            FreeMemory(load->allocator, load->buffer);
+        }
+
+        load->file = nullptr;
+        load->buffer = nullptr;
+        load->encoded = nullptr;
+    }
+
+    int OpenAsset(const char* filepath, PKAsset* asset, const PKAssetAllocator* allocator)
+    {
+        PKAssetLoad load;
+        load.allocator = allocator;
+
+        if (BeginAssetLoad(filepath, &load) != 0 || ReadAssetLoad(&load) != 0)
+        {
+            return -1;
+        }
+
+        return DecodeAssetLoad(&load, asset, 0u);
+    }
+
+    void CloseAsset(PKAsset* asset)
+    {
+        if (asset->rawData != nullptr && asset->mappedSize > 0ull)
+        {
+#if _WIN32
+            UnmapViewOfFile(asset->rawData);
+#else
+            munmap(asset->rawData, asset->mappedSize);
+#endif
+        }
+        else if (!asset->isExternal)
+        {
+            FreeMemory(asset->allocator, asset->rawData);
+        }
+
+        asset->rawData = nullptr;
+        asset->mappedSize = 0ull;
+        asset->allocator = nullptr;
+        asset->isExternal = false;
+    }
+
+    int ProbeAsset(const char* filepath, PKAssetHeader* outHeader)
+    {
+        size_t size = 0ull;
+        FILE* file = OpenFile(filepath, "rb", &size);
+
+        if (file == nullptr)
+        {
+            return -1;
+        }
+
+        auto isRead = size >= sizeof(PKAssetHeader) && fread(outHeader, sizeof(PKAssetHeader), 1, file) == 1;
+        fclose(file);
+        return isRead && outHeader->magicNumber == PK_ASSET_MAGIC_NUMBER ? 0 : -1;
+    }
+
+    int OpenAssetInto(const char* filepath, void* dst, size_t dstSize, PKAsset* asset, const PKAssetAllocator* allocator)
+    {
+        PKAssetLoad load;
+        load.allocator = allocator;
+        load.destination = static_cast<uint8_t*>(dst);
+        load.destinationSize = dstSize;
+
+        if (dst == nullptr || BeginAssetLoad(filepath, &load) != 0 || ReadAssetLoad(&load) != 0)
+        {
+            return -1;
+        }
+
+        return DecodeAssetLoad(&load, asset, 0u);
+    }
+
+    int OpenAssetMapped(const char* filepath, PKAsset* asset, uint32_t advice)
+    {
+        if (filepath == nullptr)
+        {
+            return -1;
+        }
+
+        PKAssetHeader header;
+        size_t size = 0ull;
+        FILE* file = OpenFile(filepath, "rb", &size);
+        auto isRead = file != nullptr && size >= sizeof(PKAssetHeader) && fread(&header, sizeof(PKAssetHeader), 1, file) == 1u;
+
+        if (file != nullptr)
+        {
+            fclose(file);
+        }
+
+        if (!isRead || header.magicNumber != PK_ASSET_MAGIC_NUMBER)
+        {
+            return -1;
+        }
+
+        if (header.isCompressed)
+        {
+            return OpenAsset(filepath, asset);
+        }
+
+        // Same header checks as the staged load. Uncompressed assets have neither filters nor sections.
+        if (header.uncompressedSize < sizeof(PKAssetHeader) || header.uncompressedSize > size || header.filterCount > 0u || header.sectionCount > 0u)
+        {
+            return -1;
+        }
+
+        void* mapping = nullptr;
+
+#if _WIN32
+        auto fileHandle = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            return -1;
+        }
+
+        // The view keeps the mapping alive. Both handles can be closed once it is created.
+        auto mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+        mapping = mappingHandle != nullptr ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0u, 0u, header.uncompressedSize) : nullptr;
+
+        if (mappingHandle != nullptr)
+        {
+            CloseHandle(mappingHandle);
+        }
+
+        CloseHandle(fileHandle);
+#else
+        auto fileDescriptor = open(filepath, O_RDONLY);
+
+        if (fileDescriptor < 0)
+        {
+            return -1;
+        }
+
+        mapping = mmap(nullptr, header.uncompressedSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+        mapping = mapping != MAP_FAILED ? mapping : nullptr;
+        close(fileDescriptor);
+#endif
+
+        if (mapping == nullptr)
+        {
+            return -1;
+        }
+
+        asset->rawData = mapping;
+        asset->mappedSize = header.uncompressedSize;
+        asset->allocator = nullptr;
+        asset->isExternal = false;
+        AdviseAsset(asset, 0ull, header.uncompressedSize, advice);
+        return 0;
+    }
+
+    int AdviseAsset(PKAsset* asset, size_t offset, size_t size, uint32_t advice)
+    {
+        if (asset->rawData == nullptr || asset->mappedSize == 0ull || offset >= asset->mappedSize)
+        {
+            return asset->mappedSize == 0ull ? 0 : -1;
+        }
+
+        size = size < asset->mappedSize - offset ? size : asset->mappedSize - offset;
+
+#if _WIN32
+        // Windows only exposes prefetching. Access pattern hints are ignored.
+        if ((advice & PK_ASSET_MAP_ADVICE_WILLNEED) != 0u)
+        {
+            WIN32_MEMORY_RANGE_ENTRY range;
+            range.VirtualAddress = static_cast<char*>(asset->rawData) + offset;
+            range.NumberOfBytes = size;
+            return PrefetchVirtualMemory(GetCurrentProcess(), 1u, &range, 0u) ? 0 : -1;
+        }
+
+        return 0;
+#else
+        // Ranges are expanded to whole pages.
+        auto pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        auto first = (offset / pageSize) * pageSize;
+        auto address = static_cast<char*>(asset->rawData) + first;
+        size += offset - first;
+        auto result = 0;
+
+        if ((advice & PK_ASSET_MAP_ADVICE_SEQUENTIAL) != 0u)
+        {
+            result |= madvise(address, size, MADV_SEQUENTIAL);
+        }
+        else if ((advice & PK_ASSET_MAP_ADVICE_RANDOM) != 0u)
+        {
+            result |= madvise(address, size, MADV_RANDOM);
+        }
 
-    int OpenAsset(const char* filepath, PKAsset* asset)
+        if ((advice & PK_ASSET_MAP_ADVICE_WILLNEED) != 0u)
+        {
+            result |= madvise(address, size, MADV_WILLNEED);
+        }
+
+        return result == 0 ? 0 : -1;
+#endif
+    }
+
+
+    // Sequential decoding keeps its position between requests, so requests to the same stream are serialized.
+    struct PKAssetStreamDecoder
+    {
+        std::mutex mutex;
+        PKDecodeStream decoder;
+    };
+
+    int OpenAssetStream(const char* filepath, PKAssetStream* stream)
     {
         size_t size = 0ull;
-        FILE* file = OpenFile(filepath, "rb", &size);
+        auto file = OpenFileDescriptor(filepath, &size);
         constexpr auto headerSize = sizeof(PKAssetHeader);
 
-        if (file == nullptr || size < headerSize)
+        if (file == PK_ASSET_INVALID_FILE)
         {
             return -1;
         }
 
-        PKAssetHeader header;
-        fread(&header, headerSize, 1, file);
+        // The header, filter & section tables are validated the same way as for loads.
+        uint8_t head[PK_ASSET_LOAD_HEAD_SIZE];
+        auto headSize = size < sizeof(head) ? size : sizeof(head);
+        PKAssetLoad load;
 
-        if (header.magicNumber != PK_ASSET_MAGIC_NUMBER)
+        if (ReadFileAt(file, head, headSize, 0ull) != 0 || BeginAssetLoad(head, headSize, size, &load) != 0)
         {
-            fclose(file);
+            CloseFileDescriptor(file);
             return -1;
         }
 
-        auto bufferSize = header.uncompressedSize + header.decodePadding * 16ull;
-        auto buffer = static_cast<uint8_t*>(malloc(bufferSize));
+        auto& header = stream->header;
+        header = load.header;
+        stream->file = file;
 
-        if (header.isCompressed)
+        if (header.filterCount > 0u)
         {
-            // Write uncompressed data to the end of the asset buffer & decode in place.
-            // Includes precalculated overscan offset so that inplace decoding doesn't overrun the encoded buffer.
-            auto compressed = buffer + (bufferSize - (size - headerSize));
-            fread(compressed, sizeof(uint8_t), size - headerSize, file);
-            DecodeBuffer(compressed, buffer + headerSize, header.uncompressedSize - headerSize);
-            header.isCompressed = false;
+            stream->filters = static_cast<PKAssetFilter*>(malloc(header.filterCount * sizeof(PKAssetFilter)));
+
+            if (stream->filters == nullptr)
+            {
+                CloseAssetStream(stream);
+                return -1;
+            }
+
+            memcpy(stream->filters, load.filters, header.filterCount * sizeof(PKAssetFilter));
         }
-        else
+
+        // Block encoded files decode the blocks overlapping the requested range on demand. Other compressed files are decoded front to back.
+        if (header.sectionCount > 0u)
         {
-            fread(buffer + headerSize, sizeof(uint8_t), header.uncompressedSize - headerSize, file);
+            stream->sections = static_cast<PKAssetSection*>(malloc(header.sectionCount * sizeof(PKAssetSection)));
+
+            if (stream->sections == nullptr)
+            {
+                CloseAssetStream(stream);
+                return -1;
+            }
+
+            memcpy(stream->sections, load.sections, header.sectionCount * sizeof(PKAssetSection));
         }
+        else if (header.isCompressed && header.blockShift == 0u)
+        {
+            auto decoder = new PKAssetStreamDecoder();
+            stream->decoder = decoder;
 
-        fclose(file);
-            
-        asset->rawData = buffer;
-        *(asset->header) = header;
+            if (BeginDecodeStream(&decoder->decoder, load.encodedSize, header.uncompressedSize - headerSize, header.streamCount) != 0)
+            {
+                CloseAssetStream(stream);
+                return -1;
+            }
+        }
+        else if (header.isCompressed)
+        {
+            auto blockCount = GetBlockCount(header.uncompressedSize - headerSize, header.blockShift);
+            stream->blockOffsets = static_cast<uint32_t*>(malloc(blockCount * sizeof(uint32_t)));
+
+            if (stream->blockOffsets == nullptr || ReadFileAt(file, stream->blockOffsets, blockCount * sizeof(uint32_t), GetAssetPayloadOffset(header)) != 0 ||
+                ValidateBufferBlocks(stream->blockOffsets, load.encodedSize, header.uncompressedSize - headerSize, header.blockShift) != 0)
+            {
+                CloseAssetStream(stream);
+                return -1;
+            }
+        }
 
         return 0;
     }
 
-    void CloseAsset(PKAsset* asset)
+    void CloseAssetStream(PKAssetStream* stream)
     {
-        if (asset->rawData != nullptr)
+        if (stream && stream->file != PK_ASSET_INVALID_FILE)
         {
-            free(asset->rawData);
+            CloseFileDescriptor(stream->file);
+            stream->file = PK_ASSET_INVALID_FILE;
         }
-    }
 
-
-    int OpenAssetStream(const char* filepath, PKAssetStream* stream)
-    {
-        size_t size = 0ull;
-        FILE* file = OpenFile(filepath, "rb", &size);
-        constexpr auto headerSize = sizeof(PKAssetHeader);
-
-        if (file == nullptr || size < headerSize)
+        if (stream && stream->blockOffsets)
         {
-            return -1;
+            free(stream->blockOffsets);
+            stream->blockOffsets = nullptr;
         }
 
-        fread(&stream->header, headerSize, 1, file);
-
-        if (stream->header.magicNumber != PK_ASSET_MAGIC_NUMBER)
+        if (stream && stream->filters)
         {
-            fclose(file);
-            return -1;
+            free(stream->filters);
+            stream->filters = nullptr;
         }
 
-        // Cant stream compressed files. yet.
-        if (stream->header.isCompressed)
+        if (stream && stream->sections)
         {
-            fclose(file);
-            return -1;
+            free(stream->sections);
+            stream->sections = nullptr;
         }
 
-        stream->stream = file;
-        return 0;
-    }
-
-    void CloseAssetStream(PKAssetStream* stream)
-    {
-        if (stream && stream->stream)
+        if (stream && stream->decoder)
         {
-            fclose(reinterpret_cast<FILE*>(stream->stream));
+            delete static_cast<PKAssetStreamDecoder*>(stream->decoder);
+            stream->decoder = nullptr;
         }
     }
 
@@ -181,16 +841,326 @@ namespace PKAssets
     }
 
 
+    // Header bytes of compressed files are served from the stream header. Returns the payload relative range that remains.
+    static bool StreamHeader(PKAssetStream* stream, uint8_t*& dst, size_t& offset, size_t& size)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+
+        if (offset < headerSize)
+        {
+            auto count = size < headerSize - offset ? size : headerSize - offset;
+            memcpy(dst, reinterpret_cast<const uint8_t*>(&stream->header) + offset, count);
+            dst += count;
+            offset += count;
+            size -= count;
+        }
+
+        offset -= headerSize;
+        return size > 0ull;
+    }
+
+    static int StreamBlocks(PKAssetStream* stream, uint8_t* dst, size_t offset, size_t size)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        const auto& header = stream->header;
+        auto payloadSize = (size_t)header.uncompressedSize - headerSize;
+
+        if (!StreamHeader(stream, dst, offset, size))
+        {
+            return 0;
+        }
+
+        if (offset + size > payloadSize)
+        {
+            return -1;
+        }
+
+        // Overlapping blocks are read with a single read into a block encoded buffer of their own.
+        auto firstBlock = offset >> header.blockShift;
+        auto lastBlock = (offset + size - 1ull) >> header.blockShift;
+        auto blockCount = lastBlock - firstBlock + 1ull;
+        auto blockCountTotal = GetBlockCount(payloadSize, header.blockShift);
+        auto encodedStart = firstBlock > 0ull ? stream->blockOffsets[firstBlock - 1ull] : 0u;
+        auto encodedSize = (size_t)stream->blockOffsets[lastBlock] - encodedStart;
+        auto tableSize = blockCount * sizeof(uint32_t);
+        auto encoded = static_cast<uint8_t*>(malloc(tableSize + encodedSize + 8ull));
+
+        if (encoded == nullptr)
+        {
+            return -1;
+        }
+
+        auto offsets = reinterpret_cast<uint32_t*>(encoded);
+
+        for (auto i = 0ull; i < blockCount; ++i)
+        {
+            offsets[i] = stream->blockOffsets[firstBlock + i] - encodedStart;
+        }
+
+        auto encodedOffset = GetAssetPayloadOffset(header) + blockCountTotal * sizeof(uint32_t) + encodedStart;
+        auto isRead = ReadFileAt(stream->file, encoded + tableSize, encodedSize, encodedOffset) == 0;
+
+        auto rangeOffset = firstBlock << header.blockShift;
+        auto rangeSize = payloadSize - rangeOffset < (blockCount << header.blockShift) ? payloadSize - rangeOffset : blockCount << header.blockShift;
+        auto result = isRead ? DecodeBufferRange(encoded, rangeSize, header.blockShift, header.codec, header.streamCount, header.encodeFlags, offset - rangeOffset, size, dst) : -1;
+        free(encoded);
+        return result;
+    }
+
+    // Each section overlapping the requested range is read as a whole & only its blocks covering the range are decoded.
+    static int StreamSections(PKAssetStream* stream, uint8_t* dst, size_t offset, size_t size)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        const auto& header = stream->header;
+        auto payloadOffset = GetAssetPayloadOffset(header);
+        auto result = 0;
+
+        if (!StreamHeader(stream, dst, offset, size))
+        {
+            return 0;
+        }
+
+        if (offset + size > (size_t)header.uncompressedSize - headerSize)
+        {
+            return -1;
+        }
+
+        for (auto i = 0u; i < header.sectionCount && result == 0; ++i)
+        {
+            const auto& section = stream->sections[i];
+            auto sectionFirst = (size_t)section.offset - headerSize;
+            auto sectionLast = sectionFirst + section.size;
+
+            if (sectionFirst >= offset + size || sectionLast <= offset)
+            {
+                continue;
+            }
+
+            auto first = offset > sectionFirst ? offset : sectionFirst;
+            auto last = offset + size < sectionLast ? offset + size : sectionLast;
+            auto encoded = static_cast<uint8_t*>(malloc(section.encodedSize + 8ull));
+            auto isRead = encoded != nullptr && ReadFileAt(stream->file, encoded, section.encodedSize, payloadOffset + section.encodedOffset) == 0;
+            isRead = isRead && ValidateBufferBlocks(encoded, section.encodedSize, section.size, header.blockShift) == 0;
+            result = isRead ? DecodeBufferRange(encoded, section.size, header.blockShift, header.codec, header.streamCount, header.encodeFlags, first - sectionFirst, last - first, dst + (first - offset)) : -1;
+            free(encoded);
+        }
+
+        return result;
+    }
+
+    // Requests behind the decoder position restart decoding from the start of the encoded payload.
+    // Skipped output is decoded into a scratch window, only the staged input & the decoder state are resident.
+    static int StreamSequential(PKAssetStream* stream, uint8_t* dst, size_t offset, size_t size)
+    {
+        const auto& header = stream->header;
+        auto streamDecoder = static_cast<PKAssetStreamDecoder*>(stream->decoder);
+        auto decoder = &streamDecoder->decoder;
+        auto encodedOffset = GetAssetPayloadOffset(header);
+
+        if (!StreamHeader(stream, dst, offset, size))
+        {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(streamDecoder->mutex);
+
+        if (offset + size > decoder->writeSize)
+        {
+            return -1;
+        }
+
+        if (offset < decoder->writeOffset && BeginDecodeStream(decoder, decoder->encodedSize, decoder->writeSize, decoder->streamCount) != 0)
+        {
+            return -1;
+        }
+
+        uint8_t chunk[4096];
+        uint8_t discard[4096];
+
+        while (decoder->writeOffset < offset + size)
+        {
+            auto isSkipping = decoder->writeOffset < offset;
+            auto window = isSkipping ? discard : dst + (decoder->writeOffset - offset);
+            auto windowSize = isSkipping ? offset - decoder->writeOffset : offset + size - decoder->writeOffset;
+            windowSize = isSkipping && windowSize > sizeof(discard) ? sizeof(discard) : windowSize;
+
+            if (DecodeStream(decoder, window, windowSize) > 0ull)
+            {
+                continue;
+            }
+
+            auto readSize = decoder->encodedSize - decoder->readSize < sizeof(chunk) ? decoder->encodedSize - decoder->readSize : sizeof(chunk);
+
+            // The decoder only stalls with less than one refill of input staged, so the chunk always fits.
+            if (readSize == 0ull || ReadFileAt(stream->file, chunk, readSize, encodedOffset + decoder->readSize) != 0 || FeedDecodeStream(decoder, chunk, readSize) != readSize)
+            {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    // Returns the group aligned part of a filter region that covers the requested range.
+    static bool GetFilterRange(const PKAssetFilter& filter, size_t offset, size_t size, size_t* outFirst, size_t* outLast)
+    {
+        auto filterEnd = (size_t)filter.offset + filter.size;
+
+        if (filter.offset >= offset + size || filterEnd <= offset)
+        {
+            return false;
+        }
+
+        auto groupSize = GetFilterGroupSize(filter.stride);
+        auto first = offset > filter.offset ? offset - filter.offset : 0ull;
+        auto last = offset + size < filterEnd ? offset + size - filter.offset : (size_t)filter.size;
+        last = ((last + groupSize - 1ull) / groupSize) * groupSize;
+        *outFirst = filter.offset + (first / groupSize) * groupSize;
+        *outLast = filter.offset + (last < filter.size ? last : (size_t)filter.size);
+        return true;
+    }
+
+    // Filtered regions are decoded in whole groups. The requested range is expanded to the groups it overlaps.
+    static int StreamFiltered(PKAssetStream* stream, uint8_t* dst, size_t offset, size_t size)
+    {
+        auto rangeFirst = offset;
+        auto rangeLast = offset + size;
+
+        for (auto i = 0u; i < stream->header.filterCount; ++i)
+        {
+            size_t first, last;
+
+            if (GetFilterRange(stream->filters[i], offset, size, &first, &last))
+            {
+                rangeFirst = first < rangeFirst ? first : rangeFirst;
+                rangeLast = last > rangeLast ? last : rangeLast;
+            }
+        }
+
+        // Requests that are already group aligned are decoded directly into the destination.
+        auto isAligned = rangeFirst == offset && rangeLast == offset + size;
+        auto scratch = isAligned ? dst : static_cast<uint8_t*>(malloc(rangeLast - rangeFirst));
+        auto result = scratch == nullptr ? -1 : stream->decoder != nullptr ? 
+            StreamSequential(stream, scratch, rangeFirst, rangeLast - rangeFirst) : 
+            StreamBlocks(stream, scratch, rangeFirst, rangeLast - rangeFirst);
+
+        for (auto i = 0u; i < stream->header.filterCount && result == 0; ++i)
+        {
+            size_t first, last;
+
+            if (GetFilterRange(stream->filters[i], offset, size, &first, &last))
+            {
+                const auto& filter = stream->filters[i];
+                result = DecodeFilter(scratch + (first - rangeFirst), last - first, filter.stride, filter.flags);
+            }
+        }
+
+        if (!isAligned && result == 0)
+        {
+            memcpy(dst, scratch + (offset - rangeFirst), size);
+        }
+
+        if (!isAligned)
+        {
+            free(scratch);
+        }
+
+        return result;
+    }
+
     int StreamData(PKAssetStream* stream, void* dst, size_t offset, size_t size)
     {
-        auto seekret = fseek(reinterpret_cast<FILE*>(stream->stream), (long)offset, SEEK_SET);
-        auto readret = fread(dst, size, 1u, reinterpret_cast<FILE*>(stream->stream));
-        return seekret == 0 && readret != 0 ? 0 : -1;
+        if (stream->filters != nullptr)
+        {
+            return StreamFiltered(stream, static_cast<uint8_t*>(dst), offset, size);
+        }
+
+        if (stream->sections != nullptr)
+        {
+            return StreamSections(stream, static_cast<uint8_t*>(dst), offset, size);
+        }
+
+        if (stream->blockOffsets != nullptr)
+        {
+            return StreamBlocks(stream, static_cast<uint8_t*>(dst), offset, size);
+        }
+
+        if (stream->decoder != nullptr)
+        {
+            return StreamSequential(stream, static_cast<uint8_t*>(dst), offset, size);
+        }
+
+        return ReadFileAt(stream->file, dst, size, offset);
+    }
+
+    int StreamDataMulti(PKAssetStream* stream, const PKAssetStreamRange* ranges, uint32_t count)
+    {
+        if (count == 0u)
+        {
+            return 0;
+        }
+
+        auto order = ranges != nullptr ? static_cast<uint32_t*>(malloc(count * sizeof(uint32_t))) : nullptr;
+
+        if (order == nullptr)
+        {
+            return -1;
+        }
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            order[i] = i;
+        }
+
+        // Ranges are streamed in file order so that sequential streams never restart & shared blocks are decoded once.
+        std::sort(order, order + count, [ranges](uint32_t a, uint32_t b) { return ranges[a].offset < ranges[b].offset; });
+        auto result = 0;
+
+        for (auto first = 0u; first < count && result == 0;)
+        {
+            const auto& head = ranges[order[first]];
+            auto runFirst = head.offset;
+            auto runLast = head.offset + head.size;
+            auto isContiguous = true;
+            auto last = first + 1u;
+
+            for (; last < count && ranges[order[last]].offset <= runLast + PK_ASSET_STREAM_COALESCE_GAP; ++last)
+            {
+                const auto& range = ranges[order[last]];
+                const auto& previous = ranges[order[last - 1u]];
+                isContiguous = isContiguous && range.offset == runLast && static_cast<uint8_t*>(previous.dst) + previous.size == range.dst;
+                runLast = range.offset + range.size > runLast ? range.offset + range.size : runLast;
+            }
+
+            // Runs that are contiguous in both the file & memory are streamed directly. Others go through a scratch buffer.
+            if (isContiguous)
+            {
+                result = StreamData(stream, head.dst, runFirst, runLast - runFirst);
+            }
+            else
+            {
+                auto scratch = static_cast<uint8_t*>(malloc(runLast - runFirst));
+                result = scratch != nullptr ? StreamData(stream, scratch, runFirst, runLast - runFirst) : -1;
+
+                for (auto i = first; i < last && result == 0; ++i)
+                {
+                    const auto& range = ranges[order[i]];
+                    memcpy(range.dst, scratch + (range.offset - runFirst), range.size);
+                }
+
+                free(scratch);
+            }
+
+            first = last;
+        }
+
+        free(order);
+        return result;
     }
 
     int StreamAsShader(PKAssetStream* stream, PKShader* outvalue)
     {
-        if (stream->stream == nullptr || stream->header.type != PKAssetType::Shader)
+        if (stream->file == PK_ASSET_INVALID_FILE || stream->header.type != PKAssetType::Shader)
         {
             return -1;
         }
@@ -200,7 +1170,7 @@ namespace PKAssets
 
     int StreamAsMesh(PKAssetStream* stream, PKMesh* outvalue)
     {
-        if (stream->stream == nullptr || stream->header.type != PKAssetType::Mesh)
+        if (stream->file == PK_ASSET_INVALID_FILE || stream->header.type != PKAssetType::Mesh)
         {
             return -1;
         }
@@ -210,7 +1180,7 @@ namespace PKAssets
 
     int StreamAsFont(PKAssetStream* stream, PKFont* outvalue)
     {
-        if (stream->stream == nullptr || stream->header.type != PKAssetType::Font)
+        if (stream->file == PK_ASSET_INVALID_FILE || stream->header.type != PKAssetType::Font)
         {
             return -1;
         }
@@ -220,7 +1190,7 @@ namespace PKAssets
 
     int StreamAsTexture(PKAssetStream* stream, PKTexture* outvalue)
     {
-        if (stream->stream == nullptr || stream->header.type != PKAssetType::Texture)
+        if (stream->file == PK_ASSET_INVALID_FILE || stream->header.type != PKAssetType::Texture)
         {
             return -1;
         }
@@ -228,6 +1198,110 @@ namespace PKAssets
         return StreamData(stream, outvalue, sizeof(PKAssetHeader), sizeof(PKTexture));
     }
 
+    // Levels may be stored in either order. A level ends at the next larger level offset or at the end of the data.
+    static size_t GetTextureLevelEnd(const uint32_t* levelOffsets, uint32_t levelCount, uint32_t level, size_t dataSize)
+    {
+        auto end = dataSize;
+
+        for (auto i = 0u; i < levelCount; ++i)
+        {
+            end = levelOffsets[i] > levelOffsets[level] && levelOffsets[i] < end ? levelOffsets[i] : end;
+        }
+
+        return end;
+    }
+
+    int OpenTextureLevels(const char* filepath, uint32_t firstLevel, uint32_t lastLevel, PKAsset* asset)
+    {
+        constexpr auto headerSize = sizeof(PKAssetHeader);
+        PKAssetStream stream{};
+        PKTexture texture;
+
+        if (OpenAssetStream(filepath, &stream) != 0)
+        {
+            return -1;
+        }
+
+        if (StreamAsTexture(&stream, &texture) != 0 || firstLevel > lastLevel || lastLevel >= texture.levels)
+        {
+            CloseAssetStream(&stream);
+            return -1;
+        }
+
+        auto levelOffsets = static_cast<uint32_t*>(malloc(texture.levels * sizeof(uint32_t)));
+
+        if (levelOffsets == nullptr || StreamData(&stream, levelOffsets, texture.levelOffsets.offset, texture.levels * sizeof(uint32_t)) != 0)
+        {
+            free(levelOffsets);
+            CloseAssetStream(&stream);
+            return -1;
+        }
+
+        // Consecutive levels are adjacent in either order, so the requested levels are a single byte range.
+        auto rangeFirst = (size_t)texture.dataSize;
+        auto rangeLast = 0ull;
+
+        for (auto level = firstLevel; level <= lastLevel; ++level)
+        {
+            auto levelEnd = GetTextureLevelEnd(levelOffsets, texture.levels, level, texture.dataSize);
+            rangeFirst = levelOffsets[level] < rangeFirst ? levelOffsets[level] : rangeFirst;
+            rangeLast = levelEnd > rangeLast ? levelEnd : rangeLast;
+        }
+
+        // The loaded texture is laid out as header, texture, level offsets & the level data aligned to 16 bytes.
+        auto levelCount = lastLevel - firstLevel + 1u;
+        auto offsetsOffset = headerSize + sizeof(PKTexture);
+        auto dataOffset = (offsetsOffset + levelCount * sizeof(uint32_t) + 15ull) & ~15ull;
+        auto bufferSize = dataOffset + (rangeLast - rangeFirst);
+        auto buffer = rangeFirst < rangeLast ? static_cast<uint8_t*>(malloc(bufferSize)) : nullptr;
+
+        if (buffer == nullptr || StreamData(&stream, buffer + dataOffset, texture.data.offset + rangeFirst, rangeLast - rangeFirst) != 0)
+        {
+            free(buffer);
+            free(levelOffsets);
+            CloseAssetStream(&stream);
+            return -1;
+        }
+
+        auto header = reinterpret_cast<PKAssetHeader*>(buffer);
+        *header = stream.header;
+        header->isCompressed = false;
+        header->decodePadding = 0u;
+        header->uncompressedSize = (uint32_t)bufferSize;
+        header->streamCount = 1u;
+        header->blockShift = 0u;
+        header->encodeFlags = 0u;
+        header->filterCount = 0u;
+        header->codec = 0u;
+        header->sectionCount = 0u;
+
+        for (auto i = 0u; i < 3u; ++i)
+        {
+            auto resolution = firstLevel < 16u ? (uint32_t)texture.resolution[i] >> firstLevel : 0u;
+            texture.resolution[i] = resolution > 0u ? (uint16_t)resolution : 1u;
+        }
+
+        texture.levels = (uint16_t)levelCount;
+        texture.dataSize = (uint32_t)(rangeLast - rangeFirst);
+        texture.data.offset = (uint32_t)dataOffset;
+        texture.levelOffsets.offset = (uint32_t)offsetsOffset;
+        memcpy(buffer + headerSize, &texture, sizeof(PKTexture));
+
+        for (auto i = 0u; i < levelCount; ++i)
+        {
+            auto levelOffset = (uint32_t)(levelOffsets[firstLevel + i] - rangeFirst);
+            memcpy(buffer + offsetsOffset + i * sizeof(uint32_t), &levelOffset, sizeof(uint32_t));
+        }
+
+        free(levelOffsets);
+        CloseAssetStream(&stream);
+        asset->rawData = buffer;
+        asset->mappedSize = 0ull;
+        asset->allocator = nullptr;
+        asset->isExternal = false;
+        return 0;
+    }
+
 
     PKAssetMeta OpenAssetMeta(const char* filepath)
     {
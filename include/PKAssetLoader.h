@@ -3,9 +3,61 @@
 
 namespace PKAssets
 {
-    int OpenAsset(const char* filepath, PKAsset* asset);
+    constexpr static const uint32_t PK_ASSET_MAP_ADVICE_NORMAL = 0u;
+    constexpr static const uint32_t PK_ASSET_MAP_ADVICE_SEQUENTIAL = 1u << 0u;
+    constexpr static const uint32_t PK_ASSET_MAP_ADVICE_RANDOM = 1u << 1u;
+    constexpr static const uint32_t PK_ASSET_MAP_ADVICE_WILLNEED = 1u << 2u;
+    constexpr static const size_t PK_ASSET_LOAD_HEAD_SIZE = sizeof(PKAssetHeader) + PK_ASSET_MAX_FILTERS * sizeof(PKAssetFilter) + PK_ASSET_MAX_SECTIONS * sizeof(PKAssetSection);
+
+    // OpenAsset split into stages so that file I/O & decoding can run on separate threads.
+    // BeginAssetLoad reads the header & reports the memory required by the load. ReadAssetLoad performs the remaining file I/O.
+    // DecodeAssetLoad only does CPU work. Loads that are not decoded must be released with CancelAssetLoad.
+    struct PKAssetLoad
+    {
+        void* file = nullptr;
+        const PKAssetAllocator* allocator = nullptr;
+        uint8_t* destination = nullptr;
+        size_t destinationSize = 0ull;
+        uint8_t* buffer = nullptr;
+        uint8_t* encoded = nullptr;
+        size_t encodedSize = 0ull;
+        size_t bufferSize = 0ull;
+        size_t memorySize = 0ull;
+        PKAssetHeader header;
+        PKAssetFilter filters[PK_ASSET_MAX_FILTERS];
+        PKAssetSection sections[PK_ASSET_MAX_SECTIONS];
+    };
+
+    // 64-bit FNV-1a hash of an asset path.
+    uint64_t GetAssetNameHash(const char* name);
+
+    // Offset of the encoded payload in an asset file. The filter & section tables are stored between the header & the payload.
+    size_t GetAssetPayloadOffset(const PKAssetHeader& header);
+
+    int BeginAssetLoad(const char* filepath, PKAssetLoad* load);
+    // Begins a load from the start of a file that has already been read by the caller. The head must contain the header & filter table.
+    // The remaining contents are read by the caller to the destination returned by AllocateAssetLoad, which starts after the filter table.
+    int BeginAssetLoad(const void* head, size_t headSize, size_t fileSize, PKAssetLoad* load);
+    uint8_t* AllocateAssetLoad(PKAssetLoad* load, size_t* outReadSize);
+    int ReadAssetLoad(PKAssetLoad* load);
+    int DecodeAssetLoad(PKAssetLoad* load, PKAsset* asset, uint32_t threadCount);
+    void CancelAssetLoad(PKAssetLoad* load);
+
+    // Loads allocate the asset & the scratch memory of block encoded payloads from the allocator when one is given.
+    // A destination buffer can be set on a load before it is read, the asset is then decoded into it. Destinations must hold GetAssetDecodeSize bytes.
+    int OpenAsset(const char* filepath, PKAsset* asset, const PKAssetAllocator* allocator = nullptr);
     void CloseAsset(PKAsset* asset);
 
+    // Reads only the header of an asset. Sizes a destination for OpenAssetInto.
+    int ProbeAsset(const char* filepath, PKAssetHeader* outHeader);
+    size_t GetAssetDecodeSize(const PKAssetHeader& header);
+    int OpenAssetInto(const char* filepath, void* dst, size_t dstSize, PKAsset* asset, const PKAssetAllocator* allocator = nullptr);
+
+    // Uncompressed assets are mapped read only & used in place. The page cache is shared between processes loading the same file.
+    // Compressed assets can't be used from the mapping & fall back to OpenAsset. Both are released with CloseAsset.
+    int OpenAssetMapped(const char* filepath, PKAsset* asset, uint32_t advice = PK_ASSET_MAP_ADVICE_NORMAL);
+    int AdviseAsset(PKAsset* asset, size_t offset, size_t size, uint32_t advice);
+
     int OpenAssetStream(const char* filepath, PKAssetStream* stream);
     void CloseAssetStream(PKAssetStream* stream);
 
@@ -14,7 +66,25 @@ namespace PKAssets
     PKFont* ReadAsFont(PKAsset* asset);
     PKTexture* ReadAsTexture(PKAsset* asset);
 
+    // Loads a texture with only the levels [firstLevel, lastLevel] resident. Only the byte ranges of those levels are read & decoded.
+    // The returned texture describes the loaded range, level 0 of it being firstLevel of the source texture. Released with CloseAsset.
+    int OpenTextureLevels(const char* filepath, uint32_t firstLevel, uint32_t lastLevel, PKAsset* asset);
+
+    // Streamed ranges are relative to the start of the decoded asset. Streams can be read from several threads at once.
     int StreamData(PKAssetStream* stream, void* dst, size_t offset, size_t size);
+
+    // Ranges closer to each other than this are read & decoded as a single range.
+    constexpr static const size_t PK_ASSET_STREAM_COALESCE_GAP = 4096ull;
+
+    struct PKAssetStreamRange
+    {
+        size_t offset = 0ull;
+        size_t size = 0ull;
+        void* dst = nullptr;
+    };
+
+    // Streams a list of ranges in any order. Ranges are sorted by offset & coalesced so that adjacent ranges share their reads & decoded blocks.
+    int StreamDataMulti(PKAssetStream* stream, const PKAssetStreamRange* ranges, uint32_t count);
     int StreamAsShader(PKAssetStream* stream, PKShader* outvalue);
     int StreamAsMesh(PKAssetStream* stream, PKMesh* outvalue);
     int StreamAsFont(PKAssetStream* stream, PKFont* outvalue);
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <string.h>
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "PKAssetPack.h"
+
+namespace PKAssets
+{
+    static size_t GetAssetPackEntriesOffset(uint32_t bucketBits)
+    {
+        auto bucketsEnd = sizeof(PKAssetPackHeader) + ((1ull << bucketBits) + 1ull) * sizeof(uint32_t);
+        return (bucketsEnd + alignof(PKAssetPackEntry) - 1ull) & ~(alignof(PKAssetPackEntry) - 1ull);
+    }
+
+    size_t GetAssetPackTableSize(uint32_t entryCount, uint32_t bucketBits, uint32_t namesSize)
+    {
+        return GetAssetPackEntriesOffset(bucketBits) + entryCount * sizeof(PKAssetPackEntry) + namesSize;
+    }
+
+    static int ValidateAssetPack(const PKAssetPack* pack)
+    {
+        const auto& header = *pack->header;
+        auto bucketCount = 1u << header.bucketBits;
+
+        if (pack->buckets[0] != 0u || pack->buckets[bucketCount] != header.entryCount || (header.namesSize > 0u && pack->names[header.namesSize - 1u] != 0))
+        {
+            return -1;
+        }
+
+        for (auto i = 0u; i < bucketCount; ++i)
+        {
+            if (pack->buckets[i] > pack->buckets[i + 1u])
+            {
+                return -1;
+            }
+        }
+
+        for (auto i = 0u; i < header.entryCount; ++i)
+        {
+            const auto& entry = pack->entries[i];
+
+            if (entry.nameOffset >= header.namesSize || entry.offset > pack->mappedSize || entry.size > pack->mappedSize - entry.offset || (entry.offset % PK_ASSET_PACK_ALIGNMENT) != 0ull)
+            {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    int OpenAssetPack(const char* filepath, PKAssetPack* pack)
+    {
+        if (filepath == nullptr)
+        {
+            return -1;
+        }
+
+        void* mapping = nullptr;
+        size_t size = 0ull;
+
+#if _WIN32
+        auto fileHandle = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER fileSize;
+
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            return -1;
+        }
+
+        if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart >= (LONGLONG)sizeof(PKAssetPackHeader))
+        {
+            // The view keeps the mapping alive. Both handles can be closed once it is created.
+            auto mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+            mapping = mappingHandle != nullptr ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0u, 0u, 0u) : nullptr;
+            size = (size_t)fileSize.QuadPart;
+
+            if (mappingHandle != nullptr)
+            {
+                CloseHandle(mappingHandle);
+            }
+        }
+
+        CloseHandle(fileHandle);
+#else
+        auto fileDescriptor = open(filepath, O_RDONLY | O_CLOEXEC);
+        struct stat filestat;
+
+        if (fileDescriptor < 0)
+        {
+            return -1;
+        }
+
+        if (fstat(fileDescriptor, &filestat) == 0 && filestat.st_size >= (off_t)sizeof(PKAssetPackHeader))
+        {
+            size = (size_t)filestat.st_size;
+            mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+            mapping = mapping != MAP_FAILED ? mapping : nullptr;
+        }
+
+        close(fileDescriptor);
+#endif
+
+        if (mapping == nullptr)
+        {
+            return -1;
+        }
+
+        pack->mapping = static_cast<const uint8_t*>(mapping);
+        pack->mappedSize = size;
+        pack->header = reinterpret_cast<const PKAssetPackHeader*>(mapping);
+
+        const auto& header = *pack->header;
+        auto isValid = header.magicNumber == PK_ASSET_PACK_MAGIC_NUMBER && header.version == PK_ASSET_PACK_VERSION && header.size == size && header.bucketBits <= PK_ASSET_PACK_MAX_BUCKET_BITS;
+        isValid = isValid && GetAssetPackTableSize(header.entryCount, header.bucketBits, header.namesSize) <= size;
+
+        if (isValid)
+        {
+            auto entriesOffset = GetAssetPackEntriesOffset(header.bucketBits);
+            pack->buckets = reinterpret_cast<const uint32_t*>(pack->mapping + sizeof(PKAssetPackHeader));
+            pack->entries = reinterpret_cast<const PKAssetPackEntry*>(pack->mapping + entriesOffset);
+            pack->names = reinterpret_cast<const char*>(pack->mapping + entriesOffset + header.entryCount * sizeof(PKAssetPackEntry));
+        }
+
+        if (!isValid || ValidateAssetPack(pack) != 0)
+        {
+            CloseAssetPack(pack);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    void CloseAssetPack(PKAssetPack* pack)
+    {
+        if (pack->mapping != nullptr)
+        {
+#if _WIN32
+            UnmapViewOfFile(pack->mapping);
+#else
+            munmap(const_cast<uint8_t*>(pack->mapping), pack->mappedSize);
+#endif
+        }
+
+        *pack = PKAssetPack();
+    }
+
+    const PKAssetPackEntry* FindPackEntry(const PKAssetPack* pack, const char* name)
+    {
+        if (pack->header == nullptr || name == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The top bits of the hash select a bucket. Buckets hold about one entry, so lookups are constant time.
+        auto hash = GetAssetNameHash(name);
+        auto bucket = pack->header->bucketBits > 0u ? (uint32_t)(hash >> (64u - pack->header->bucketBits)) : 0u;
+
+        for (auto i = pack->buckets[bucket]; i < pack->buckets[bucket + 1u] && pack->entries[i].nameHash <= hash; ++i)
+        {
+            const auto& entry = pack->entries[i];
+
+            if (entry.nameHash == hash && strcmp(pack->names + entry.nameOffset, name) == 0)
+            {
+                return &entry;
+            }
+        }
+
+        return nullptr;
+    }
+
+    int OpenPackAsset(const PKAssetPack* pack, const PKAssetPackEntry* entry, PKAsset* asset, const PKAssetAllocator* allocator)
+    {
+        if (pack->mapping == nullptr || entry == nullptr || entry->size < sizeof(PKAssetHeader))
+        {
+            return -1;
+        }
+
+        auto data = pack->mapping + entry->offset;
+        auto header = reinterpret_cast<const PKAssetHeader*>(data);
+
+        if (header->magicNumber != PK_ASSET_MAGIC_NUMBER)
+        {
+            return -1;
+        }
+
+        if (!header->isCompressed)
+        {
+            if (header->uncompressedSize > entry->size || header->filterCount > 0u || header->sectionCount > 0u)
+            {
+                return -1;
+            }
+
+            asset->rawData = const_cast<uint8_t*>(data);
+            asset->mappedSize = 0ull;
+            asset->allocator = nullptr;
+            asset->isExternal = true;
+            return 0;
+        }
+
+        // Compressed entries go through the staged load path with the mapping as their file.
+        PKAssetLoad load;
+        load.allocator = allocator;
+        auto headSize = entry->size < PK_ASSET_LOAD_HEAD_SIZE ? (size_t)entry->size : PK_ASSET_LOAD_HEAD_SIZE;
+
+        if (BeginAssetLoad(data, headSize, entry->size, &load) != 0)
+        {
+            return -1;
+        }
+
+        size_t readSize = 0ull;
+        auto destination = AllocateAssetLoad(&load, &readSize);
+        auto payloadOffset = GetAssetPayloadOffset(load.header);
+
+        if (destination == nullptr || payloadOffset + readSize > entry->size)
+        {
+            CancelAssetLoad(&load);
+            return -1;
+        }
+
+        memcpy(destination, data + payloadOffset, readSize);
+        return DecodeAssetLoad(&load, asset, 0u);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "PKAssetLoader.h"
+
+namespace PKAssets
+{
+    constexpr static const uint64_t PK_ASSET_PACK_MAGIC_NUMBER = 0x31304B4341504B50ull;
+    constexpr static const uint32_t PK_ASSET_PACK_VERSION = 1u;
+    // Entries start at multiples of the alignment so that assets used in place from the mapping keep their alignment.
+    constexpr static const uint32_t PK_ASSET_PACK_ALIGNMENT = 64u;
+    constexpr static const uint32_t PK_ASSET_PACK_MAX_BUCKET_BITS = 24u;
+    constexpr static const char* PK_ASSET_EXTENSION_PACK = ".pkpack";
+
+    constexpr static const uint32_t PK_ASSET_PACK_ENTRY_FLAG_COMPRESSED = 1u << 0u;
+    constexpr static const uint32_t PK_ASSET_PACK_ENTRY_FLAG_BLOCKED = 1u << 1u;
+
+    // Layout: header, bucket table, entries, names & the aligned asset files.
+    // Entries are sorted by name hash. Bucket i holds the entries [buckets[i], buckets[i + 1]) whose hashes start with the bits of i.
+    struct alignas(8) PKAssetPackHeader
+    {
+        uint64_t magicNumber = PK_ASSET_PACK_MAGIC_NUMBER;
+        uint64_t size = 0ull;
+        uint32_t version = PK_ASSET_PACK_VERSION;
+        uint32_t entryCount = 0u;
+        uint32_t bucketBits = 0u;
+        uint32_t namesSize = 0u;
+    };
+
+    // Entries contain unmodified cooked asset files. Names are paths relative to the packed directory with '/' separators.
+    struct alignas(8) PKAssetPackEntry
+    {
+        uint64_t nameHash = 0ull;
+        uint64_t offset = 0ull;
+        uint64_t size = 0ull;
+        uint32_t nameOffset = 0u;
+        uint32_t flags = 0u;
+    };
+
+    // The pack is mapped read only once. Lookups & loads don't touch the file system.
+    struct PKAssetPack
+    {
+        const uint8_t* mapping = nullptr;
+        size_t mappedSize = 0ull;
+        const PKAssetPackHeader* header = nullptr;
+        const uint32_t* buckets = nullptr;
+        const PKAssetPackEntry* entries = nullptr;
+        const char* names = nullptr;
+    };
+
+    size_t GetAssetPackTableSize(uint32_t entryCount, uint32_t bucketBits, uint32_t namesSize);
+
+    int OpenAssetPack(const char* filepath, PKAssetPack* pack);
+    void CloseAssetPack(PKAssetPack* pack);
+
+    // Returns nullptr when the pack has no entry of the given name.
+    const PKAssetPackEntry* FindPackEntry(const PKAssetPack* pack, const char* name);
+
+    // Uncompressed entries are used in place from the mapping & stay valid until the pack is closed.
+    // Compressed entries are decoded into memory from the allocator when one is given. Both are released with CloseAsset.
+    int OpenPackAsset(const PKAssetPack* pack, const PKAssetPackEntry* entry, PKAsset* asset, const PKAssetAllocator* allocator = nullptr);
+}
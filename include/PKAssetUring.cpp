@@ -0,0 +1,397 @@
+#include "PKAssetUring.h"
+
+#if PK_ASSET_IO_URING
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace PKAssets
+{
+#if PK_ASSET_IO_URING
+    // Each file uses up to 4 submission entries. Open, read & close are linked, stat runs independently.
+    constexpr static const uint32_t PK_ASSET_URING_ENTRIES = PK_ASSET_URING_BATCH_SIZE * 4u;
+    constexpr static const uint64_t PK_ASSET_URING_OP_OPEN = 0ull;
+    constexpr static const uint64_t PK_ASSET_URING_OP_READ = 1ull;
+    constexpr static const uint64_t PK_ASSET_URING_OP_CLOSE = 2ull;
+    constexpr static const uint64_t PK_ASSET_URING_OP_STAT = 3ull;
+
+    struct PKAssetUringSlot
+    {
+        const char* filepath = nullptr;
+        struct statx stat;
+        int32_t openResult = 0;
+        int32_t readResult = 0;
+        int32_t statResult = 0;
+        uint32_t stagedSize = 0u;
+    };
+
+    struct PKAssetUring
+    {
+        int fd = -1;
+        uint8_t* ringMemory = nullptr;
+        size_t ringSize = 0ull;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqesSize = 0ull;
+        uint32_t* sqTail = nullptr;
+        uint32_t* sqArray = nullptr;
+        uint32_t sqMask = 0u;
+        uint32_t sqLocalTail = 0u;
+        uint32_t* cqHead = nullptr;
+        uint32_t* cqTail = nullptr;
+        uint32_t cqMask = 0u;
+        io_uring_cqe* cqes = nullptr;
+        uint8_t* staging = nullptr;
+        size_t stagingSize = 0ull;
+        PKAssetUringSlot slots[PK_ASSET_URING_BATCH_SIZE];
+    };
+
+    static int SetupRing(uint32_t entries, io_uring_params* params)
+    {
+        return (int)syscall(__NR_io_uring_setup, entries, params);
+    }
+
+    static int EnterRing(int fd, uint32_t submitCount, uint32_t waitCount)
+    {
+        return (int)syscall(__NR_io_uring_enter, fd, submitCount, waitCount, IORING_ENTER_GETEVENTS, nullptr, 0ull);
+    }
+
+    static int RegisterRing(int fd, uint32_t opcode, const void* arg, uint32_t count)
+    {
+        return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+    }
+
+    static io_uring_sqe* GetSubmission(PKAssetUring* ring, uint8_t opcode, uint32_t slot, uint64_t op)
+    {
+        auto index = ring->sqLocalTail++ & ring->sqMask;
+        auto sqe = ring->sqes + index;
+        memset(sqe, 0, sizeof(io_uring_sqe));
+        sqe->opcode = opcode;
+        sqe->user_data = ((uint64_t)slot << 8ull) | op;
+        ring->sqArray[index] = index;
+        return sqe;
+    }
+
+    static void SubmitOpen(PKAssetUring* ring, uint32_t slot)
+    {
+        auto sqe = GetSubmission(ring, IORING_OP_OPENAT, slot, PK_ASSET_URING_OP_OPEN);
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uint64_t)ring->slots[slot].filepath;
+        // Direct descriptors never enter the process file table. The kernel rejects O_CLOEXEC for them.
+        sqe->open_flags = O_RDONLY;
+        sqe->file_index = slot + 1u;
+        sqe->flags = IOSQE_IO_LINK;
+    }
+
+    // Reads are hard linked so that the close runs even when a read comes up short.
+    static void SubmitRead(PKAssetUring* ring, uint32_t slot, void* dst, uint32_t size, uint64_t offset, bool isFixed)
+    {
+        auto sqe = GetSubmission(ring, isFixed ? IORING_OP_READ_FIXED : IORING_OP_READ, slot, PK_ASSET_URING_OP_READ);
+        sqe->fd = (int32_t)slot;
+        sqe->addr = (uint64_t)dst;
+        sqe->len = size;
+        sqe->off = offset;
+        sqe->buf_index = 0u;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    }
+
+    static void SubmitClose(PKAssetUring* ring, uint32_t slot)
+    {
+        auto sqe = GetSubmission(ring, IORING_OP_CLOSE, slot, PK_ASSET_URING_OP_CLOSE);
+        sqe->file_index = slot + 1u;
+    }
+
+    static void SubmitStat(PKAssetUring* ring, uint32_t slot)
+    {
+        auto sqe = GetSubmission(ring, IORING_OP_STATX, slot, PK_ASSET_URING_OP_STAT);
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uint64_t)ring->slots[slot].filepath;
+        sqe->len = STATX_SIZE;
+        sqe->addr2 = (uint64_t)&ring->slots[slot].stat;
+    }
+
+    // Submits all queued entries & waits for every one of them to complete. Each entry posts exactly one completion, including cancelled links.
+    static int SubmitAndWait(PKAssetUring* ring, uint32_t count)
+    {
+        __atomic_store_n(ring->sqTail, ring->sqLocalTail, __ATOMIC_RELEASE);
+        auto submitted = 0u;
+        auto completed = 0u;
+
+        while (completed < count)
+        {
+            // The kernel returns without waiting when only part of the entries could be submitted.
+            auto result = EnterRing(ring->fd, count - submitted, count - completed);
+
+            if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                return -1;
+            }
+
+            submitted += result > 0 ? (uint32_t)result : 0u;
+
+            auto head = *ring->cqHead;
+            auto tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+            for (; head != tail; ++head, ++completed)
+            {
+                auto cqe = ring->cqes + (head & ring->cqMask);
+                auto& slot = ring->slots[cqe->user_data >> 8ull];
+
+                switch (cqe->user_data & 0xFFull)
+                {
+                    case PK_ASSET_URING_OP_OPEN: slot.openResult = cqe->res; break;
+                    case PK_ASSET_URING_OP_READ: slot.readResult = cqe->res; break;
+                    case PK_ASSET_URING_OP_STAT: slot.statResult = cqe->res; break;
+                    default: break;
+                }
+            }
+
+            __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+        }
+
+        return 0;
+    }
+
+    PKAssetUring* CreateAssetUring()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        auto ring = new PKAssetUring();
+        ring->fd = SetupRing(PK_ASSET_URING_ENTRIES, &params);
+
+        // Linked reads of files opened in the same submission require the file to be resolved when the read is issued.
+        if (ring->fd < 0 || (params.features & IORING_FEAT_SINGLE_MMAP) == 0u || (params.features & IORING_FEAT_LINKED_FILE) == 0u)
+        {
+            DestroyAssetUring(ring);
+            return nullptr;
+        }
+
+        auto sqSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        auto cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        ring->ringSize = sqSize > cqSize ? sqSize : cqSize;
+        ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring->stagingSize = (size_t)PK_ASSET_URING_BATCH_SIZE * PK_ASSET_URING_STAGING_SIZE;
+
+        auto ringMemory = mmap(nullptr, ring->ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+        auto sqes = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+        auto staging = mmap(nullptr, ring->stagingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        ring->ringMemory = ringMemory != MAP_FAILED ? static_cast<uint8_t*>(ringMemory) : nullptr;
+        ring->sqes = sqes != MAP_FAILED ? static_cast<io_uring_sqe*>(sqes) : nullptr;
+        ring->staging = staging != MAP_FAILED ? static_cast<uint8_t*>(staging) : nullptr;
+
+        if (ring->ringMemory == nullptr || ring->sqes == nullptr || ring->staging == nullptr)
+        {
+            DestroyAssetUring(ring);
+            return nullptr;
+        }
+
+        ring->sqTail = reinterpret_cast<uint32_t*>(ring->ringMemory + params.sq_off.tail);
+        ring->sqArray = reinterpret_cast<uint32_t*>(ring->ringMemory + params.sq_off.array);
+        ring->sqMask = *reinterpret_cast<uint32_t*>(ring->ringMemory + params.sq_off.ring_mask);
+        ring->sqLocalTail = *ring->sqTail;
+        ring->cqHead = reinterpret_cast<uint32_t*>(ring->ringMemory + params.cq_off.head);
+        ring->cqTail = reinterpret_cast<uint32_t*>(ring->ringMemory + params.cq_off.tail);
+        ring->cqMask = *reinterpret_cast<uint32_t*>(ring->ringMemory + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(ring->ringMemory + params.cq_off.cqes);
+
+        // Sparse file table for direct descriptors & a single registered buffer shared by the staging slots.
+        int files[PK_ASSET_URING_BATCH_SIZE];
+        iovec buffer = { ring->staging, ring->stagingSize };
+
+        for (auto i = 0u; i < PK_ASSET_URING_BATCH_SIZE; ++i)
+        {
+            files[i] = -1;
+        }
+
+        if (RegisterRing(ring->fd, IORING_REGISTER_FILES, files, PK_ASSET_URING_BATCH_SIZE) != 0 || RegisterRing(ring->fd, IORING_REGISTER_BUFFERS, &buffer, 1u) != 0)
+        {
+            DestroyAssetUring(ring);
+            return nullptr;
+        }
+
+        return ring;
+    }
+
+    void DestroyAssetUring(PKAssetUring* ring)
+    {
+        if (ring == nullptr)
+        {
+            return;
+        }
+
+        if (ring->staging != nullptr)
+        {
+            munmap(ring->staging, ring->stagingSize);
+        }
+
+        if (ring->sqes != nullptr)
+        {
+            munmap(ring->sqes, ring->sqesSize);
+        }
+
+        if (ring->ringMemory != nullptr)
+        {
+            munmap(ring->ringMemory, ring->ringSize);
+        }
+
+        // Closing the ring releases the registered files & buffers.
+        if (ring->fd >= 0)
+        {
+            close(ring->fd);
+        }
+
+        delete ring;
+    }
+
+    int BeginAssetLoadsUring(PKAssetUring* ring, const char* const* filepaths, PKAssetLoad* const* loads, int* results, uint32_t count)
+    {
+        if (ring == nullptr || count > PK_ASSET_URING_BATCH_SIZE)
+        {
+            return -1;
+        }
+
+        auto entryCount = 0u;
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            auto& slot = ring->slots[i];
+            slot.filepath = filepaths[i];
+            slot.openResult = -ECANCELED;
+            slot.readResult = -ECANCELED;
+            slot.statResult = -ECANCELED;
+            slot.stagedSize = 0u;
+
+            if (slot.filepath != nullptr)
+            {
+                SubmitOpen(ring, i);
+                SubmitRead(ring, i, ring->staging + (size_t)i * PK_ASSET_URING_STAGING_SIZE, PK_ASSET_URING_STAGING_SIZE, 0ull, true);
+                SubmitClose(ring, i);
+                SubmitStat(ring, i);
+                entryCount += 4u;
+            }
+        }
+
+        if (SubmitAndWait(ring, entryCount) != 0)
+        {
+            for (auto i = 0u; i < count; ++i)
+            {
+                results[i] = -1;
+            }
+
+            return -1;
+        }
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            auto& slot = ring->slots[i];
+            auto isRead = slot.openResult >= 0 && slot.readResult >= 0 && slot.statResult == 0;
+            slot.stagedSize = isRead ? (uint32_t)slot.readResult : 0u;
+            results[i] = isRead ? BeginAssetLoad(ring->staging + (size_t)i * PK_ASSET_URING_STAGING_SIZE, slot.stagedSize, slot.stat.stx_size, loads[i]) : -1;
+        }
+
+        return 0;
+    }
+
+    int ReadAssetLoadsUring(PKAssetUring* ring, PKAssetLoad* const* loads, int* results, uint32_t first, uint32_t count)
+    {
+        if (ring == nullptr || first + count > PK_ASSET_URING_BATCH_SIZE)
+        {
+            return -1;
+        }
+
+        uint32_t remainingSizes[PK_ASSET_URING_BATCH_SIZE];
+        auto entryCount = 0u;
+
+        for (auto i = first; i < first + count; ++i)
+        {
+            auto& slot = ring->slots[i];
+            auto load = loads[i];
+            remainingSizes[i] = 0u;
+
+            if (results[i] != 0)
+            {
+                continue;
+            }
+
+            size_t readSize = 0ull;
+            auto destination = AllocateAssetLoad(load, &readSize);
+            auto payloadOffset = GetAssetPayloadOffset(load->header);
+            auto stagedSize = slot.stagedSize > payloadOffset ? slot.stagedSize - payloadOffset : 0ull;
+            auto copySize = stagedSize < readSize ? stagedSize : readSize;
+
+            // Files smaller than a staging slot were read completely by the begin submission.
+            if (destination == nullptr || (copySize < readSize && slot.stagedSize < PK_ASSET_URING_STAGING_SIZE))
+            {
+                CancelAssetLoad(load);
+                results[i] = -1;
+                continue;
+            }
+
+            memcpy(destination, ring->staging + (size_t)i * PK_ASSET_URING_STAGING_SIZE + payloadOffset, copySize);
+
+            if (copySize < readSize)
+            {
+                remainingSizes[i] = (uint32_t)(readSize - copySize);
+                slot.openResult = -ECANCELED;
+                slot.readResult = -ECANCELED;
+                SubmitOpen(ring, i);
+                SubmitRead(ring, i, destination + copySize, remainingSizes[i], payloadOffset + copySize, false);
+                SubmitClose(ring, i);
+                entryCount += 3u;
+            }
+        }
+
+        if (entryCount == 0u)
+        {
+            return 0;
+        }
+
+        auto result = SubmitAndWait(ring, entryCount);
+
+        for (auto i = first; i < first + count; ++i)
+        {
+            auto& slot = ring->slots[i];
+
+            if (remainingSizes[i] != 0u && (result != 0 || slot.openResult < 0 || slot.readResult != (int32_t)remainingSizes[i]))
+            {
+                CancelAssetLoad(loads[i]);
+                results[i] = -1;
+            }
+        }
+
+        return result;
+    }
+#else
+    PKAssetUring* CreateAssetUring()
+    {
+        return nullptr;
+    }
+
+    void DestroyAssetUring(PKAssetUring*)
+    {
+    }
+
+    int BeginAssetLoadsUring(PKAssetUring*, const char* const*, PKAssetLoad* const*, int* results, uint32_t count)
+    {
+        for (auto i = 0u; i < count; ++i)
+        {
+            results[i] = -1;
+        }
+
+        return -1;
+    }
+
+    int ReadAssetLoadsUring(PKAssetUring*, PKAssetLoad* const*, int*, uint32_t, uint32_t)
+    {
+        return -1;
+    }
+#endif
+}
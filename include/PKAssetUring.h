@@ -0,0 +1,24 @@
+#pragma once
+#include "PKAssetLoader.h"
+
+namespace PKAssets
+{
+    // Linux io_uring backend for batched loads. Only available when built with PK_ASSET_IO_URING.
+    constexpr static const uint32_t PK_ASSET_URING_BATCH_SIZE = 64u;
+    // Bytes read from the start of each file into registered buffers. Files that fit are opened, read & closed in a single submission.
+    constexpr static const uint32_t PK_ASSET_URING_STAGING_SIZE = 32768u;
+
+    struct PKAssetUring;
+
+    // Returns nullptr when io_uring is unavailable. Callers fall back to BeginAssetLoad & ReadAssetLoad.
+    // A ring is not thread safe & is meant to be owned by a single I/O thread.
+    PKAssetUring* CreateAssetUring();
+    void DestroyAssetUring(PKAssetUring* ring);
+
+    // Opens, stats & reads the head of up to PK_ASSET_URING_BATCH_SIZE files in one submission & begins their loads.
+    // Loads of a batch must be read before the next batch is begun. File paths must stay valid until then.
+    int BeginAssetLoadsUring(PKAssetUring* ring, const char* const* filepaths, PKAssetLoad* const* loads, int* results, uint32_t count);
+
+    // Allocates & reads loads [first, first + count) of the last begun batch in one submission. Loads that failed to begin are skipped & loads that fail to read are cancelled.
+    int ReadAssetLoadsUring(PKAssetUring* ring, PKAssetLoad* const* loads, int* results, uint32_t first, uint32_t count);
+}